@@ -42,7 +42,7 @@ DCResVoid dc_da_init(DCDynArr* darr, DCDynValFreeFn element_free_fn)
 
     darr->element_free_fn = element_free_fn;
 
-    darr->elements = malloc(DC_DA_INITIAL_CAP * sizeof(DCDynVal));
+    darr->elements = dc_alloc(DC_DA_INITIAL_CAP * sizeof(DCDynVal));
     if (darr->elements == NULL)
     {
         dc_dbg_log("Memory allocation failed");
@@ -70,7 +70,7 @@ DCResVoid dc_da_init2(DCDynArr* darr, usize capacity, usize capacity_grow_multip
 
     darr->element_free_fn = element_free_fn;
 
-    darr->elements = malloc(capacity * sizeof(DCDynVal));
+    darr->elements = dc_alloc(capacity * sizeof(DCDynVal));
 
     if (darr->elements == NULL)
     {
@@ -87,7 +87,7 @@ DCResDa dc_da_new(DCDynValFreeFn element_free_fn)
 {
     DC_RES_da();
 
-    DCDynArr* darr = malloc(sizeof(DCDynArr));
+    DCDynArr* darr = dc_alloc(sizeof(DCDynArr));
     if (darr == NULL)
     {
         dc_dbg_log("Memory allocation failed");
@@ -95,7 +95,7 @@ DCResDa dc_da_new(DCDynValFreeFn element_free_fn)
         dc_ret_e(2, "Memory allocation failed");
     }
 
-    dc_try_fail_temp(DCResVoid, dc_da_init(darr, element_free_fn));
+    dc_try_or_fail_with3(DCResVoid, res, dc_da_init(darr, element_free_fn), dc_dealloc(darr, sizeof(DCDynArr)));
 
     dc_ret_ok(darr);
 }
@@ -104,7 +104,7 @@ DCResDa dc_da_new2(usize capacity, usize capacity_grow_multiplier, DCDynValFreeF
 {
     DC_RES_da();
 
-    DCDynArr* darr = malloc(sizeof(DCDynArr));
+    DCDynArr* darr = dc_alloc(sizeof(DCDynArr));
     if (darr == NULL)
     {
         dc_dbg_log("Memory allocation failed");
@@ -112,7 +112,8 @@ DCResDa dc_da_new2(usize capacity, usize capacity_grow_multiplier, DCDynValFreeF
         dc_ret_e(2, "Memory allocation failed");
     }
 
-    dc_try_fail_temp(DCResVoid, dc_da_init2(darr, capacity, capacity_grow_multiplier, element_free_fn));
+    dc_try_or_fail_with3(DCResVoid, res, dc_da_init2(darr, capacity, capacity_grow_multiplier, element_free_fn),
+                         dc_dealloc(darr, sizeof(DCDynArr)));
 
     dc_ret_ok(darr);
 }
@@ -128,13 +129,13 @@ DCResVoid __dc_da_init_with_values(DCDynArr* darr, usize count, DCDynValFreeFn e
         dc_ret_e(1, "got NULL DCDynArr");
     }
 
-    darr->cap = count;
+    darr->cap = count == 0 ? DC_DA_INITIAL_CAP : count;
     darr->count = 0;
     darr->multiplier = DC_DA_CAP_MULTIPLIER;
 
     darr->element_free_fn = element_free_fn;
 
-    darr->elements = malloc((count == 0 ? DC_DA_INITIAL_CAP : count) * sizeof(DCDynVal));
+    darr->elements = dc_alloc(darr->cap * sizeof(DCDynVal));
     if (darr->elements == NULL)
     {
         dc_dbg_log("Memory allocation failed");
@@ -170,7 +171,8 @@ DCResVoid dc_da_grow(DCDynArr* darr)
 
     // Resize the array if needed (double the capacity by default or custom
     // multiplier of provided beforehand)
-    DCDynVal* resized = realloc(darr->elements, darr->cap * darr->multiplier * sizeof(DCDynVal));
+    DCDynVal* resized =
+        dc_resize(darr->elements, darr->cap * sizeof(DCDynVal), darr->cap * darr->multiplier * sizeof(DCDynVal));
     if (resized == NULL)
     {
         dc_dbg_log("Memory re-allocation failed");
@@ -195,7 +197,7 @@ DCResVoid dc_da_grow_by(DCDynArr* darr, usize amount)
         dc_ret_e(1, "got NULL DCDynArr");
     }
 
-    DCDynVal* resized = realloc(darr->elements, (darr->cap + amount) * sizeof(DCDynVal));
+    DCDynVal* resized = dc_resize(darr->elements, darr->cap * sizeof(DCDynVal), (darr->cap + amount) * sizeof(DCDynVal));
 
     if (resized == NULL)
     {
@@ -221,7 +223,7 @@ DCResVoid dc_da_grow_to(DCDynArr* darr, usize amount)
         dc_ret_e(1, "got NULL DCDynArr");
     }
 
-    DCDynVal* resized = realloc(darr->elements, amount * sizeof(DCDynVal));
+    DCDynVal* resized = dc_resize(darr->elements, darr->cap * sizeof(DCDynVal), amount * sizeof(DCDynVal));
 
     if (resized == NULL)
     {
@@ -247,9 +249,10 @@ DCResVoid dc_da_trunc(DCDynArr* darr)
         dc_ret_e(1, "got NULL DCDynArr");
     }
 
-    if (darr->count < darr->cap)
+    // an empty array keeps its capacity as resizing to zero bytes frees the elements
+    if (darr->count < darr->cap && darr->count != 0)
     {
-        DCDynVal* resized = realloc(darr->elements, darr->count * sizeof(DCDynVal));
+        DCDynVal* resized = dc_resize(darr->elements, darr->cap * sizeof(DCDynVal), darr->count * sizeof(DCDynVal));
 
         if (resized == NULL)
         {
@@ -489,7 +492,7 @@ DCResVoid dc_da_free(DCDynArr* darr)
         dc_try_fail_temp(DCResVoid, dc_dv_free(&darr->elements[i], darr->element_free_fn));
     }
 
-    free(darr->elements);
+    dc_dealloc(darr->elements, darr->cap * sizeof(DCDynVal));
 
     darr->elements = NULL;
     darr->cap = 0;
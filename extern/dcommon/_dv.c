@@ -160,20 +160,18 @@ DCResString dc_tostr_dv(DCDynVal* dv)
 
             DCHashTablePtr _ht = dc_dv_as(*dv, DCHashTablePtr);
             usize key_no = 0;
-            for (usize i = 0; i < _ht->cap; ++i)
-            {
-                DC_HT_GET_AND_DEF_CONTAINER_ROW(darr, *_ht, i);
 
-                dc_da_for(ht_pair_print, *darr, {
-                    dc_try_or_fail_with3(DCResString, pair, dc_tostr_dv(_it), {});
-                    dc_sappend(&result, "%s", dc_unwrap2(pair));
+            dc_ht_for(ht_pair_print, *_ht, {
+                DCDynVal pair_dv = dc_dv(DCPairPtr, _it);
 
-                    free(dc_unwrap2(pair));
+                dc_try_or_fail_with3(DCResString, pair, dc_tostr_dv(&pair_dv), {});
+                dc_sappend(&result, "%s", dc_unwrap2(pair));
 
-                    if (key_no < _ht->key_count - 1) dc_sappend(&result, "%s", ", ");
-                    ++key_no;
-                });
-            }
+                dc_sfree(dc_unwrap2(pair));
+
+                if (key_no < _ht->key_count - 1) dc_sappend(&result, "%s", ", ");
+                ++key_no;
+            });
 
             dc_sappend(&result, "%s", "}");
 
@@ -194,7 +192,7 @@ DCResString dc_tostr_dv(DCDynVal* dv)
                 dc_try_or_fail_with3(DCResString, item, dc_tostr_dv(_it), {});
                 dc_sappend(&result, "%s", dc_unwrap2(item));
 
-                free(dc_unwrap2(item));
+                dc_sfree(dc_unwrap2(item));
 
                 if (_idx < _darr->count - 1) dc_sappend(&result, "%s", ", ");
             });
@@ -208,12 +206,12 @@ DCResString dc_tostr_dv(DCDynVal* dv)
         {
             DCPairPtr _pair = dc_dv_as(*dv, DCPairPtr);
             dc_try_or_fail_with3(DCResString, first, dc_tostr_dv(&_pair->first), {});
-            dc_try_or_fail_with3(DCResString, second, dc_tostr_dv(&_pair->second), { free(dc_unwrap2(first)); });
+            dc_try_or_fail_with3(DCResString, second, dc_tostr_dv(&_pair->second), { dc_sfree(dc_unwrap2(first)); });
 
             dc_sappend(&result, "(%s, %s)", dc_unwrap2(first), dc_unwrap2(second));
 
-            free(dc_unwrap2(first));
-            free(dc_unwrap2(second));
+            dc_sfree(dc_unwrap2(first));
+            dc_sfree(dc_unwrap2(second));
 
             break;
         }
@@ -244,7 +242,7 @@ DCResVoid dc_dv_print(DCDynVal* dv)
 
     printf("%s", dc_unwrap2(res));
 
-    if (dc_unwrap2(res)) free(dc_unwrap2(res));
+    dc_sfree(dc_unwrap2(res));
 
     dc_ret();
 }
@@ -457,7 +455,7 @@ DCResVoid dc_dv_free(DCDynVal* element, DCDynValFreeFn custom_free_fn)
                 dc_try_fail(dc_dv_free(&_pair->first, custom_free_fn));
                 dc_try_fail(dc_dv_free(&_pair->second, custom_free_fn));
 
-                free(_pair);
+                dc_dealloc(_pair, sizeof(DCPair));
             }
 
             dc_dv_set(*element, DCPairPtr, NULL);
@@ -471,7 +469,7 @@ DCResVoid dc_dv_free(DCDynVal* element, DCDynValFreeFn custom_free_fn)
             {
                 dc_try_fail(dc_da_free(dc_dv_as(*element, DCDynArrPtr)));
 
-                free(dc_dv_as(*element, DCDynArrPtr));
+                dc_dealloc(dc_dv_as(*element, DCDynArrPtr), sizeof(DCDynArr));
             }
 
             dc_dv_set(*element, DCDynArrPtr, NULL);
@@ -485,7 +483,7 @@ DCResVoid dc_dv_free(DCDynVal* element, DCDynValFreeFn custom_free_fn)
             {
                 dc_try_fail(dc_ht_free(dc_dv_as(*element, DCHashTablePtr)));
 
-                free(dc_dv_as(*element, DCHashTablePtr));
+                dc_dealloc(dc_dv_as(*element, DCHashTablePtr), sizeof(DCHashTable));
             }
 
             dc_dv_set(*element, DCHashTablePtr, NULL);
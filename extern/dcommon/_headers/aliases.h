@@ -206,7 +206,7 @@ struct DCPair
 /**
  * Function pointer type as an acceptable hash function for an Hash Table
  */
-typedef DCResU32 (*DCHashFn)(DCDynVal*);
+typedef DCResU32 (*DCHashFn)(DCDynVal*, u64);
 
 /**
  * Key comparison function type for an Hash Table
@@ -219,20 +219,53 @@ typedef DCResBool (*DCKeyCompFn)(DCDynVal*, DCDynVal*);
 typedef DCResVoid (*DCHtPairFreeFn)(DCPair*);
 
 /**
- * A Hash Table with track of capacity and number of registered keys
+ * Entry of a pair in a Hash Table, `hash` is the result of the hash function for the key (with the seed of the table)
+ * so the index can be rebuilt without calling the hash function again
+ */
+typedef struct
+{
+    DCPair pair;
+    u32 hash;
+    b1 deleted;
+} DCHtEntry;
+
+/**
+ * An insertion ordered Hash Table, the pairs are stored densely in `entries` in the order they're
+ * inserted and `index` is an open addressing table of the positions of the entries
+ *
+ * Each slot of the index has a control byte that is either empty, deleted (a tombstone) or the 7 bit
+ * fingerprint of the hash of the key in the slot, lookups scan a group of control bytes
+ * at a time and only compare the keys whose fingerprints match
+ *
+ * The capacity of the index is always a power of two and the index is rebuilt (and grows if it needs to)
+ * when the entries reach 7/8 of the slots, deleted entries stay in place until then
+ * The entries grow on their own, so growing the index never moves the pairs and vice versa
  *
- * Container is a fixed (one time allocated) array of dynamic arrays which will
- * help in case any collision happen with different keys
+ * `hash_fn` gets `seed` (zero by default, see `dc_ht_reseed`) along with the key, so the hashes
+ * (and the keys that collide) can't be predicted without knowing the seed
+ *
+ * `flags` is not used by the hash table itself, it's left to the owner (e.g. the state of a garbage collector)
+ *
+ * NOTE: Pointers to the pairs (or values) are invalidated by the next insertion
  */
 struct DCHashTable
 {
-    DCDynArr* container;
+    DCHtEntry* entries;
+    usize entry_count;
+    usize entry_cap;
+
+    u32* index;
+    u8* ctrl;
     usize cap;
+
     usize key_count;
+    u64 seed;
 
     DCHashFn hash_fn;
     DCKeyCompFn key_cmp_fn;
     DCHtPairFreeFn pair_free_fn;
+
+    u8 flags;
 };
 
 // ***************************************************************************************
@@ -277,6 +310,30 @@ typedef struct
     DCCleanupFn cleanup_fn;
 } DCCleanupJob;
 
+// ***************************************************************************************
+// * ALLOCATOR TYPES
+// ***************************************************************************************
+
+/**
+ * Function pointer type for the allocators of the dynamic arrays and hash tables
+ *
+ * It allocates when `ptr` is NULL, frees `ptr` when `new_size` is 0 and resizes it otherwise
+ * `old_size` is the size `ptr` was allocated (or last resized) with, so allocators can do
+ * their own accounting without storing the sizes
+ *
+ * NOTE: It must return NULL on failure and leave `ptr` untouched
+ */
+typedef voidptr (*DCAllocFn)(voidptr ctx, voidptr ptr, usize old_size, usize new_size);
+
+/**
+ * Is an allocation function and its context (passed as the first argument)
+ */
+typedef struct
+{
+    DCAllocFn fn;
+    voidptr ctx;
+} DCAllocator;
+
 // ***************************************************************************************
 // * DCOMMON CUSTOM TYPES RESULT TYPE DECLARATIONS
 // ***************************************************************************************
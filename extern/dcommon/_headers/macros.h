@@ -413,6 +413,15 @@
 #define __dc_attribute(A)
 #endif
 
+/**
+ * `[MACRO]` Storage class of the globals that each thread has its own copy of
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define __dc_thread_local __declspec(thread)
+#else
+#define __dc_thread_local _Thread_local
+#endif
+
 #if defined(DC_WINDOWS)
 #define DC_BASE_PATH '\\'
 #else
@@ -437,7 +446,7 @@
         string __cmd_string = NULL;                                                                                            \
         dc_sprintf(&__cmd_string, __VA_ARGS__);                                                                                \
         OUT_VAL = system(__cmd_string);                                                                                        \
-        free(__cmd_string);                                                                                                    \
+        dc_sfree(__cmd_string);                                                                                                \
     } while (0)
 
 /**
@@ -531,10 +540,11 @@
 /**
  * `[MACRO]` Defines the main result variable (__dc_res) as DCRes and initiates it as
  * DC_RES_OK
+ *
+ * NOTE: The dynamic value is wider than the error, so the whole result is zeroed first, otherwise
+ * returning a copied error would copy the uninitialized rest of the value
  */
-#define DC_RES()                                                                                                               \
-    DCRes __dc_res;                                                                                                            \
-    __dc_res.status = DC_RES_OK
+#define DC_RES() DCRes __dc_res = {.status = DC_RES_OK}
 
 /**
  * `[MACRO]` Defines the main result variable (__dc_res) as the given result type and
@@ -701,13 +711,16 @@
  * initiates the error value with given error code (NUM), it also create
  * formatted string (allocated) and sets the error message
  *
- * NOTE: Allocates memory
+ * NOTE: Allocates memory, the message is allocated by the default allocator (not `dc_allocator`)
+ * as the result can be freed by `dc_result_free` anywhere, whichever allocator is set by then
  */
 #define dc_ea(NUM, ...)                                                                                                        \
     do                                                                                                                         \
     {                                                                                                                          \
         string __err = NULL;                                                                                                   \
+        DCAllocator __err_allocator = dc_allocator_set((DCAllocator){.fn = dc_default_alloc, .ctx = NULL});                    \
         dc_sprintf(&__err, __VA_ARGS__);                                                                                       \
+        dc_allocator_set(__err_allocator);                                                                                     \
         __dc_res.status = DC_RES_ERR;                                                                                          \
         __dc_res.data.e = (DCError){NUM, __err, 1};                                                                            \
     } while (0)
@@ -1596,10 +1609,48 @@
 // * HASH TABLE MACROS
 // ***************************************************************************************
 
+/**
+ * `[MACRO]` Number of control bytes that are probed at once
+ */
+#define DC_HT_GROUP_WIDTH 8
+
+/**
+ * `[MACRO]` Control byte of a slot that has never been used
+ */
+#define DC_HT_CTRL_EMPTY 0x80
+
+/**
+ * `[MACRO]` Control byte of a slot whose pair is deleted (a tombstone)
+ */
+#define DC_HT_CTRL_DELETED 0xFE
+
+/**
+ * `[MACRO]` Checks if the control byte belongs to a slot that holds a pair
+ */
+#define dc_ht_ctrl_is_full(CTRL) ((CTRL) < 0x80)
+
+/**
+ * `[MACRO]` Number of entries an index of the given capacity has room for (7/8 of the slots)
+ */
+#define dc_ht_max_entries(CAP) ((CAP) - (CAP) / 8)
+
+/**
+ * `[MACRO]` Size of the memory block that holds the slots (entry positions) and the control bytes of an index
+ * of the given capacity
+ *
+ * NOTE: The control bytes of the first group are repeated at the end, so a group can be read at any slot
+ */
+#define dc_ht_index_size(CAP) ((CAP) == 0 ? 0 : (CAP) * (sizeof(u32) + 1) + DC_HT_GROUP_WIDTH)
+
+/**
+ * `[MACRO]` Size of the memory that the hash table holds (the entries and the index)
+ */
+#define dc_ht_storage_size(HT) ((HT).entry_cap * sizeof(DCHtEntry) + dc_ht_index_size((HT).cap))
+
 /**
  * `[MACRO]` Expands to standard hash function declaration
  */
-#define DC_HT_HASH_FN_DECL(NAME) DCResU32 NAME(DCDynVal* _key)
+#define DC_HT_HASH_FN_DECL(NAME) DCResU32 NAME(DCDynVal* _key, u64 _seed)
 
 /**
  * `[MACRO]` Expands to standard hash key comparison function declaration
@@ -1611,6 +1662,14 @@
  */
 #define DC_HT_PAIR_FREE_FN_DECL(NAME) DCResVoid NAME(DCPair* _pair)
 
+/**
+ * `[MACRO]` Spreads the result of the hash function over all the bits before it picks a slot
+ *
+ * NOTE: It's not a replacement for seeding (the seed is given to the hash function), it only
+ * keeps the weak hashes (e.g. small integers) from crowding the same fingerprints
+ */
+#define dc_ht_spread_hash(HASH) ((u32)(((u64)(HASH) * 0x9E3779B97F4A7C15ULL) >> 32))
+
 /**
  * `[MACRO]` Gets the results of hash table's hash function for the given key
  *
@@ -1624,8 +1683,8 @@
     u32 VAR_NAME;                                                                                                              \
     do                                                                                                                         \
     {                                                                                                                          \
-        DCResU32 __hash_res = (HT).hash_fn((KEY));                                                                             \
-        VAR_NAME = (__hash_res.data.v) % (HT).cap;                                                                             \
+        DCResU32 __hash_res = (HT).hash_fn((KEY), (HT).seed);                                                                  \
+        VAR_NAME = __hash_res.data.v;                                                                                          \
     } while (0)
 
 /**
@@ -1639,9 +1698,9 @@
     u32 VAR_NAME;                                                                                                              \
     do                                                                                                                         \
     {                                                                                                                          \
-        __dc_res = (HT).hash_fn((KEY));                                                                                        \
+        __dc_res = (HT).hash_fn((KEY), (HT).seed);                                                                             \
         dc_fail_if_err2(__dc_res);                                                                                             \
-        VAR_NAME = (__dc_res.data.v) % (HT).cap;                                                                               \
+        VAR_NAME = __dc_res.data.v;                                                                                            \
     } while (0)
 
 /**
@@ -1655,18 +1714,37 @@
     u32 VAR_NAME;                                                                                                              \
     do                                                                                                                         \
     {                                                                                                                          \
-        DCResU32 __hash_res = (HT).hash_fn((KEY));                                                                             \
+        DCResU32 __hash_res = (HT).hash_fn((KEY), (HT).seed);                                                                  \
         dc_fail_if_err2(__hash_res);                                                                                           \
-        VAR_NAME = (__hash_res.data.v) % (HT).cap;                                                                             \
+        VAR_NAME = __hash_res.data.v;                                                                                          \
     } while (0)
 
 /**
- * `[MACRO]` Defines VAR_NAME as a pointer to the row of hash table container that the
- * hash indexes to
+ * `[MACRO]` Iterates over the pairs of the hash table in the order they're inserted
  *
- * NOTE: VAR_NAME would be DCDynArr*
+ * `_it` is the pointer to the current pair (DCPair*) and `_idx` is the position of its entry
  */
-#define DC_HT_GET_AND_DEF_CONTAINER_ROW(VAR_NAME, HT, HASH) DCDynArr* VAR_NAME = &((HT).container[HASH])
+#define dc_ht_for(LABEL, HT, ACTIONS)                                                                                          \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        usize _idx = 0;                                                                                                        \
+        DCHtEntry* __##LABEL##_entry = (HT).entries;                                                                           \
+        while (_idx < (HT).entry_count)                                                                                        \
+        {                                                                                                                      \
+            if (!__##LABEL##_entry->deleted)                                                                                   \
+            {                                                                                                                  \
+                DCPair* _it = &__##LABEL##_entry->pair;                                                                        \
+                do                                                                                                             \
+                {                                                                                                              \
+                    ACTIONS;                                                                                                   \
+                } while (0);                                                                                                   \
+            }                                                                                                                  \
+            ++_idx;                                                                                                            \
+            ++__##LABEL##_entry;                                                                                               \
+        }                                                                                                                      \
+        goto __##LABEL##_exit;                                                                                                 \
+        __##LABEL##_exit :;                                                                                                    \
+    } while (0)
 
 /**
  * `[MACRO]` Creates a literal hash table pair
@@ -1876,6 +1954,25 @@
  */
 #define dc_colorize_bg(BG_COLOR, TEXT) DC_BG_##BG_COLOR TEXT DC_COLOR_RESET
 
+// ***************************************************************************************
+// * ALLOCATION MACROS
+// ***************************************************************************************
+
+/**
+ * `[MACRO]` Allocates SIZE bytes using the `dc_allocator` of the current thread
+ */
+#define dc_alloc(SIZE) dc_allocator.fn(dc_allocator.ctx, NULL, 0, (SIZE))
+
+/**
+ * `[MACRO]` Resizes PTR (allocated with OLD_SIZE bytes) to NEW_SIZE bytes using the `dc_allocator` of the current thread
+ */
+#define dc_resize(PTR, OLD_SIZE, NEW_SIZE) dc_allocator.fn(dc_allocator.ctx, (PTR), (OLD_SIZE), (NEW_SIZE))
+
+/**
+ * `[MACRO]` Frees PTR (allocated with SIZE bytes) using the `dc_allocator` of the current thread
+ */
+#define dc_dealloc(PTR, SIZE) ((void)dc_allocator.fn(dc_allocator.ctx, (PTR), (SIZE), 0))
+
 // ***************************************************************************************
 // * CLEANUP MACROS
 // ***************************************************************************************
@@ -22,55 +22,307 @@
 
 #include "dcommon.h"
 
-DCResVoid dc_ht_init(DCHashTable* ht, usize capacity, DCHashFn hash_fn, DCKeyCompFn key_cmp_fn, DCHtPairFreeFn pair_free_fn)
+#define HT_LSBS 0x0101010101010101ULL
+#define HT_MSBS 0x8080808080808080ULL
+
+/**
+ * The low bits of the hash pick the first slot to probe and the top 7 bits are the fingerprint
+ */
+#define ht_h2(HASH) ((u8)((HASH) >> 25))
+
+// ***************************************************************************************
+// * GROUP OPERATIONS
+// *    A group is DC_HT_GROUP_WIDTH control bytes packed in an u64, one byte for each slot
+// *    the operations return masks with the high bit of the byte set for the matching slots
+// ***************************************************************************************
+
+static inline u64 ht_group_load(const u8* ctrl)
 {
-    DC_RES_void();
+    u64 group = 0;
 
-    if (!ht)
+    for (usize i = 0; i < DC_HT_GROUP_WIDTH; ++i)
+        group |= (u64)ctrl[i] << (i * 8);
+
+    return group;
+}
+
+/**
+ * Slots with the given fingerprint
+ *
+ * NOTE: It might have false positives (never false negatives), the keys are compared anyway
+ */
+static inline u64 ht_group_match(u64 group, u8 h2)
+{
+    u64 x = group ^ (HT_LSBS * h2);
+
+    return (x - HT_LSBS) & ~x & HT_MSBS;
+}
+
+static inline u64 ht_group_match_empty(u64 group)
+{
+    return group & (~group << 6) & HT_MSBS;
+}
+
+static inline u64 ht_group_match_empty_or_deleted(u64 group)
+{
+    return group & HT_MSBS;
+}
+
+/**
+ * Offset of the first matching slot in the mask
+ */
+static inline usize ht_mask_first(u64 mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (usize)__builtin_ctzll(mask) >> 3;
+#else
+    usize offset = 0;
+
+    while ((mask & 0x80) == 0)
     {
-        dc_dbg_log("got NULL DCHashTable");
+        mask >>= 8;
+        ++offset;
+    }
 
-        dc_ret_e(1, "got NULL DCHashTable");
+    return offset;
+#endif
+}
+
+// ***************************************************************************************
+// * PRIVATE FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Smallest capacity (a power of two) that has room for count pairs
+ */
+static usize ht_capacity_for(usize count)
+{
+    usize cap = DC_HT_GROUP_WIDTH;
+
+    while (dc_ht_max_entries(cap) < count)
+        cap *= 2;
+
+    return cap;
+}
+
+static inline void ht_set_ctrl(DCHashTable* ht, usize slot, u8 ctrl)
+{
+    ht->ctrl[slot] = ctrl;
+
+    // the first group is repeated at the end
+    if (slot < DC_HT_GROUP_WIDTH) ht->ctrl[ht->cap + slot] = ctrl;
+}
+
+/**
+ * Probes the groups starting from the slot the spread hash points to (triangular probing),
+ * returns the slot of the key or the capacity if the key doesn't exist
+ *
+ * NOTE: If `out_insert` is provided it gets the first empty or deleted slot of the same probe
+ * sequence (the capacity if there is none), so the key can be inserted without probing again
+ */
+static DCResUsize ht_find_slot(DCHashTable* ht, DCDynVal* key, u32 raw_hash, usize* out_insert)
+{
+    DC_RES_usize();
+
+    if (out_insert) *out_insert = ht->cap;
+
+    if (ht->cap == 0) dc_ret_ok(0);
+
+    u32 hash = dc_ht_spread_hash(raw_hash);
+    usize mask = ht->cap - 1;
+    usize pos = hash & mask;
+    u8 h2 = ht_h2(hash);
+
+    for (usize step = 0; step <= ht->cap; step += DC_HT_GROUP_WIDTH, pos = (pos + step) & mask)
+    {
+        u64 group = ht_group_load(&ht->ctrl[pos]);
+
+        for (u64 match = ht_group_match(group, h2); match != 0; match &= match - 1)
+        {
+            usize slot = (pos + ht_mask_first(match)) & mask;
+            DCHtEntry* entry = &ht->entries[ht->index[slot]];
+
+            // the keys are only compared when the whole hashes are the same
+            if (entry->hash != raw_hash) continue;
+
+            DCResBool cmp_res = ht->key_cmp_fn(&entry->pair.first, key);
+            dc_fail_if_err2(cmp_res);
+
+            if (dc_unwrap2(cmp_res)) dc_ret_ok(slot);
+        }
+
+        u64 available = ht_group_match_empty_or_deleted(group);
+        if (out_insert && *out_insert == ht->cap && available != 0) *out_insert = (pos + ht_mask_first(available)) & mask;
+
+        // the key would have been inserted in the empty slot
+        if (ht_group_match_empty(group) != 0) break;
+    }
+
+    dc_ret_ok(ht->cap);
+}
+
+/**
+ * First empty or deleted slot in the probe sequence of the spread hash
+ *
+ * NOTE: There is always one as the hash table never gets full
+ */
+static usize ht_find_insert_slot(DCHashTable* ht, u32 hash)
+{
+    usize mask = ht->cap - 1;
+    usize pos = hash & mask;
+
+    for (usize step = 0;; step += DC_HT_GROUP_WIDTH, pos = (pos + step) & mask)
+    {
+        u64 available = ht_group_match_empty_or_deleted(ht_group_load(&ht->ctrl[pos]));
+
+        if (available != 0) return (pos + ht_mask_first(available)) & mask;
     }
+}
 
-    ht->container = (DCDynArr*)calloc(capacity, sizeof(DCDynArr));
+/**
+ * Rebuilds the index with the given capacity, the deleted entries are dropped (the order of the others is kept)
+ * and the tombstones are gone as well
+ *
+ * NOTE: The entries keep their hashes, so the hash function is not called
+ */
+static DCResVoid ht_resize(DCHashTable* ht, usize new_cap)
+{
+    DC_RES_void();
 
-    if (ht->container == NULL)
+    u32* index = (u32*)dc_alloc(dc_ht_index_size(new_cap));
+    if (index == NULL)
     {
         dc_dbg_log("Memory allocation failed");
 
         dc_ret_e(2, "Memory allocation failed");
     }
 
-    ht->cap = capacity;
-    ht->key_count = 0;
+    if (ht->index) dc_dealloc(ht->index, dc_ht_index_size(ht->cap));
 
-    ht->hash_fn = hash_fn;
-    ht->key_cmp_fn = key_cmp_fn;
-    ht->pair_free_fn = pair_free_fn;
+    ht->index = index;
+    ht->ctrl = (u8*)(index + new_cap);
+    ht->cap = new_cap;
+
+    memset(ht->ctrl, DC_HT_CTRL_EMPTY, new_cap + DC_HT_GROUP_WIDTH);
+
+    usize count = 0;
+
+    for (usize i = 0; i < ht->entry_count; ++i)
+    {
+        if (ht->entries[i].deleted) continue;
+
+        if (count != i) ht->entries[count] = ht->entries[i];
+
+        u32 hash = dc_ht_spread_hash(ht->entries[count].hash);
+        usize slot = ht_find_insert_slot(ht, hash);
+
+        ht_set_ctrl(ht, slot, ht_h2(hash));
+        ht->index[slot] = (u32)count;
+
+        ++count;
+    }
+
+    ht->entry_count = count;
 
     dc_ret();
 }
 
-DCResHt dc_ht_new(usize capacity, DCHashFn hash_fn, DCKeyCompFn key_cmp_fn, DCHtPairFreeFn pair_free_fn)
+/**
+ * Hashes the keys of the first `count` entries again with the seed of the hash table,
+ * it brings back the hashes the index is built with after a failed reseed
+ *
+ * NOTE: The keys have been hashed with the seed before, so hashing them can't fail
+ */
+static void ht_restore_hashes(DCHashTable* ht, usize count)
 {
-    DC_RES_ht();
+    for (usize i = 0; i < count; ++i)
+    {
+        if (ht->entries[i].deleted) continue;
 
-    DCHashTable* ht = (DCHashTable*)malloc(sizeof(DCHashTable));
+        dc_ht_get_hash(hash, *ht, &ht->entries[i].pair.first);
+        ht->entries[i].hash = hash;
+    }
+}
 
-    if (ht == NULL)
+/**
+ * Makes room in the index for one more entry, the deleted entries are cleaned up in place (without growing)
+ * if the pairs take no more than 25/32 of the slots, so there is room for at least 3/32 of the
+ * capacity of new pairs before the next rebuild
+ */
+static DCResVoid ht_reserve_one(DCHashTable* ht)
+{
+    if (ht->cap == 0) return ht_resize(ht, DC_HT_GROUP_WIDTH);
+
+    if (ht->key_count * 32 <= ht->cap * 25) return ht_resize(ht, ht->cap);
+
+    return ht_resize(ht, ht->cap * 2);
+}
+
+/**
+ * Grows the entries by half (up to what the index has room for), the pairs don't move
+ * within the entries so the index stays valid
+ */
+static DCResVoid ht_grow_entries(DCHashTable* ht)
+{
+    DC_RES_void();
+
+    usize new_cap = ht->entry_cap < DC_HT_GROUP_WIDTH ? DC_HT_GROUP_WIDTH : ht->entry_cap + ht->entry_cap / 2;
+    if (new_cap > dc_ht_max_entries(ht->cap)) new_cap = dc_ht_max_entries(ht->cap);
+
+    DCHtEntry* entries =
+        (DCHtEntry*)dc_resize(ht->entries, ht->entry_cap * sizeof(DCHtEntry), new_cap * sizeof(DCHtEntry));
+    if (entries == NULL)
     {
         dc_dbg_log("Memory allocation failed");
 
         dc_ret_e(2, "Memory allocation failed");
     }
 
-    dc_try_fail_temp(DCResVoid, dc_ht_init(ht, capacity, hash_fn, key_cmp_fn, pair_free_fn));
+    ht->entries = entries;
+    ht->entry_cap = new_cap;
 
-    dc_ret_ok(ht);
+    dc_ret();
 }
 
-DCResVoid dc_ht_free(DCHashTable* ht)
+/**
+ * Appends a new entry for the key (the value is null) and takes the slot that is found by `ht_find_slot` for it,
+ * if the index needs to be rebuilt first the slot is looked up again
+ *
+ * @return the entry that the key has been inserted to or error
+ */
+static DCResUsize ht_insert_at(DCHashTable* ht, usize slot, u32 raw_hash, DCDynVal key)
+{
+    DC_RES_usize();
+
+    u32 hash = dc_ht_spread_hash(raw_hash);
+
+    // deleted entries are not reused, they're dropped when the index is rebuilt
+    if (slot >= ht->cap || ht->entry_count == dc_ht_max_entries(ht->cap))
+    {
+        dc_try_fail_temp(DCResVoid, ht_reserve_one(ht));
+
+        slot = ht_find_insert_slot(ht, hash);
+    }
+
+    if (ht->entry_count == ht->entry_cap) dc_try_fail_temp(DCResVoid, ht_grow_entries(ht));
+
+    usize entry = ht->entry_count++;
+
+    ht->entries[entry] = (DCHtEntry){.pair = {key, dc_dv_nullptr()}, .hash = raw_hash, .deleted = false};
+
+    ht_set_ctrl(ht, slot, ht_h2(hash));
+    ht->index[slot] = (u32)entry;
+
+    ht->key_count++;
+
+    dc_ret_ok(entry);
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+DCResVoid dc_ht_init(DCHashTable* ht, usize capacity, DCHashFn hash_fn, DCKeyCompFn key_cmp_fn, DCHtPairFreeFn pair_free_fn)
 {
     DC_RES_void();
 
@@ -81,36 +333,52 @@ DCResVoid dc_ht_free(DCHashTable* ht)
         dc_ret_e(1, "got NULL DCHashTable");
     }
 
-    if (ht && ht->cap == 0) dc_ret();
+    *ht = (DCHashTable){0};
 
-    for (usize i = 0; i < ht->cap; ++i)
-    {
-        DC_HT_GET_AND_DEF_CONTAINER_ROW(darr, *ht, i);
+    ht->hash_fn = hash_fn;
+    ht->key_cmp_fn = key_cmp_fn;
+    ht->pair_free_fn = pair_free_fn;
 
-        dc_da_for(ht_element_free_loop, *darr, {
-            if (ht->pair_free_fn) dc_try_fail(ht->pair_free_fn(dc_dv_as(*_it, DCPairPtr)));
+    dc_try_fail(ht_resize(ht, ht_capacity_for(capacity)));
 
-            if (dc_dv_is_allocated(*_it) && dc_dv_as(*_it, DCPairPtr) != NULL) free(dc_dv_as(*_it, DCPairPtr));
-        });
+    if (capacity == 0) dc_ret();
 
-        free(darr->elements);
-        darr->elements = NULL;
-        darr->cap = 0;
-        darr->count = 0;
-    }
+    ht->entries = (DCHtEntry*)dc_alloc(capacity * sizeof(DCHtEntry));
+    if (ht->entries == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
 
-    free(ht->container);
+        dc_dealloc(ht->index, dc_ht_index_size(ht->cap));
+        *ht = (DCHashTable){0};
 
-    ht->cap = 0;
-    ht->key_count = 0;
-    ht->hash_fn = NULL;
-    ht->key_cmp_fn = NULL;
-    ht->pair_free_fn = NULL;
+        dc_ret_e(2, "Memory allocation failed");
+    }
+
+    ht->entry_cap = capacity;
 
     dc_ret();
 }
 
-DCResVoid __dc_ht_free(voidptr ht)
+DCResHt dc_ht_new(usize capacity, DCHashFn hash_fn, DCKeyCompFn key_cmp_fn, DCHtPairFreeFn pair_free_fn)
+{
+    DC_RES_ht();
+
+    DCHashTable* ht = (DCHashTable*)dc_alloc(sizeof(DCHashTable));
+
+    if (ht == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(2, "Memory allocation failed");
+    }
+
+    dc_try_or_fail_with3(DCResVoid, res, dc_ht_init(ht, capacity, hash_fn, key_cmp_fn, pair_free_fn),
+                         dc_dealloc(ht, sizeof(DCHashTable)));
+
+    dc_ret_ok(ht);
+}
+
+DCResVoid dc_ht_free(DCHashTable* ht)
 {
     DC_RES_void();
 
@@ -121,14 +389,21 @@ DCResVoid __dc_ht_free(voidptr ht)
         dc_ret_e(1, "got NULL DCHashTable");
     }
 
-    dc_try_fail(dc_ht_free((DCHashTable*)ht));
+    if (ht && ht->cap == 0) dc_ret();
+
+    if (ht->pair_free_fn) dc_ht_for(ht_element_free_loop, *ht, { dc_try_fail(ht->pair_free_fn(_it)); });
+
+    if (ht->entries) dc_dealloc(ht->entries, ht->entry_cap * sizeof(DCHtEntry));
+    dc_dealloc(ht->index, dc_ht_index_size(ht->cap));
+
+    *ht = (DCHashTable){0};
 
     dc_ret();
 }
 
-DCResUsize dc_ht_find_by_key(DCHashTable* ht, DCDynVal key, DCDynVal** out_result)
+DCResVoid dc_ht_reseed(DCHashTable* ht, u64 seed)
 {
-    DC_RES_usize();
+    DC_RES_void();
 
     if (!ht)
     {
@@ -137,35 +412,38 @@ DCResUsize dc_ht_find_by_key(DCHashTable* ht, DCDynVal key, DCDynVal** out_resul
         dc_ret_e(1, "got NULL DCHashTable");
     }
 
-    dc_try_fail_temp_ht_get_hash(_index, *ht, &key);
+    u64 previous = ht->seed;
+    ht->seed = seed;
 
-    DC_HT_GET_AND_DEF_CONTAINER_ROW(darr, *ht, _index);
+    if (ht->key_count == 0) dc_ret();
+
+    for (usize i = 0; i < ht->entry_count; ++i)
+    {
+        if (ht->entries[i].deleted) continue;
 
-    dc_da_for(ht_search_loop, *darr, {
-        if (_it->type != dc_dvt(DCPairPtr))
+        DCResU32 hash_res = ht->hash_fn(&ht->entries[i].pair.first, seed);
+        if (dc_is_err2(hash_res))
         {
-            dc_dbg_log("wrong type, DCPairPtr needed");
+            dc_dbg_log("failed to hash the keys with the new seed");
 
-            dc_ret_e(3, "wrong type, DCPairPtr needed");
-        }
+            ht->seed = previous;
+            ht_restore_hashes(ht, i);
 
-        DCDynVal element_key = dc_dv_as(*_it, DCPairPtr)->first;
+            dc_fail_if_err2(hash_res);
+        }
 
-        DCResBool cmp_res = ht->key_cmp_fn(&element_key, &key);
-        dc_fail_if_err2(cmp_res);
+        ht->entries[i].hash = dc_unwrap2(hash_res);
+    }
 
-        if (dc_unwrap2(cmp_res))
-        {
-            *out_result = &(dc_dv_as(*_it, DCPairPtr))->second;
-            dc_ret_ok(_idx);
-        }
+    dc_try_or_fail_with3(DCResVoid, res, ht_resize(ht, ht->cap), {
+        ht->seed = previous;
+        ht_restore_hashes(ht, ht->entry_count);
     });
 
-    *out_result = NULL;
-    dc_ret_ok(0);
+    dc_ret();
 }
 
-DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSetStatus set_status)
+DCResVoid __dc_ht_free(voidptr ht)
 {
     DC_RES_void();
 
@@ -176,63 +454,59 @@ DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSe
         dc_ret_e(1, "got NULL DCHashTable");
     }
 
-    dc_try_fail_temp_ht_get_hash(_index, *ht, &key);
+    dc_try_fail(dc_ht_free((DCHashTable*)ht));
+
+    dc_ret();
+}
+
+DCResUsize dc_ht_find_by_key(DCHashTable* ht, DCDynVal key, DCDynVal** out_result)
+{
+    DC_RES_usize();
 
-    DCPair* new_pair = (DCPair*)malloc(sizeof(DCPair));
-    if (new_pair == NULL)
+    if (!ht)
     {
-        dc_dbg_log("Memory allocation failed");
+        dc_dbg_log("got NULL DCHashTable");
 
-        dc_ret_e(2, "Memory allocation failed");
+        dc_ret_e(1, "got NULL DCHashTable");
     }
 
-    new_pair->first = key;
-    new_pair->second = value;
+    dc_try_fail_temp_ht_get_hash(hash, *ht, &key);
 
-    DC_HT_GET_AND_DEF_CONTAINER_ROW(current_row, *ht, _index);
+    dc_try_or_fail_with3(DCResUsize, slot_res, ht_find_slot(ht, &key, hash, NULL), {});
 
-    // The row has not been initialized before
-    // So the key definitely does not exist
-    if (current_row->cap == 0)
+    usize slot = dc_unwrap2(slot_res);
+
+    if (slot >= ht->cap)
     {
-        // We can only create the key when the set status is one of
-        //  - DC_HT_SET_CREATE_OR_UPDATE
-        //  - DC_HT_SET_CREATE_OR_NOTHING
-        //  - DC_HT_SET_CREATE_OR_FAIL
-        if (set_status == DC_HT_SET_CREATE_OR_UPDATE || set_status == DC_HT_SET_CREATE_OR_NOTHING ||
-            set_status == DC_HT_SET_CREATE_OR_FAIL)
-        {
-            dc_try_fail(dc_da_init(current_row, NULL));
-            dc_try_fail(dc_da_push(current_row, dc_dva(DCPairPtr, new_pair)));
+        *out_result = NULL;
+        dc_ret_ok(ht->entry_count);
+    }
 
-            ht->key_count++;
+    *out_result = &ht->entries[ht->index[slot]].pair.second;
 
-            dc_ret();
-        }
+    dc_ret_ok(ht->index[slot]);
+}
 
-        // Otherwise it's one of the following:
-        //  - DC_HT_SET_UPDATE_OR_FAIL
-        //  - DC_HT_SET_UPDATE_OR_NOTHING
-        // That indicates user assumes key must already exist
-        // First we need to free the allocated pair
-        free(new_pair);
+DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSetStatus set_status)
+{
+    DC_RES_void();
 
-        // And if it's DC_HT_SET_UPDATE_OR_FAIL we need to return an error
-        if (set_status == DC_HT_SET_UPDATE_OR_FAIL)
-            dc_ret_e(dc_e_code(HT_SET), "can only update existing hash table pair, provided key not found");
+    if (!ht)
+    {
+        dc_dbg_log("got NULL DCHashTable");
 
-        // Otherwise just return ok
-        dc_ret();
+        dc_ret_e(1, "got NULL DCHashTable");
     }
 
-    DCDynVal* existed = NULL;
-    DCResUsize find_res = dc_ht_find_by_key(ht, key, &existed);
-    dc_fail_if_err2(find_res);
+    dc_try_fail_temp_ht_get_hash(hash, *ht, &key);
 
-    usize existed_index = dc_unwrap2(find_res);
+    usize insert_slot;
+    dc_try_or_fail_with3(DCResUsize, slot_res, ht_find_slot(ht, &key, hash, &insert_slot), {});
 
-    // key does exists in the row
-    if (existed != NULL)
+    usize slot = dc_unwrap2(slot_res);
+
+    // key does exists
+    if (slot < ht->cap)
     {
         // We can only update the key when the set status is one of
         //  - DC_HT_SET_CREATE_OR_UPDATE
@@ -241,13 +515,13 @@ DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSe
         if (set_status == DC_HT_SET_CREATE_OR_UPDATE || set_status == DC_HT_SET_UPDATE_OR_NOTHING ||
             set_status == DC_HT_SET_UPDATE_OR_FAIL)
         {
-            DCPair* old_pair = dc_dv_as(current_row->elements[existed_index], DCPairPtr);
+            // the pair keeps its place in the order
+            DCPair* old_pair = &ht->entries[ht->index[slot]].pair;
 
             if (ht->pair_free_fn) dc_try_fail(ht->pair_free_fn(old_pair));
 
-            free(old_pair);
-
-            current_row->elements[existed_index] = dc_dva(DCPairPtr, new_pair);
+            old_pair->first = key;
+            old_pair->second = value;
 
             dc_ret();
         }
@@ -256,9 +530,6 @@ DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSe
         //  - DC_HT_SET_CREATE_OR_FAIL
         //  - DC_HT_SET_CREATE_OR_NOTHING
         // That indicates user assumes key must not exist beforehand
-        // First we need to free the allocated pair
-        free(new_pair);
-
         // And if it's DC_HT_SET_CREATE_OR_FAIL we need to return an error
         if (set_status == DC_HT_SET_CREATE_OR_FAIL)
             dc_ret_e(dc_e_code(HT_SET), "can only create hash table pair, provided key already exists");
@@ -267,7 +538,7 @@ DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSe
         dc_ret();
     }
 
-    // And at last key does not exists in the row
+    // And at last key does not exists
     // We can only create the key when the set status is one of
     //  - DC_HT_SET_CREATE_OR_UPDATE
     //  - DC_HT_SET_CREATE_OR_NOTHING
@@ -275,8 +546,9 @@ DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSe
     if (set_status == DC_HT_SET_CREATE_OR_UPDATE || set_status == DC_HT_SET_CREATE_OR_NOTHING ||
         set_status == DC_HT_SET_CREATE_OR_FAIL)
     {
-        dc_try_fail(dc_da_push(current_row, dc_dva(DCPairPtr, new_pair)));
-        ht->key_count++;
+        dc_try_or_fail_with3(DCResUsize, insert_res, ht_insert_at(ht, insert_slot, hash, key), {});
+
+        ht->entries[dc_unwrap2(insert_res)].pair.second = value;
 
         dc_ret();
     }
@@ -285,9 +557,6 @@ DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSe
     //  - DC_HT_SET_UPDATE_OR_FAIL
     //  - DC_HT_SET_UPDATE_OR_NOTHING
     // That indicates user assumes key must exists
-    // First we need to free the allocated pair
-    free(new_pair);
-
     // And if it's DC_HT_SET_UPDATE_OR_FAIL we need to return an error
     if (set_status == DC_HT_SET_UPDATE_OR_FAIL)
         dc_ret_e(dc_e_code(HT_SET), "can only update existing hash table pair, provided key not found");
@@ -296,6 +565,38 @@ DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSe
     dc_ret();
 }
 
+DCResBool dc_ht_entry(DCHashTable* ht, DCDynVal key, DCPair** out_pair)
+{
+    DC_RES_bool();
+
+    if (!ht)
+    {
+        dc_dbg_log("got NULL DCHashTable");
+
+        dc_ret_e(1, "got NULL DCHashTable");
+    }
+
+    dc_try_fail_temp_ht_get_hash(hash, *ht, &key);
+
+    usize insert_slot;
+    dc_try_or_fail_with3(DCResUsize, slot_res, ht_find_slot(ht, &key, hash, &insert_slot), {});
+
+    usize slot = dc_unwrap2(slot_res);
+
+    if (slot < ht->cap)
+    {
+        *out_pair = &ht->entries[ht->index[slot]].pair;
+
+        dc_ret_ok(false);
+    }
+
+    dc_try_or_fail_with3(DCResUsize, insert_res, ht_insert_at(ht, insert_slot, hash, key), {});
+
+    *out_pair = &ht->entries[dc_unwrap2(insert_res)].pair;
+
+    dc_ret_ok(true);
+}
+
 DCResVoid __dc_ht_set_multiple(DCHashTable* ht, usize count, DCPair entries[], DCHashTableSetStatus set_status)
 {
     DC_RES_void();
@@ -326,17 +627,7 @@ DCResVoid dc_ht_merge(DCHashTable* ht, DCHashTable* from, DCHashTableSetStatus s
         dc_ret_e(1, "got NULL DCHashTable");
     }
 
-    for (usize i = 0; i < from->cap; ++i)
-    {
-        if (from->container[i].cap == 0) continue;
-
-        for (usize j = 0; j < from->container[i].count; ++j)
-        {
-            DCPair* pair = dc_da_get_as(from->container[i], j, DCPairPtr);
-
-            dc_try_fail(dc_ht_set(ht, pair->first, pair->second, set_status));
-        }
-    }
+    dc_ht_for(ht_merge_loop, *from, { dc_try_fail(dc_ht_set(ht, _it->first, _it->second, set_status)); });
 
     dc_ret();
 }
@@ -345,25 +636,29 @@ DCResBool dc_ht_delete(DCHashTable* ht, DCDynVal key)
 {
     DC_RES_bool();
 
-    dc_try_fail_temp_ht_get_hash(_index, *ht, &key);
+    if (!ht)
+    {
+        dc_dbg_log("got NULL DCHashTable");
 
-    DC_HT_GET_AND_DEF_CONTAINER_ROW(current_row, *ht, _index);
+        dc_ret_e(1, "got NULL DCHashTable");
+    }
 
-    if (current_row->count == 0) dc_ret_ok(false);
+    dc_try_fail_temp_ht_get_hash(hash, *ht, &key);
 
-    DCDynVal* existed = NULL;
-    DCResUsize possible_bucket = dc_ht_find_by_key(ht, key, &existed);
-    dc_fail_if_err2(possible_bucket);
+    dc_try_or_fail_with3(DCResUsize, slot_res, ht_find_slot(ht, &key, hash, NULL), {});
 
-    usize existed_index = dc_unwrap2(possible_bucket);
+    usize slot = dc_unwrap2(slot_res);
 
-    if (existed == NULL) dc_ret_ok(false);
+    if (slot >= ht->cap) dc_ret_ok(false);
 
-    DCPair* old_pair = dc_dv_as(current_row->elements[existed_index], DCPairPtr);
+    DCHtEntry* entry = &ht->entries[ht->index[slot]];
 
-    if (ht->pair_free_fn) dc_try_fail_temp(DCResVoid, ht->pair_free_fn(old_pair));
+    if (ht->pair_free_fn) dc_try_fail_temp(DCResVoid, ht->pair_free_fn(&entry->pair));
 
-    dc_try_fail_temp(DCResVoid, dc_da_delete(current_row, existed_index));
+    // the probe sequences of other keys might go through this slot, so it's left as a tombstone
+    // and the entry is left in place as well so the order of the others is kept
+    ht_set_ctrl(ht, slot, DC_HT_CTRL_DELETED);
+    entry->deleted = true;
     ht->key_count--;
 
     dc_ret_ok(true);
@@ -382,7 +677,7 @@ DCResUsize dc_ht_keys(DCHashTable* ht, DCDynVal** out_arr)
 
     if (!out_arr) dc_ret_e(1, "got NULL pout_arr");
 
-    *out_arr = (DCDynVal*)malloc((ht->key_count + 1) * sizeof(DCDynVal));
+    *out_arr = (DCDynVal*)dc_alloc((ht->key_count + 1) * sizeof(DCDynVal));
     if (!(*out_arr))
     {
         dc_dbg_log("Memory allocation failed");
@@ -391,28 +686,11 @@ DCResUsize dc_ht_keys(DCHashTable* ht, DCDynVal** out_arr)
     }
 
     usize key_count = 0;
-    for (usize i = 0; i < ht->cap; ++i)
-    {
-        DC_HT_GET_AND_DEF_CONTAINER_ROW(darr, *ht, i);
-
-        if (darr->cap == 0) continue;
-
-        dc_da_for(ht_key_extraction_loop, *darr, {
-            if (_it->type != dc_dvt(DCPairPtr))
-            {
-                free(*out_arr);
-                *out_arr = NULL;
-                dc_dbg_log("Bad type, DCHashTable elements must be of type DCPairPtr");
-
-                dc_ret_e(3, "Bad type, DCHashTable elements must be of type DCPairPtr");
-            }
 
-            DCDynVal element_key = dc_dv_as(*_it, DCPairPtr)->first;
-
-            (*out_arr)[key_count] = element_key;
-            key_count++;
-        });
-    }
+    dc_ht_for(ht_key_extraction_loop, *ht, {
+        (*out_arr)[key_count] = _it->first;
+        key_count++;
+    });
 
     (*out_arr)[ht->key_count] = dc_dv_nullptr();
     dc_ret_ok(ht->key_count);
@@ -63,7 +63,7 @@ DCResUsize dc_sprintf(string* str, string fmt, ...)
     va_end(argp);
 
     // Allocate memory for the new string
-    *str = malloc(len + 1);
+    *str = (string)dc_alloc(len + 1);
     if (!*str)
     {
         dc_dbg_log("Couldn't allocate %i chars.", len + 1);
@@ -107,7 +107,7 @@ DCResUsize dc_sappend(string* str, const string fmt, ...)
     size_t current_len = *str ? strlen(*str) : 0;
 
     // Allocate memory for the new string (old length + new formatted part)
-    string new_str = realloc(*str, current_len + len + 1);
+    string new_str = (string)dc_resize(*str, *str ? current_len + 1 : 0, current_len + len + 1);
     if (!new_str)
     {
         dc_dbg_log("Couldn't allocate %i chars.", len + 1);
@@ -143,6 +143,11 @@ DCResString dc_strdup(const string in)
     dc_ret_ok(out);
 }
 
+void dc_sfree(string str)
+{
+    if (str) dc_dealloc(str, strlen(str) + 1);
+}
+
 DCResVoid dc_normalize_path_to_posix(string path)
 {
     DC_RES_void();
@@ -565,6 +570,34 @@ DCResVoid dc_result_free(voidptr res_ptr)
     dc_ret();
 }
 
+// ***************************************************************************************
+// * ALLOCATOR
+// ***************************************************************************************
+
+voidptr dc_default_alloc(voidptr ctx, voidptr ptr, usize old_size, usize new_size)
+{
+    (void)ctx;
+    (void)old_size;
+
+    if (new_size == 0)
+    {
+        free(ptr);
+
+        return NULL;
+    }
+
+    return realloc(ptr, new_size);
+}
+
+DCAllocator dc_allocator_set(DCAllocator allocator)
+{
+    DCAllocator previous = dc_allocator;
+
+    dc_allocator = allocator;
+
+    return previous;
+}
+
 // ***************************************************************************************
 // * Files
 // ***************************************************************************************
@@ -630,7 +663,7 @@ void dc_error_logs_init(string filename, b1 append)
     const string mode = append ? "a" : "w";
 
     dc_try(dc_file_open(_filename, mode));
-    free(_filename);
+    dc_sfree(_filename);
 
     if (dc_is_err())
     {
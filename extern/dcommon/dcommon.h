@@ -663,13 +663,14 @@ DCResUsize dc_DCStringView_da_to_flat_arr(DCDynArr* arr, DCStringView** out_arr,
  * Initializes the given pointer to hash table with wanted capacity and other
  * information (see params)
  *
- * NOTE: capacity cannot and must not be changed after initialization
+ * NOTE: capacity is the number of pairs to have room for before growing,
+ * the hash table grows as needed afterwards
  *
- * @param hash_fn is the function that hashes the provided keys, keys are
- * voidptr so they can be anything so to say
+ * @param hash_fn is the function that hashes the provided keys with the seed of
+ * the hash table, keys are voidptr so they can be anything so to say
  *
  * @param key_cmp_fn is the function that compares a provided key and keys in
- * the buckets
+ * the slots whose fingerprints match
  *
  * @param pair_free_fn as each hash pair is saved as a dynamic value if they must be
  * freed using special process this is the parameter to be provided
@@ -701,13 +702,23 @@ DCResVoid dc_ht_free(DCHashTable* ht);
  */
 DCResVoid __dc_ht_free(voidptr ht);
 
+/**
+ * Changes the seed that is given to the hash function, the existing keys are hashed again
+ * and moved to their new slots
+ *
+ * @return nothing or error
+ */
+DCResVoid dc_ht_reseed(DCHashTable* ht, u64 seed);
+
 /**
  * Searches for the key and provides the value
  *
  * @param out_result is the pointer to the dynamic value pointer in the hash
- * table
+ * table (NULL if the key doesn't exist)
  *
- * @return index of the value in its bucket or error
+ * @return position of the entry of the pair (`entry_count` if the key doesn't exist) or error
+ *
+ * NOTE: The pointer is invalidated by the next insertion
  */
 DCResUsize dc_ht_find_by_key(DCHashTable* ht, DCDynVal key, DCDynVal** out_result);
 
@@ -721,6 +732,18 @@ DCResUsize dc_ht_find_by_key(DCHashTable* ht, DCDynVal key, DCDynVal** out_resul
  */
 DCResVoid dc_ht_set(DCHashTable* ht, DCDynVal key, DCDynVal value, DCHashTableSetStatus set_status);
 
+/**
+ * Finds the pair of the key or inserts a new pair for it (with null value) using a single probe sequence
+ *
+ * @param out_pair is the pointer to the pair in the hash table, its value can be changed in place
+ *
+ * @return true if the pair has been inserted, false if the key already existed or error
+ *
+ * NOTE: The pointer is invalidated by the next insertion, `pair_free_fn` is not called on the
+ * existing pair, replacing its value is up to the caller
+ */
+DCResBool dc_ht_entry(DCHashTable* ht, DCDynVal key, DCPair** out_pair);
+
 /**
  * Inserts multiple key/values at once
  *
@@ -753,14 +776,15 @@ DCResVoid dc_ht_merge(DCHashTable* ht, DCHashTable* from, DCHashTableSetStatus s
 DCResBool dc_ht_delete(DCHashTable* ht, DCDynVal key);
 
 /**
- * Exports pointers to all the stored keys to the provided `out_arr` terminated with
- * dynamic value of null `dc_dv_nullptr()`
+ * Exports pointers to all the stored keys (in the order they're inserted) to the provided `out_arr`
+ * terminated with dynamic value of null `dc_dv_nullptr()`
  *
  * @return the number of exported keys or error
  *
  * NOTE: Making changes in the array's element can tend into undefined behavior
  *
- * NOTE: Allocates memory
+ * NOTE: Allocates memory using `dc_allocator`, the array must be freed by
+ * `dc_dealloc(out_arr, (key_count + 1) * sizeof(DCDynVal))`
  */
 DCResUsize dc_ht_keys(DCHashTable* ht, DCDynVal** out_arr);
 
@@ -795,7 +819,7 @@ DCResVoid dc_sv_free(DCStringView* sv);
  *
  * @return size of allocated string or error
  *
- * NOTE: Allocates memory
+ * NOTE: Allocates memory using `dc_allocator`, the string must be freed by `dc_sfree`
  */
 DCResUsize dc_sprintf(string* str, string fmt, ...) __dc_attribute((format(printf, 2, 3)));
 
@@ -804,7 +828,8 @@ DCResUsize dc_sprintf(string* str, string fmt, ...) __dc_attribute((format(print
  *
  * @return size of allocated string or error
  *
- * NOTE: Allocates memory when str is empty or reallocates it
+ * NOTE: Allocates memory when str is empty or reallocates it using `dc_allocator`,
+ * so `str` must be made by `dc_sprintf` or `dc_sappend` and be freed by `dc_sfree`
  */
 DCResUsize dc_sappend(string* str, const string fmt, ...) __dc_attribute((format(printf, 2, 3)));
 
@@ -813,10 +838,17 @@ DCResUsize dc_sappend(string* str, const string fmt, ...) __dc_attribute((format
  *
  * @return string or error
  *
- * NOTE: Allocates memory
+ * NOTE: Allocates memory using `dc_allocator`, the string must be freed by `dc_sfree`
  */
 DCResString dc_strdup(const string in);
 
+/**
+ * Frees the string made by `dc_sprintf`, `dc_sappend` or `dc_strdup`, NULL is ignored
+ *
+ * NOTE: The same allocator the string is made with must be set
+ */
+void dc_sfree(string str);
+
 /**
  * Converts the current value of the dynamic value to string
  *
@@ -957,6 +989,26 @@ DCResVoid dc_free(voidptr variable);
  */
 DCResVoid dc_result_free(voidptr res_ptr);
 
+// ***************************************************************************************
+// * ALLOCATOR
+// ***************************************************************************************
+
+/**
+ * Default allocator function, it's a thin wrapper around `realloc` and `free`
+ */
+voidptr dc_default_alloc(voidptr ctx, voidptr ptr, usize old_size, usize new_size);
+
+/**
+ * Replaces the `dc_allocator` of the current thread that dynamic arrays, hash tables
+ * and formatted strings allocate their memory with and returns the previous one
+ *
+ * NOTE: Memory must be resized and freed by an allocator compatible with the one that allocated it,
+ * so the previous allocator must be restored before working with containers it has allocated
+ *
+ * NOTE: Each thread has its own allocator, setting it doesn't affect the other threads
+ */
+DCAllocator dc_allocator_set(DCAllocator allocator);
+
 // ***************************************************************************************
 // * Files
 // ***************************************************************************************
@@ -1025,6 +1077,11 @@ FILE* dc_error_logs = NULL;
  */
 DCCleanupPool dc_cleanup_pool = {0};
 
+/**
+ * Allocator of dynamic arrays, hash tables and formatted strings, each thread has its own
+ */
+__dc_thread_local DCAllocator dc_allocator = {.fn = dc_default_alloc, .ctx = NULL};
+
 #include "_dv.c"
 
 #include "_da.c"
@@ -1045,6 +1102,11 @@ extern FILE* dc_error_logs;
  */
 extern DCCleanupPool dc_cleanup_pool;
 
+/**
+ * Allocator of dynamic arrays, hash tables and formatted strings, each thread has its own
+ */
+extern __dc_thread_local DCAllocator dc_allocator;
+
 #endif
 
 #endif // DC_MAIN_HEADER_H
@@ -0,0 +1,103 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: allocator.c
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Memory accounting source file
+// *               Counts the bytes the evaluator allocates and enforces its memory limit
+// ***************************************************************************************
+
+#include "allocator.h"
+#include "gc.h"
+
+// ***************************************************************************************
+// * PRIVATE HELPER FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Accounting allocator wrapping the allocator of the evaluator
+ *
+ * NOTE: Only growing is refused at the limit, frees and shrinks always go through
+ */
+static voidptr memory_alloc(voidptr ctx, voidptr ptr, usize old_size, usize new_size)
+{
+    DMemory* memory = (DMemory*)ctx;
+
+    if (ptr == NULL) old_size = 0;
+
+    usize current = memory->current > old_size ? memory->current - old_size : 0;
+
+    if (new_size > old_size && memory->limit != 0 && current + new_size > memory->limit)
+    {
+        memory->exceeded = true;
+
+        return NULL;
+    }
+
+    voidptr result = memory->allocator.fn(memory->allocator.ctx, ptr, old_size, new_size);
+    if (result == NULL && new_size != 0) return NULL;
+
+    memory->current = current + new_size;
+    if (new_size > old_size) memory->total += new_size - old_size;
+    if (memory->current > memory->peak) memory->peak = memory->current;
+
+    return result;
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+void dang_memory_init(DMemory* memory, DCAllocator allocator)
+{
+    memory->allocator = allocator.fn ? allocator : (DCAllocator){.fn = dc_default_alloc, .ctx = NULL};
+
+    memory->limit = DANG_MEMORY_LIMIT;
+
+    memory->current = 0;
+    memory->peak = 0;
+    memory->total = 0;
+
+    memory->exceeded = false;
+}
+
+/**
+ * Makes the accounting allocator of the evaluator the global allocator and returns the previous one
+ *
+ * NOTE: Every public function that allocates on behalf of the evaluator does this on the way in,
+ * so the runtime objects, the program and the containers of the evaluator are always
+ * allocated, resized and freed by the same allocator
+ */
+DCAllocator dang_memory_enter(DEvaluator* de)
+{
+    return dc_allocator_set((DCAllocator){.fn = memory_alloc, .ctx = &de->memory});
+}
+
+void dang_memory_leave(DCAllocator previous)
+{
+    dc_allocator_set(previous);
+}
+
+/**
+ * Sets the number of bytes the evaluator can have in use at once, 0 removes the limit
+ *
+ * NOTE: Evaluations that need more fail with an out of memory error,
+ * the garbage collector thresholds are lowered to fit in the limit so garbage is collected before reaching it
+ */
+void dang_memory_set_limit(DEvaluator* de, usize limit)
+{
+    de->memory.limit = limit;
+
+    if (limit == 0) return;
+
+    if (de->gc.nursery_size > limit / 4) dang_gc_set_nursery_size(de, limit / 4);
+    if (de->gc.threshold > limit / 2) dang_gc_set_threshold(de, limit / 2);
+}
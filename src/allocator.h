@@ -0,0 +1,52 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: allocator.h
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Memory accounting header file
+// ***************************************************************************************
+
+#ifndef DANG_ALLOCATOR_H
+#define DANG_ALLOCATOR_H
+
+#include "evaluator.h"
+
+// ***************************************************************************************
+// * CONFIGS
+// ***************************************************************************************
+
+/**
+ * Number of bytes an evaluator can have in use at once, 0 means no limit
+ * It can be changed per evaluator using `dang_memory_set_limit`
+ */
+#ifndef DANG_MEMORY_LIMIT
+#define DANG_MEMORY_LIMIT 0
+#endif
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+#define dang_memory_current(DE) ((DE)->memory.current)
+#define dang_memory_peak(DE) ((DE)->memory.peak)
+#define dang_memory_total(DE) ((DE)->memory.total)
+
+// ***************************************************************************************
+// * FUNCTION DECLARATIONS
+// ***************************************************************************************
+
+void dang_memory_init(DMemory* memory, DCAllocator allocator);
+
+DCAllocator dang_memory_enter(DEvaluator* de);
+void dang_memory_leave(DCAllocator previous);
+void dang_memory_set_limit(DEvaluator* de, usize limit);
+
+#endif // DANG_ALLOCATOR_H
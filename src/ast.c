@@ -16,7 +16,121 @@
 
 #include "ast.h"
 
-#define pool_last_el() &dc_da_get2(*pool, pool->count - 1)
+#include <string.h>
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+#define arena_align(SIZE) (((SIZE) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+#define ARENA_SYMBOLS_INITIAL_CAP 256
+
+// ***************************************************************************************
+// * PRIVATE FUNCTIONS
+// ***************************************************************************************
+
+static DCResVoid arena_new_chunk(DArena* arena, DArenaChunk** list, usize chunk_size, usize min_size)
+{
+    DC_RES_void();
+
+    usize capacity = min_size > chunk_size ? min_size : chunk_size;
+
+    DArenaChunk* chunk = (DArenaChunk*)dc_alloc(sizeof(DArenaChunk) + capacity);
+    if (chunk == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    chunk->next = *list;
+
+    *list = chunk;
+    arena->chunk_count++;
+
+    dc_ret();
+}
+
+/**
+ * Bumps the first chunk of the list, a new chunk is started when it is full
+ *
+ * NOTE: The remaining of the full chunk is not reused
+ */
+static DCResVoidptr arena_bump(DArena* arena, DArenaChunk** list, usize chunk_size, usize size)
+{
+    DC_RES_voidptr();
+
+    size = arena_align(size == 0 ? 1 : size);
+
+    if (!*list || (*list)->capacity - (*list)->used < size)
+        dc_try_fail_temp(DCResVoid, arena_new_chunk(arena, list, chunk_size, size));
+
+    DArenaChunk* chunk = *list;
+
+    voidptr ptr = (u8*)chunk->data + chunk->used;
+
+    chunk->used += size;
+    arena->bytes_used += size;
+
+    dc_ret_ok(ptr);
+}
+
+static void arena_free_chunks(DArena* arena, DArenaChunk* chunk, DArenaChunk* until)
+{
+    while (chunk != until)
+    {
+        DArenaChunk* next = chunk->next;
+
+        arena->bytes_used -= chunk->used;
+        arena->chunk_count--;
+
+        dc_dealloc(chunk, sizeof(DArenaChunk) + chunk->capacity);
+
+        chunk = next;
+    }
+}
+
+/**
+ * Capacity is always a power of 2 and the set is kept at most half full
+ */
+static DCResVoid arena_symbols_grow(DArena* arena)
+{
+    DC_RES_void();
+
+    usize cap = arena->symbol_cap ? arena->symbol_cap * 2 : ARENA_SYMBOLS_INITIAL_CAP;
+
+    DStringBufferPtr* symbols = (DStringBufferPtr*)dc_alloc(cap * sizeof(DStringBufferPtr));
+    if (symbols == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    memset(symbols, 0, cap * sizeof(DStringBufferPtr));
+
+    for (usize i = 0; i < arena->symbol_cap; ++i)
+    {
+        DStringBufferPtr symbol = arena->symbols[i];
+        if (!symbol) continue;
+
+        usize j = symbol->hash & (cap - 1);
+        while (symbols[j])
+            j = (j + 1) & (cap - 1);
+
+        symbols[j] = symbol;
+    }
+
+    dc_dealloc(arena->symbols, arena->symbol_cap * sizeof(DStringBufferPtr));
+
+    arena->symbols = symbols;
+    arena->symbol_cap = cap;
+
+    dc_ret();
+}
 
 static DCResVoid array_inspector(DCDynArrPtr darr, string prefix, string postfix, string delimiter, b1 no_delim_for_last,
                                  string* result)
@@ -46,6 +160,247 @@ static DCResVoid array_inspector(DCDynArrPtr darr, string prefix, string postfix
     dc_ret();
 }
 
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+DCResVoid dang_arena_init(DArena* arena)
+{
+    DC_RES_void();
+
+    if (!arena) dc_ret_e(dc_e_code(NV), "cannot initialize NULL arena");
+
+    arena->chunks = NULL;
+    arena->symbol_chunks = NULL;
+    arena->chunk_count = 0;
+    arena->bytes_used = 0;
+
+    arena->symbols = NULL;
+    arena->symbol_count = 0;
+    arena->symbol_cap = 0;
+
+    dc_try_fail(dc_da_init2(&arena->scratch, 256, 2, NULL));
+
+    dc_try_or_fail_with(arena_new_chunk(arena, &arena->chunks, DANG_ARENA_CHUNK_SIZE, 0),
+                        { dc_try_fail_temp(DCResVoid, dc_da_free(&arena->scratch)); });
+
+    dc_ret();
+}
+
+DCResVoid dang_arena_free(DArena* arena)
+{
+    DC_RES_void();
+
+    if (!arena) dc_ret();
+
+    dc_try_fail(dc_da_free(&arena->scratch));
+
+    dc_dealloc(arena->symbols, arena->symbol_cap * sizeof(DStringBufferPtr));
+
+    arena->symbols = NULL;
+    arena->symbol_count = 0;
+    arena->symbol_cap = 0;
+
+    arena_free_chunks(arena, arena->chunks, NULL);
+    arena_free_chunks(arena, arena->symbol_chunks, NULL);
+
+    arena->chunks = NULL;
+    arena->symbol_chunks = NULL;
+
+    dc_ret();
+}
+
+/**
+ * Frees everything that is allocated (and interned) in the arena but keeps the first chunk for the next allocations
+ */
+void dang_arena_reset(DArena* arena)
+{
+    DArenaChunk* last = arena->chunks;
+    while (last && last->next)
+        last = last->next;
+
+    arena_free_chunks(arena, arena->chunks, last);
+    arena_free_chunks(arena, arena->symbol_chunks, NULL);
+
+    if (last)
+    {
+        arena->bytes_used -= last->used;
+        last->used = 0;
+    }
+
+    arena->chunks = last;
+    arena->symbol_chunks = NULL;
+
+    arena->scratch.count = 0;
+
+    if (arena->symbols) memset(arena->symbols, 0, arena->symbol_cap * sizeof(DStringBufferPtr));
+    arena->symbol_count = 0;
+}
+
+/**
+ * Current position of the arena, see `dang_arena_rollback`
+ */
+DArenaMark dang_arena_mark(DArena* arena)
+{
+    return (DArenaMark){.chunk = arena->chunks, .used = arena->chunks ? arena->chunks->used : 0};
+}
+
+/**
+ * Frees everything that is allocated in the arena after the mark, the interned strings are kept
+ *
+ * NOTE: The nodes and the lists allocated after the mark must not be referenced anymore
+ */
+void dang_arena_rollback(DArena* arena, DArenaMark mark)
+{
+    arena_free_chunks(arena, arena->chunks, mark.chunk);
+
+    arena->chunks = mark.chunk;
+
+    if (mark.chunk)
+    {
+        arena->bytes_used -= mark.chunk->used - mark.used;
+        mark.chunk->used = mark.used;
+    }
+}
+
+/**
+ * Bumps the current chunk, a new chunk is started when it is full
+ *
+ * NOTE: The remaining of the full chunk is not reused
+ */
+DCResVoidptr dang_arena_alloc(DArena* arena, usize size)
+{
+    return arena_bump(arena, &arena->chunks, DANG_ARENA_CHUNK_SIZE, size);
+}
+
+/**
+ * Copies the node to the arena and returns its address which stays valid until the arena is freed
+ */
+ResDNodePtr dang_arena_push_node(DArena* arena, DCDynVal node)
+{
+    DC_RES2(ResDNodePtr);
+
+    dc_try_or_fail_with3(DCResVoidptr, ptr_res, dang_arena_alloc(arena, sizeof(DCDynVal)), {});
+
+    DCDynValPtr dn = (DCDynValPtr)dc_unwrap2(ptr_res);
+    *dn = node;
+
+    dc_ret_ok(dn);
+}
+
+DCResString dang_arena_strdup(DArena* arena, DCStringView sv)
+{
+    DC_RES_string();
+
+    dc_try_or_fail_with3(DCResVoidptr, ptr_res, dang_arena_alloc(arena, sv.len + 1), {});
+
+    string str = (string)dc_unwrap2(ptr_res);
+
+    memcpy(str, sv.str, sv.len);
+    str[sv.len] = '\0';
+
+    dc_ret_ok(str);
+}
+
+/**
+ * Returns the unique copy of the text, it's allocated in the arena the first time the text is seen
+ *
+ * NOTE: Interned strings of the same arena are equal if and only if their pointers are equal
+ * and `dang_symbol_of` gives their precomputed hash
+ */
+DCResString dang_arena_intern(DArena* arena, DCStringView sv)
+{
+    DC_RES_string();
+
+    u32 hash = dang_str_hash(sv.str, sv.len, 0);
+
+    if ((arena->symbol_count + 1) * 2 > arena->symbol_cap) dc_try_fail_temp(DCResVoid, arena_symbols_grow(arena));
+
+    usize mask = arena->symbol_cap - 1;
+    usize i = hash & mask;
+
+    for (DStringBufferPtr symbol = arena->symbols[i]; symbol; symbol = arena->symbols[i])
+    {
+        if (symbol->hash == hash && symbol->len == sv.len && memcmp(symbol->data, sv.str, sv.len) == 0)
+            dc_ret_ok(symbol->data);
+
+        i = (i + 1) & mask;
+    }
+
+    DArenaChunk** chunks = &arena->symbol_chunks;
+    usize size = sizeof(DStringBuffer) + sv.len + 1;
+
+    dc_try_or_fail_with3(DCResVoidptr, ptr_res, arena_bump(arena, chunks, DANG_ARENA_SYMBOL_CHUNK_SIZE, size), {});
+
+    DStringBufferPtr symbol = (DStringBufferPtr)dc_unwrap2(ptr_res);
+
+    symbol->len = sv.len;
+    symbol->cap = sv.len;
+    symbol->hash_len = sv.len;
+    symbol->hash_seed = 0;
+    symbol->hash = hash;
+    symbol->gc_flags = 0;
+    memcpy(symbol->data, sv.str, sv.len);
+    symbol->data[sv.len] = '\0';
+
+    arena->symbols[i] = symbol;
+    arena->symbol_count++;
+
+    dc_ret_ok(symbol->data);
+}
+
+/**
+ * Hash of the name, the same as the hash the name is interned with
+ *
+ * NOTE: It works for plain C strings as well, the text is hashed rather than reading the hash
+ * stored before an interned string
+ */
+u32 dang_symbol_hash(const char* str)
+{
+    return dang_str_hash(str, strlen(str), 0);
+}
+
+DCResVoid dang_arena_list_push(DArena* arena, DCDynVal node)
+{
+    return dc_da_push(&arena->scratch, node);
+}
+
+/**
+ * Copies the elements pushed since the mark to a list in the chunks and pops them from the scratch stack
+ *
+ * NOTE: The list is sized exactly and must not grow, it's never freed individually
+ */
+DCResDa dang_arena_list_end(DArena* arena, usize mark)
+{
+    DC_RES_da();
+
+    usize count = arena->scratch.count - mark;
+
+    dc_try_or_fail_with3(DCResVoidptr, list_res, dang_arena_alloc(arena, sizeof(DCDynArr) + (count * sizeof(DCDynVal))),
+                         { dang_arena_list_drop(arena, mark); });
+
+    DCDynArrPtr list = (DCDynArrPtr)dc_unwrap2(list_res);
+
+    *list = (DCDynArr){
+        .elements = count != 0 ? (DCDynVal*)(list + 1) : NULL,
+        .cap = count,
+        .count = count,
+        .multiplier = 1,
+        .element_free_fn = NULL,
+    };
+
+    if (count != 0) memcpy(list->elements, &arena->scratch.elements[mark], count * sizeof(DCDynVal));
+
+    dang_arena_list_drop(arena, mark);
+
+    dc_ret_ok(list);
+}
+
+void dang_arena_list_drop(DArena* arena, usize mark)
+{
+    if (mark < arena->scratch.count) arena->scratch.count = mark;
+}
+
 DCResVoid dang_program_inspect(DNodeProgram* program, string* result)
 {
     DC_RES_void();
@@ -62,7 +417,7 @@ DCResVoid dang_node_inspect(DCDynValPtr dn, string* result)
     {                                                                                                                          \
         dc_try_or_fail_with3(DCResString, data_str_res, dc_tostr_dv(dn), {});                                                  \
         dc_sappend(result, FMT, dc_unwrap2(data_str_res));                                                                     \
-        if (dc_unwrap2(data_str_res)) free(dc_unwrap2(data_str_res));                                                          \
+        dc_sfree(dc_unwrap2(data_str_res));                                                                                    \
     } while (0)
 
 
@@ -129,7 +484,7 @@ DCResVoid dang_node_inspect(DCDynValPtr dn, string* result)
         {
             DNodePrefixExpression prefix_exp = dc_dv_as(*dn, DNodePrefixExpression);
 
-            dc_sappend(result, "(%s", prefix_exp.op);
+            dc_sappend(result, "(%s", tostr_DOperator(prefix_exp.op));
             dc_try_fail(dang_node_inspect(prefix_exp.operand, result));
             dc_sappend(result, "%s", ")");
             break;
@@ -141,7 +496,7 @@ DCResVoid dang_node_inspect(DCDynValPtr dn, string* result)
 
             dc_sappend(result, "%s", "(");
             dc_try_fail(dang_node_inspect(infix_exp.left, result));
-            dc_sappend(result, " %s ", infix_exp.op);
+            dc_sappend(result, " %s ", tostr_DOperator(infix_exp.op));
             dc_try_fail(dang_node_inspect(infix_exp.right, result));
             dc_sappend(result, "%s", ")");
             break;
@@ -222,8 +577,8 @@ DCResVoid dang_node_inspect(DCDynValPtr dn, string* result)
             break;
         }
 
-        case dc_dvt(string):
-            append_data_str("\"%s\"");
+        case dc_dvt(DoString):
+            dc_sappend(result, "\"" DCPRIsv "\"", dc_sv_fmt(dc_dv_as(*dn, DoString)));
             break;
 
         case dc_dvt(DNodeHashTableLiteral):
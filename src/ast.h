@@ -20,6 +20,106 @@
 #include "common.h"
 #include "token.h"
 
+// ***************************************************************************************
+// * CONFIGS
+// ***************************************************************************************
+
+/**
+ * Number of bytes in each chunk of the AST arena, bigger allocations get a chunk of their own
+ */
+#ifndef DANG_ARENA_CHUNK_SIZE
+#define DANG_ARENA_CHUNK_SIZE (64 * 1024)
+#endif
+
+/**
+ * Number of bytes in each chunk of the interned strings, they're only allocated once something is interned
+ */
+#ifndef DANG_ARENA_SYMBOL_CHUNK_SIZE
+#define DANG_ARENA_SYMBOL_CHUNK_SIZE (4 * 1024)
+#endif
+
+// ***************************************************************************************
+// * TYPES
+// ***************************************************************************************
+
+typedef struct DArenaChunk
+{
+    struct DArenaChunk* next;
+    usize capacity;
+    usize used;
+    max_align_t data[];
+} DArenaChunk;
+
+/**
+ * Memory of the parsed programs, nodes, node lists (statements, parameters, arguments, etc.)
+ * and identifier and string literal texts are bump allocated in chunks that are never moved,
+ * so the addresses of the nodes are stable
+ * Lists are collected on the `scratch` stack while they're being parsed and copied to the chunks once complete
+ * `symbols` is an open addressing set of the interned strings, the same text is always the same pointer,
+ * they're kept in `symbol_chunks` so they outlive the nodes that are rolled back
+ *
+ * NOTE: Nothing is freed individually, everything goes away in one shot by `dang_arena_free`
+ * or everything allocated after a mark (except the interned strings) by `dang_arena_rollback`
+ */
+typedef struct
+{
+    DArenaChunk* chunks;
+    DArenaChunk* symbol_chunks;
+    usize chunk_count;
+    usize bytes_used;
+
+    DCDynArr scratch;
+
+    DStringBufferPtr* symbols;
+    usize symbol_count;
+    usize symbol_cap;
+} DArena;
+
+/**
+ * Position of the arena to roll back to, the chunks started after it are freed
+ */
+typedef struct
+{
+    DArenaChunk* chunk;
+    usize used;
+} DArenaMark;
+
+DCResType(DCDynValPtr, ResDNodePtr);
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+/**
+ * Lists are parsed in a stack discipline, the mark is taken before pushing the first element
+ * and the list is either ended or dropped at the same mark
+ */
+#define dang_arena_list_mark(A) ((A)->scratch.count)
+
+/**
+ * Only valid for the strings returned by `dang_arena_intern`, interned strings are
+ * the data of string buffers whose length and hash are stored right before the text
+ */
+#define dang_symbol_of(STR) ((DStringBufferPtr)((STR) - offsetof(DStringBuffer, data)))
+
+// ***************************************************************************************
+// * FUNCTION DECLARATIONS
+// ***************************************************************************************
+
+DCResVoid dang_arena_init(DArena* arena);
+DCResVoid dang_arena_free(DArena* arena);
+void dang_arena_reset(DArena* arena);
+DArenaMark dang_arena_mark(DArena* arena);
+void dang_arena_rollback(DArena* arena, DArenaMark mark);
+DCResVoidptr dang_arena_alloc(DArena* arena, usize size);
+ResDNodePtr dang_arena_push_node(DArena* arena, DCDynVal node);
+DCResString dang_arena_strdup(DArena* arena, DCStringView sv);
+DCResString dang_arena_intern(DArena* arena, DCStringView sv);
+u32 dang_symbol_hash(const char* str);
+DCResVoid dang_arena_list_push(DArena* arena, DCDynVal node);
+DCResDa dang_arena_list_end(DArena* arena, usize mark);
+void dang_arena_list_drop(DArena* arena, usize mark);
+
 DCResVoid dang_program_inspect(DNodeProgram* program, string* result);
 
 DCResVoid dang_node_inspect(DCDynValPtr dn, string* result);
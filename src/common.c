@@ -33,12 +33,14 @@ string dv_type_tostr(DCDynValPtr dv)
             return "integer";
 
         case dc_dvt(string):
+        case dc_dvt(DoString):
             return "string";
 
         case dc_dvt(b1):
             return "boolean";
 
         case dc_dvt(DCDynArrPtr):
+        case dc_dvt(DArrayPtr):
             return "array";
 
         case dc_dvt(DCHashTablePtr):
@@ -47,6 +49,13 @@ string dv_type_tostr(DCDynValPtr dv)
         case dc_dvt(DBuiltinFunction):
             return "builtin function";
 
+        case dc_dvt(DoFunction):
+        case dc_dvt(DoClosure):
+            return "function";
+
+        case dc_dvt(DFnProtoPtr):
+            return "function prototype";
+
         case dc_dvt(DNodeIdentifier):
             return "identifier node";
 
@@ -86,6 +95,9 @@ string dv_type_tostr(DCDynValPtr dv)
         case dc_dvt(DEnvPtr):
             return "environment pointer";
 
+        case dc_dvt(DScopePtr):
+            return "scope pointer";
+
         case dc_dvt(voidptr):
             if (dc_dv_as(*dv, voidptr) == NULL) return "(null)";
             break;
@@ -93,6 +105,9 @@ string dv_type_tostr(DCDynValPtr dv)
         case dc_dvt(DoReturn):
             return "return object";
 
+        case dc_dvt(DoTailCall):
+            return "tail call object";
+
         case dc_dvt(DCDynValPtr):
             return dv_type_tostr(dc_dv_as(*dv, DCDynValPtr));
 
@@ -102,3 +117,156 @@ string dv_type_tostr(DCDynValPtr dv)
 
     return "(unknown or unimplemented type)";
 }
+
+string tostr_DOperator(DOperator op)
+{
+    static const string operator_texts[DOP__MAX] = {
+        [DOP_NOT] = "!", [DOP_NEG] = "-", [DOP_ADD] = "+", [DOP_SUB] = "-", [DOP_MUL] = "*",
+        [DOP_DIV] = "/", [DOP_LT] = "<",  [DOP_GT] = ">",  [DOP_EQ] = "==", [DOP_NEQ] = "!=",
+    };
+
+    if (op >= DOP__MAX) return "(unknown operator)";
+
+    return operator_texts[op];
+}
+
+// ***************************************************************************************
+// * HASHING
+// *    The string hash follows wyhash (word at a time reads and 64x64->128 bit multiplications)
+// ***************************************************************************************
+
+#define HASH_SECRET0 0xa0761d6478bd642fULL
+#define HASH_SECRET1 0xe7037ed1a0b428dbULL
+#define HASH_SECRET2 0x8ebc6af09c88c6e3ULL
+#define HASH_SECRET3 0x589965cc75374cc3ULL
+
+#define hash_fold(HASH) ((u32)((HASH) ^ ((HASH) >> 32)))
+
+static inline u64 hash_read64(const u8* p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+static inline u64 hash_read32(const u8* p)
+{
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+/**
+ * Multiplies the two numbers and stores the lower half of the 128 bit result in `a` and the upper half in `b`
+ */
+static inline void hash_mum(u64* a, u64* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline u64 hash_mix(u64 a, u64 b)
+{
+    hash_mum(&a, &b);
+
+    return a ^ b;
+}
+
+/**
+ * Hash of the first `len` bytes of the string, it reads 8 bytes at a time (up to 48 bytes per round)
+ *
+ * NOTE: The seed is the initial state of the hash, so the strings that collide under one seed
+ * are unrelated to the ones that collide under another (the interned strings use zero)
+ */
+u32 dang_str_hash(const char* str, usize len, u64 seed)
+{
+    const u8* p = (const u8*)str;
+    seed ^= hash_mix(seed ^ HASH_SECRET0, HASH_SECRET1);
+    u64 a, b;
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (hash_read32(p) << 32) | hash_read32(p + ((len >> 3) << 2));
+            b = (hash_read32(p + len - 4) << 32) | hash_read32(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = ((u64)p[0] << 16) | ((u64)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        usize i = len;
+
+        if (i > 48)
+        {
+            u64 see1 = seed, see2 = seed;
+
+            do
+            {
+                seed = hash_mix(hash_read64(p) ^ HASH_SECRET1, hash_read64(p + 8) ^ seed);
+                see1 = hash_mix(hash_read64(p + 16) ^ HASH_SECRET2, hash_read64(p + 24) ^ see1);
+                see2 = hash_mix(hash_read64(p + 32) ^ HASH_SECRET3, hash_read64(p + 40) ^ see2);
+
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16)
+        {
+            seed = hash_mix(hash_read64(p) ^ HASH_SECRET1, hash_read64(p + 8) ^ seed);
+
+            p += 16;
+            i -= 16;
+        }
+
+        a = hash_read64(p + i - 16);
+        b = hash_read64(p + i - 8);
+    }
+
+    a ^= HASH_SECRET1;
+    b ^= seed;
+    hash_mum(&a, &b);
+
+    return hash_fold(hash_mix(a ^ HASH_SECRET0 ^ len, b ^ HASH_SECRET1));
+}
+
+/**
+ * Hash of the integer, all the bits of the integer affect all the bits of the hash
+ * (the finalizer of murmur3 over the integer xor the seed)
+ */
+u32 dang_int_hash(u64 key, u64 seed)
+{
+    key ^= seed;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return hash_fold(key);
+}
@@ -19,39 +19,85 @@
 
 #include "dcommon/dcommon_primitives.h"
 
+// ***************************************************************************************
+// * FORWARD DECLARATIONS
+// ***************************************************************************************
+typedef struct DEvaluator DEvaluator;
+typedef struct DEnv DEnv;
+typedef DEnv* DEnvPtr;
+typedef struct DFnProto DFnProto;
+typedef DFnProto* DFnProtoPtr;
+typedef struct DVM DVM;
+typedef struct DStringBuffer DStringBuffer;
+typedef DStringBuffer* DStringBufferPtr;
+typedef struct DArray DArray;
+typedef DArray* DArrayPtr;
+typedef struct DArrayStorage DArrayStorage;
+typedef DArrayStorage* DArrayStoragePtr;
+typedef struct DBox DBox;
+typedef DBox* DBoxPtr;
+
+/**
+ * Compact runtime value, a single tagged word (see value.h)
+ */
+typedef u64 DValue;
+
+/**
+ * Function pointer type for all dang builtin functions
+ *
+ * NOTE: As DCDynVal is forward declared at this stage, I couldn't use DCRes
+ *       So simply I've used DCDynVal for output and DCError as a pointer
+ *       Now if it returns an error (error is not null), I can continue the flow
+ *       The normal way with redirecting the error
+ */
+typedef DCDynVal (*DBuiltinFunction)(DEvaluator* de, DCDynValPtr call_obj, DCError* error);
+
 // ***************************************************************************************
 // * NODES
 // *    Nodes are only those which cannot be used as a valid general data type other as a
 // *    parser output and evaluation input
 // *    All the fields in any "node"s is a Dynamic Value Pointer which points to the actual
-// *    dynamic value in the pool (any dynamic array consist of various dynamic value)
+// *    dynamic value in the arena of the parsed programs (see ast.h)
 // ***************************************************************************************
 
 #define dn_field_as(NODE, NODE_TYPE, FIELD, FIELD_TYPE) dc_dv_as(*dc_dv_as(NODE, NODE_TYPE).FIELD, FIELD_TYPE)
 
+/**
+ * `depth` and `slot` are filled by the resolver, `depth` is the number of environments
+ * to hop outward and `slot` is the index of the variable in that environment
+ * `builtin` is set by the resolver when the name is a registered builtin function,
+ * it's used when no variable is defined under that name
+ */
 typedef struct
 {
     string value;
+    u32 depth;
+    u32 slot;
+    DBuiltinFunction builtin;
 } DNodeIdentifier;
 
 #define dn_identifier(V)                                                                                                       \
     (DNodeIdentifier)                                                                                                          \
     {                                                                                                                          \
-        .value = (V)                                                                                                           \
+        .value = (V), .depth = 0, .slot = 0, .builtin = NULL                                                                   \
     }
 
 DCResType(DNodeIdentifier, ResDNodeIdentifier);
 
+/**
+ * `slot` is filled by the resolver, let statements always define in the current environment
+ */
 typedef struct
 {
     string name;
     DCDynValPtr value;
+    usize slot;
 } DNodeLetStatement;
 
 #define dn_let(N, V)                                                                                                           \
     (DNodeLetStatement)                                                                                                        \
     {                                                                                                                          \
-        .name = (N), .value = (V)                                                                                              \
+        .name = (N), .value = (V), .slot = 0                                                                                   \
     }
 
 DCResType(DNodeLetStatement, ResDNodeLetStatement);
@@ -69,9 +115,31 @@ typedef struct
 
 DCResType(DNodeReturnStatement, ResDNodeReturnStatement);
 
+/**
+ * Prefix and infix operators, resolved from the operator token at parse time
+ * so evaluation never has to compare operator strings
+ *
+ * NOTE: The text of the operator is only needed for inspection and error messages (see tostr_DOperator)
+ */
+typedef enum
+{
+    DOP_NOT,
+    DOP_NEG,
+    DOP_ADD,
+    DOP_SUB,
+    DOP_MUL,
+    DOP_DIV,
+    DOP_LT,
+    DOP_GT,
+    DOP_EQ,
+    DOP_NEQ,
+
+    DOP__MAX,
+} DOperator;
+
 typedef struct
 {
-    string op;
+    DOperator op;
     DCDynValPtr operand;
 } DNodePrefixExpression;
 
@@ -85,7 +153,7 @@ DCResType(DNodePrefixExpression, ResDNodePrefixExpression);
 
 typedef struct
 {
-    string op;
+    DOperator op;
     DCDynValPtr left;
     DCDynValPtr right;
 } DNodeInfixExpression;
@@ -152,30 +220,41 @@ typedef struct
 
 DCResType(DNodeHashTableLiteral, ResDNodeHashTableLiteral);
 
+typedef struct DScope DScope;
+typedef DScope* DScopePtr;
+
+/**
+ * `scope` is created by the resolver and holds the parameters and all the local variables
+ */
 typedef struct
 {
     DCDynArrPtr parameters;
     DCDynArrPtr body;
+    DScopePtr scope;
 } DNodeFunctionLiteral;
 
 #define dn_function(P, B)                                                                                                      \
     (DNodeFunctionLiteral)                                                                                                     \
     {                                                                                                                          \
-        .parameters = (P), .body = (B)                                                                                         \
+        .parameters = (P), .body = (B), .scope = NULL                                                                          \
     }
 
 DCResType(DNodeFunctionLiteral, ResDNodeFunctionLiteral);
 
+/**
+ * `tail` is set by the resolver when the call is in a tail position of a function body
+ */
 typedef struct
 {
     DCDynValPtr function;
     DCDynArrPtr arguments;
+    b1 tail;
 } DNodeCallExpression;
 
 #define dn_call(F, A)                                                                                                          \
     (DNodeCallExpression)                                                                                                      \
     {                                                                                                                          \
-        .function = (F), .arguments = (A)                                                                                      \
+        .function = (F), .arguments = (A), .tail = false                                                                       \
     }
 
 DCResType(DNodeCallExpression, ResDNodeCallExpression);
@@ -224,32 +303,146 @@ typedef struct
         .ret_val = (V)                                                                                                         \
     }
 
-// ***************************************************************************************
-// * FORWARD DECLARATIONS
-// ***************************************************************************************
-typedef struct DEvaluator DEvaluator;
-typedef struct DEnv DEnv;
-typedef DEnv* DEnvPtr;
+/**
+ * Call in a tail position, it is performed by the `apply_function` of the running function
+ * so tail recursion doesn't grow the C stack, `fn` is the function object kept by the evaluator
+ */
+typedef struct
+{
+    DCDynValPtr fn;
+    DCDynArrPtr arguments;
+} DoTailCall;
+
+#define do_tail_call(F, A)                                                                                                     \
+    (DoTailCall)                                                                                                               \
+    {                                                                                                                          \
+        .fn = (F), .arguments = (A)                                                                                            \
+    }
 
 /**
- * Function pointer type for all dang builtin functions
+ * Function object of the tree walker, the function literal node and the environment it's created in
+ */
+typedef struct
+{
+    DNodeFunctionLiteral* fn;
+    DEnvPtr env;
+} DoFunction;
+
+#define do_function(F, E)                                                                                                      \
+    (DoFunction)                                                                                                               \
+    {                                                                                                                          \
+        .fn = (F), .env = (E)                                                                                                  \
+    }
+
+/**
+ * Function object of the vm, the compiled prototype and the environment it's created in
+ */
+typedef struct
+{
+    DFnProtoPtr proto;
+    DEnvPtr env;
+} DoClosure;
+
+#define do_closure(P, E)                                                                                                       \
+    (DoClosure)                                                                                                                \
+    {                                                                                                                          \
+        .proto = (P), .env = (E)                                                                                               \
+    }
+
+/**
+ * String value, `len` bytes starting at `str` that are not necessarily followed by a '\0'
+ * `buf` is the buffer holding the bytes, the strings made by the host (e.g. `do_string`) don't have any
  *
- * NOTE: As DCDynVal is forward declared at this stage, I couldn't use DCRes
- *       So simply I've used DCDynVal for output and DCError as a pointer
- *       Now if it returns an error (error is not null), I can continue the flow
- *       The normal way with redirecting the error
+ * NOTE: The bytes of a string never change, so string values are freely copied and share their buffer
  */
-typedef DCDynVal (*DBuiltinFunction)(DEvaluator* de, DCDynValPtr call_obj, DCError* error);
+typedef struct
+{
+    string str;
+    usize len;
+    DStringBufferPtr buf;
+} DoString;
 
+#define do_string_of(STR, LEN, BUF)                                                                                            \
+    (DoString)                                                                                                                 \
+    {                                                                                                                          \
+        .str = (STR), .len = (LEN), .buf = (BUF)                                                                               \
+    }
+
+/**
+ * Length prefixed storage of the strings, a concatenation appends to the buffer of the left string
+ * in place as long as that string ends where the written part of the buffer (`len`) ends and there is room
+ * Other strings sharing the buffer are prefixes of it and aren't affected by the appends
+ * `hash` is the cached hash of the first `hash_len` bytes with `hash_seed`, it's computed lazily (see `do_string_hash`)
+ * `gc_flags` is its collector state (see gc.h)
+ *
+ * NOTE: The interned strings of the program are buffers in the arena which are full (`cap` == `len`)
+ * and their hash (with the seed zero) is computed once they're interned
+ */
+struct DStringBuffer
+{
+    usize len;
+    usize cap;
+    usize hash_len;
+    u64 hash_seed;
+    u32 hash;
+    u8 gc_flags;
+    char data[];
+};
+
+/**
+ * Elements of the arrays as compact values (see value.h), `gc_flags` is its collector state (see gc.h)
+ */
+struct DArrayStorage
+{
+    DValue* values;
+    usize count;
+    usize cap;
+
+    u8 gc_flags;
+};
+
+/**
+ * Array object, `count` elements of the `storage` starting at `offset`
+ * Arrays made of other arrays (slices made by `rest` and `slice`) share their storage, `push` appends to the storage
+ * in place while the array ends where the storage ends, otherwise the array gets a copy of its elements first
+ *
+ * NOTE: Elements of a storage never change once they're pushed, so the other arrays sharing it are not affected
+ */
+struct DArray
+{
+    DArrayStoragePtr storage;
+    usize offset;
+    usize count;
+
+    u8 gc_flags;
+};
+
+/**
+ * Minimum capacity of the buffers made by string concatenation
+ */
+#ifndef DANG_STRING_MIN_CAPACITY
+#define DANG_STRING_MIN_CAPACITY 32
+#endif
+
+/**
+ * NOTE: Runtime values are dynamic values while they're being evaluated and in the hash table pairs,
+ * no field in the union should be wider than 3 words so a dynamic value stays at 32 bytes
+ * (functions keep their environment inside their object and not in every dynamic value)
+ * Array elements and environment slots are compact values (see value.h)
+ */
 #define DC_DV_EXTRA_TYPES                                                                                                      \
-    dc_dvt(DEnvPtr), dc_dvt(DBuiltinFunction), dc_dvt(DNodeProgram), dc_dvt(DNodeLetStatement), dc_dvt(DNodeReturnStatement),  \
-        dc_dvt(DNodeBlockStatement), dc_dvt(DNodeIdentifier), dc_dvt(DNodePrefixExpression), dc_dvt(DNodeInfixExpression),     \
-        dc_dvt(DNodeIfExpression), dc_dvt(DNodeArrayLiteral), dc_dvt(DNodeHashTableLiteral), dc_dvt(DNodeFunctionLiteral),     \
-        dc_dvt(DNodeCallExpression), dc_dvt(DNodeIndexExpression), dc_dvt(DoReturn),
+    dc_dvt(DEnvPtr), dc_dvt(DScopePtr), dc_dvt(DBuiltinFunction), dc_dvt(DFnProtoPtr), dc_dvt(DNodeProgram),                   \
+        dc_dvt(DNodeLetStatement), dc_dvt(DNodeReturnStatement), dc_dvt(DNodeBlockStatement), dc_dvt(DNodeIdentifier),         \
+        dc_dvt(DNodePrefixExpression), dc_dvt(DNodeInfixExpression), dc_dvt(DNodeIfExpression), dc_dvt(DNodeArrayLiteral),     \
+        dc_dvt(DNodeHashTableLiteral), dc_dvt(DNodeFunctionLiteral), dc_dvt(DNodeCallExpression),                              \
+        dc_dvt(DNodeIndexExpression), dc_dvt(DoReturn), dc_dvt(DoTailCall), dc_dvt(DoFunction), dc_dvt(DoClosure),             \
+        dc_dvt(DoString), dc_dvt(DStringBufferPtr), dc_dvt(DArrayPtr), dc_dvt(DArrayStoragePtr), dc_dvt(DBoxPtr),
 
 #define DC_DV_EXTRA_UNION_FIELDS                                                                                               \
     dc_dvf_decl(DEnvPtr);                                                                                                      \
+    dc_dvf_decl(DScopePtr);                                                                                                    \
     dc_dvf_decl(DBuiltinFunction);                                                                                             \
+    dc_dvf_decl(DFnProtoPtr);                                                                                                  \
     /* DNodeProgram is the first node type*/                                                                                   \
     dc_dvf_decl(DNodeProgram);                                                                                                 \
     dc_dvf_decl(DNodeLetStatement);                                                                                            \
@@ -266,9 +459,15 @@ typedef DCDynVal (*DBuiltinFunction)(DEvaluator* de, DCDynValPtr call_obj, DCErr
     dc_dvf_decl(DNodeCallExpression);                                                                                          \
     dc_dvf_decl(DNodeIndexExpression);                                                                                         \
     /* DNodeIndexExpression is the last node type */                                                                           \
-    dc_dvf_decl(DoReturn);
-
-#define DC_DV_EXTRA_FIELDS DEnvPtr env;
+    dc_dvf_decl(DoReturn);                                                                                                     \
+    dc_dvf_decl(DoTailCall);                                                                                                   \
+    dc_dvf_decl(DoFunction);                                                                                                   \
+    dc_dvf_decl(DoClosure);                                                                                                    \
+    dc_dvf_decl(DoString);                                                                                                     \
+    dc_dvf_decl(DStringBufferPtr);                                                                                             \
+    dc_dvf_decl(DArrayPtr);                                                                                                    \
+    dc_dvf_decl(DArrayStoragePtr);                                                                                             \
+    dc_dvf_decl(DBoxPtr);
 
 #include "dcommon/dcommon.h"
 
@@ -291,5 +490,9 @@ typedef enum
 void configure(b1 init_pool, string log_file, b1 append_logs);
 
 string dv_type_tostr(DCDynValPtr dv);
+string tostr_DOperator(DOperator op);
+
+u32 dang_str_hash(const char* str, usize len, u64 seed);
+u32 dang_int_hash(u64 key, u64 seed);
 
 #endif // DANG_COMMON_H
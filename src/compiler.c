@@ -0,0 +1,512 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: compiler.c
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Bytecode compiler source file
+// ***************************************************************************************
+
+#include "compiler.h"
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+#define DANG_CHUNK_INITIAL_CAP 64
+#define DANG_CHUNK_MAX_OPERAND UINT32_MAX
+
+// ***************************************************************************************
+// * FORWARD DECLARATIONS
+// ***************************************************************************************
+
+static DCResVoid compile_node(DEvaluator* de, DChunk* chunk, DCDynValPtr dn);
+
+// ***************************************************************************************
+// * PRIVATE HELPER FUNCTIONS
+// ***************************************************************************************
+
+static DCResVoid chunk_init(DChunk* chunk)
+{
+    DC_RES_void();
+
+    chunk->code = NULL;
+    chunk->count = 0;
+    chunk->cap = 0;
+
+    dc_try_fail(dc_da_init2(&chunk->constants, 8, 2, NULL));
+
+    dc_ret();
+}
+
+static DCResVoid chunk_free(DChunk* chunk)
+{
+    DC_RES_void();
+
+    if (chunk->code) dc_dealloc(chunk->code, chunk->cap * sizeof(u8));
+
+    chunk->code = NULL;
+    chunk->count = 0;
+    chunk->cap = 0;
+
+    dc_try_fail(dc_da_free(&chunk->constants));
+
+    dc_ret();
+}
+
+static DCResVoid emit_byte(DChunk* chunk, u8 byte)
+{
+    DC_RES_void();
+
+    if (chunk->count == chunk->cap)
+    {
+        usize new_cap = chunk->cap == 0 ? DANG_CHUNK_INITIAL_CAP : chunk->cap * 2;
+
+        u8* new_code = (u8*)dc_resize(chunk->code, chunk->cap * sizeof(u8), new_cap * sizeof(u8));
+        if (new_code == NULL)
+        {
+            dc_dbg_log("Memory allocation failed");
+
+            dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+        }
+
+        chunk->code = new_code;
+        chunk->cap = new_cap;
+    }
+
+    chunk->code[chunk->count++] = byte;
+
+    dc_ret();
+}
+
+static void write_u32(u8* code, usize operand)
+{
+    code[0] = (u8)((operand >> 24) & 0xff);
+    code[1] = (u8)((operand >> 16) & 0xff);
+    code[2] = (u8)((operand >> 8) & 0xff);
+    code[3] = (u8)(operand & 0xff);
+}
+
+static DCResVoid emit_u32(DChunk* chunk, usize operand)
+{
+    DC_RES_void();
+
+    if (operand > DANG_CHUNK_MAX_OPERAND) dc_ret_ea(-1, "operand " dc_fmt(usize) " is too big for the bytecode", operand);
+
+    u8 bytes[4];
+    write_u32(bytes, operand);
+
+    for (usize i = 0; i < 4; ++i)
+        dc_try_fail(emit_byte(chunk, bytes[i]));
+
+    dc_ret();
+}
+
+static DCResVoid emit_op_u32(DChunk* chunk, DOpCode op, usize operand)
+{
+    DC_RES_void();
+
+    dc_try_fail(emit_byte(chunk, (u8)op));
+    dc_try_fail(emit_u32(chunk, operand));
+
+    dc_ret();
+}
+
+static DCResVoid emit_constant(DChunk* chunk, DOpCode op, DCDynVal value)
+{
+    DC_RES_void();
+
+    // constants are only borrowed from the arena or the compiled objects, chunk never owns them
+    value.allocated = false;
+
+    dc_try_fail(dc_da_push(&chunk->constants, value));
+
+    dc_try_fail(emit_op_u32(chunk, op, chunk->constants.count - 1));
+
+    dc_ret();
+}
+
+/**
+ * Emits the jump instruction with a placeholder operand and
+ * returns the position of the operand to be patched later
+ */
+static DCResUsize emit_jump(DChunk* chunk, DOpCode op)
+{
+    DC_RES_usize();
+
+    dc_try_fail_temp(DCResVoid, emit_op_u32(chunk, op, 0));
+
+    dc_ret_ok(chunk->count - 4);
+}
+
+static DCResVoid patch_jump(DChunk* chunk, usize operand_pos)
+{
+    DC_RES_void();
+
+    // jumps only go forward and are relative to the end of their operand
+    usize distance = chunk->count - (operand_pos + 4);
+
+    if (distance > DANG_CHUNK_MAX_OPERAND) dc_ret_e(-1, "too much code to jump over");
+
+    write_u32(chunk->code + operand_pos, distance);
+
+    dc_ret();
+}
+
+static DCResUsize operator_opcode(DOperator op)
+{
+    DC_RES_usize();
+
+    switch (op)
+    {
+        case DOP_NOT:
+            dc_ret_ok(OP_NOT);
+
+        case DOP_NEG:
+            dc_ret_ok(OP_NEG);
+
+        case DOP_ADD:
+            dc_ret_ok(OP_ADD);
+
+        case DOP_SUB:
+            dc_ret_ok(OP_SUB);
+
+        case DOP_MUL:
+            dc_ret_ok(OP_MUL);
+
+        case DOP_DIV:
+            dc_ret_ok(OP_DIV);
+
+        case DOP_LT:
+            dc_ret_ok(OP_LT);
+
+        case DOP_GT:
+            dc_ret_ok(OP_GT);
+
+        case DOP_EQ:
+            dc_ret_ok(OP_EQ);
+
+        case DOP_NEQ:
+            dc_ret_ok(OP_NEQ);
+
+        default:
+            break;
+    };
+
+    dc_ret_ea(-1, "unimplemented operator '%s'", tostr_DOperator(op));
+}
+
+static DCResVoid fn_proto_new(DEvaluator* de, DCDynArrPtr parameters, DScopePtr scope, DFnProtoPtr* out)
+{
+    DC_RES_void();
+
+    DFnProtoPtr proto = (DFnProtoPtr)dc_alloc(sizeof(DFnProto));
+    if (proto == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    proto->parameters = parameters;
+    proto->scope = scope;
+
+    dc_try_or_fail_with3(DCResVoid, res, chunk_init(&proto->chunk), dc_dealloc(proto, sizeof(DFnProto)));
+
+    dc_try_or_fail_with3(DCResVoid, res2, dc_da_push(&de->compiled, dc_dva(DFnProtoPtr, proto)), {
+        dc_dbg_log("failed to push function prototype to the compiled objects");
+        dc_try_fail_temp(DCResVoid, dang_fn_proto_free(proto));
+    });
+
+    *out = proto;
+
+    dc_ret();
+}
+
+// ***************************************************************************************
+// * PRIVATE FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Statements leave exactly one value on the stack, the value of the last statement
+ * Values of the previous statements are popped right after they're computed
+ */
+static DCResVoid compile_statements(DEvaluator* de, DChunk* chunk, DCDynArrPtr statements)
+{
+    DC_RES_void();
+
+    if (!statements || statements->count == 0) return emit_byte(chunk, OP_NULL);
+
+    dc_da_for(compile_statements_loop, *statements, {
+        if (_idx != 0) dc_try_fail(emit_byte(chunk, OP_POP));
+
+        dc_try_fail(compile_node(de, chunk, _it));
+    });
+
+    dc_ret();
+}
+
+static DCResVoid compile_children(DEvaluator* de, DChunk* chunk, DCDynArrPtr children)
+{
+    DC_RES_void();
+
+    if (!children) dc_ret();
+
+    dc_da_for(compile_children_loop, *children, { dc_try_fail(compile_node(de, chunk, _it)); });
+
+    dc_ret();
+}
+
+static DCResVoid compile_if_expression(DEvaluator* de, DChunk* chunk, DNodeIfExpression* if_node)
+{
+    DC_RES_void();
+
+    dc_try_fail(compile_node(de, chunk, if_node->condition));
+
+    dc_try_or_fail_with3(DCResUsize, else_jump, emit_jump(chunk, OP_JUMP_IF_FALSE), {});
+
+    dc_try_fail(compile_statements(de, chunk, if_node->consequence));
+
+    dc_try_or_fail_with3(DCResUsize, end_jump, emit_jump(chunk, OP_JUMP), {});
+
+    dc_try_fail(patch_jump(chunk, dc_unwrap2(else_jump)));
+
+    if (if_node->alternative)
+        dc_try_fail(compile_statements(de, chunk, if_node->alternative));
+    else
+        dc_try_fail(emit_byte(chunk, OP_NULL));
+
+    dc_try_fail(patch_jump(chunk, dc_unwrap2(end_jump)));
+
+    dc_ret();
+}
+
+static DCResVoid compile_function_literal(DEvaluator* de, DChunk* chunk, DNodeFunctionLiteral* fn_node)
+{
+    DC_RES_void();
+
+    DFnProtoPtr proto = NULL;
+    dc_try_fail(fn_proto_new(de, fn_node->parameters, fn_node->scope, &proto));
+
+    dc_try_fail(compile_statements(de, &proto->chunk, fn_node->body));
+    dc_try_fail(emit_byte(&proto->chunk, OP_RETURN));
+
+    dc_try_fail(emit_constant(chunk, OP_CLOSURE, dc_dv(DFnProtoPtr, proto)));
+
+    dc_ret();
+}
+
+static DCResVoid compile_node(DEvaluator* de, DChunk* chunk, DCDynValPtr dn)
+{
+    DC_RES_void();
+
+    if (!dn) dc_ret_e(-1, "got NULL node");
+
+    dc_dbg_log("compiling node of type: '%s'", dv_type_tostr(dn));
+
+    switch (dn->type)
+    {
+        case dc_dvt(DCDynValPtr):
+            return compile_node(de, chunk, dc_dv_as(*dn, DCDynValPtr));
+
+        case DO_INTEGER:
+        case DO_STRING:
+            return emit_constant(chunk, OP_CONSTANT, *dn);
+
+        case DO_BOOLEAN:
+            return emit_byte(chunk, dc_dv_as(*dn, b1) ? OP_TRUE : OP_FALSE);
+
+        case dc_dvt(DNodeIdentifier):
+            return emit_constant(chunk, OP_GET, *dn);
+
+        case dc_dvt(DNodePrefixExpression):
+        {
+            DNodePrefixExpression prefix_node = dc_dv_as(*dn, DNodePrefixExpression);
+
+            dc_try_or_fail_with3(DCResUsize, op, operator_opcode(prefix_node.op), {});
+
+            dc_try_fail(compile_node(de, chunk, prefix_node.operand));
+
+            return emit_byte(chunk, (u8)dc_unwrap2(op));
+        }
+
+        case dc_dvt(DNodeInfixExpression):
+        {
+            DNodeInfixExpression infix_node = dc_dv_as(*dn, DNodeInfixExpression);
+
+            dc_try_or_fail_with3(DCResUsize, op, operator_opcode(infix_node.op), {});
+
+            dc_try_fail(compile_node(de, chunk, infix_node.left));
+            dc_try_fail(compile_node(de, chunk, infix_node.right));
+
+            return emit_byte(chunk, (u8)dc_unwrap2(op));
+        }
+
+        case dc_dvt(DNodeBlockStatement):
+            return compile_statements(de, chunk, dc_dv_as(*dn, DNodeBlockStatement).statements);
+
+        case dc_dvt(DNodeIfExpression):
+            return compile_if_expression(de, chunk, &dc_dv_as(*dn, DNodeIfExpression));
+
+        case dc_dvt(DNodeReturnStatement):
+        {
+            DNodeReturnStatement ret_node = dc_dv_as(*dn, DNodeReturnStatement);
+
+            if (ret_node.ret_val)
+                dc_try_fail(compile_node(de, chunk, ret_node.ret_val));
+            else
+                dc_try_fail(emit_byte(chunk, OP_NULL));
+
+            return emit_byte(chunk, OP_RETURN);
+        }
+
+        case dc_dvt(DNodeLetStatement):
+        {
+            DNodeLetStatement let_node = dc_dv_as(*dn, DNodeLetStatement);
+
+            if (let_node.value)
+                dc_try_fail(compile_node(de, chunk, let_node.value));
+            else
+                dc_try_fail(emit_byte(chunk, OP_NULL));
+
+            DNodeIdentifier target = dn_identifier(let_node.name);
+            target.slot = let_node.slot;
+
+            return emit_constant(chunk, OP_DEFINE, dc_dv(DNodeIdentifier, target));
+        }
+
+        case dc_dvt(DNodeFunctionLiteral):
+            return compile_function_literal(de, chunk, &dc_dv_as(*dn, DNodeFunctionLiteral));
+
+        case dc_dvt(DNodeArrayLiteral):
+        {
+            DCDynArrPtr arr = dc_dv_as(*dn, DNodeArrayLiteral).array;
+
+            dc_try_fail(compile_children(de, chunk, arr));
+
+            return emit_op_u32(chunk, OP_ARRAY, arr ? arr->count : 0);
+        }
+
+        case dc_dvt(DNodeHashTableLiteral):
+        {
+            DCDynArrPtr key_values = dc_dv_as(*dn, DNodeHashTableLiteral).key_values;
+
+            if (key_values->count % 2 != 0) dc_ret_e(-1, "wrong hash literal node");
+
+            dc_try_fail(compile_children(de, chunk, key_values));
+
+            return emit_op_u32(chunk, OP_HASH, key_values->count);
+        }
+
+        case dc_dvt(DNodeIndexExpression):
+        {
+            DNodeIndexExpression index_exp = dc_dv_as(*dn, DNodeIndexExpression);
+
+            dc_try_fail(compile_node(de, chunk, index_exp.operand));
+            dc_try_fail(compile_node(de, chunk, index_exp.index));
+
+            return emit_byte(chunk, OP_INDEX);
+        }
+
+        case dc_dvt(DNodeCallExpression):
+        {
+            DNodeCallExpression call_exp = dc_dv_as(*dn, DNodeCallExpression);
+
+            dc_try_fail(compile_node(de, chunk, call_exp.function));
+            dc_try_fail(compile_children(de, chunk, call_exp.arguments));
+
+            usize argc = call_exp.arguments ? call_exp.arguments->count : 0;
+
+            return emit_op_u32(chunk, call_exp.tail ? OP_TAIL_CALL : OP_CALL, argc);
+        }
+
+        default:
+            break;
+    };
+
+    dc_ret_ea(-1, "Unimplemented or unsupported node type: %s", dv_type_tostr(dn));
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Compiles the whole program into a parameter-less function prototype
+ *
+ * NOTE: The prototype (and all the nested ones) are saved in the compiled objects of the evaluator
+ * No need to free them manually they will be taken care of when the evaluator is freed
+ */
+ResFnProto dang_compile(DEvaluator* de, DNodeProgram* program)
+{
+    DC_RES2(ResFnProto);
+
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot compile using NULL evaluator");
+    if (!program) dc_ret_e(dc_e_code(NV), "cannot compile NULL program");
+
+    DFnProtoPtr proto = NULL;
+    dc_try_fail_temp(DCResVoid, fn_proto_new(de, NULL, &de->globals, &proto));
+
+    dc_try_fail_temp(DCResVoid, compile_statements(de, &proto->chunk, program->statements));
+    dc_try_fail_temp(DCResVoid, emit_byte(&proto->chunk, OP_RETURN));
+
+    dc_ret_ok(proto);
+}
+
+DCResVoid dang_fn_proto_free(DFnProtoPtr proto)
+{
+    DC_RES_void();
+
+    if (!proto) dc_ret();
+
+    dc_try_fail(chunk_free(&proto->chunk));
+
+    dc_dealloc(proto, sizeof(DFnProto));
+
+    dc_ret();
+}
+
+string tostr_DOpCode(DOpCode op)
+{
+    switch (op)
+    {
+        dc_str_case(OP_CONSTANT);
+        dc_str_case(OP_NULL);
+        dc_str_case(OP_TRUE);
+        dc_str_case(OP_FALSE);
+        dc_str_case(OP_POP);
+        dc_str_case(OP_GET);
+        dc_str_case(OP_DEFINE);
+        dc_str_case(OP_ADD);
+        dc_str_case(OP_SUB);
+        dc_str_case(OP_MUL);
+        dc_str_case(OP_DIV);
+        dc_str_case(OP_EQ);
+        dc_str_case(OP_NEQ);
+        dc_str_case(OP_LT);
+        dc_str_case(OP_GT);
+        dc_str_case(OP_NEG);
+        dc_str_case(OP_NOT);
+        dc_str_case(OP_JUMP);
+        dc_str_case(OP_JUMP_IF_FALSE);
+        dc_str_case(OP_ARRAY);
+        dc_str_case(OP_HASH);
+        dc_str_case(OP_INDEX);
+        dc_str_case(OP_CLOSURE);
+        dc_str_case(OP_CALL);
+        dc_str_case(OP_TAIL_CALL);
+        dc_str_case(OP_RETURN);
+
+        default:
+            break;
+    };
+
+    return "(unknown opcode)";
+}
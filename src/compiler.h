@@ -0,0 +1,97 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: compiler.h
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Bytecode compiler header file
+// ***************************************************************************************
+
+#ifndef DANG_COMPILER_H
+#define DANG_COMPILER_H
+
+#include "evaluator.h"
+
+// ***************************************************************************************
+// * TYPES
+// ***************************************************************************************
+
+/**
+ * Opcodes of the dang virtual machine
+ *
+ * NOTE: Operands are encoded right after the opcode as big endian u32 values,
+ *       The comment in front of each opcode shows its operands and stack effect
+ */
+typedef enum
+{
+    OP_CONSTANT,      // [u32 const index]         -> value
+    OP_NULL,          //                           -> null
+    OP_TRUE,          //                           -> true
+    OP_FALSE,         //                           -> false
+    OP_POP,           // value                     ->
+    OP_GET,           // [u32 ident const index]   -> value
+    OP_DEFINE,        // [u32 ident const index]   value -> null
+    OP_ADD,           // left right                -> result
+    OP_SUB,           // left right                -> result
+    OP_MUL,           // left right                -> result
+    OP_DIV,           // left right                -> result
+    OP_EQ,            // left right                -> result
+    OP_NEQ,           // left right                -> result
+    OP_LT,            // left right                -> result
+    OP_GT,            // left right                -> result
+    OP_NEG,           // operand                   -> result
+    OP_NOT,           // operand                   -> result
+    OP_JUMP,          // [u32 forward offset]
+    OP_JUMP_IF_FALSE, // [u32 forward offset]      condition ->
+    OP_ARRAY,         // [u32 element count]       elements... -> array
+    OP_HASH,          // [u32 key/value count]     key value... -> hash table
+    OP_INDEX,         // operand index             -> value
+    OP_CLOSURE,       // [u32 proto const index]   -> function
+    OP_CALL,          // [u32 argument count]      function args... -> result
+    OP_TAIL_CALL,     // [u32 argument count]      function args... -> result (replaces the current frame)
+    OP_RETURN,        // value                     ->
+
+    OP__MAX,
+} DOpCode;
+
+typedef struct
+{
+    u8* code;
+    usize count;
+    usize cap;
+
+    DCDynArr constants;
+} DChunk;
+
+/**
+ * Compiled form of a function literal (or the whole program)
+ *
+ * Prototypes are pushed to the compiled objects of the evaluator and freed along with it,
+ * parameters are pointing to the parser owned identifiers and scope is the resolved one
+ */
+struct DFnProto
+{
+    DChunk chunk;
+    DCDynArrPtr parameters;
+    DScopePtr scope;
+};
+
+DCResType(DFnProtoPtr, ResFnProto);
+
+// ***************************************************************************************
+// * FUNCTION DECLARATIONS
+// ***************************************************************************************
+
+ResFnProto dang_compile(DEvaluator* de, DNodeProgram* program);
+DCResVoid dang_fn_proto_free(DFnProtoPtr proto);
+
+string tostr_DOpCode(DOpCode op);
+
+#endif // DANG_COMPILER_H
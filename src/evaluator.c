@@ -15,61 +15,119 @@
 // ***************************************************************************************
 
 #include "evaluator.h"
+#include "gc.h"
+#include "allocator.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "value.h"
+#include "vm.h"
 
 // ***************************************************************************************
 // * MACROS
 // ***************************************************************************************
 
-#define pool_last_el(DE) &dc_da_get2((DE)->pool, (DE)->pool.count - 1)
+/**
+ * The tree walker returns the values directly and keeps the error of the failed evaluation
+ * in the error slot of the evaluator, the callers check the flag right after each call
+ *
+ * NOTE: Results are only built at the boundaries (see `evaluate`), the builtins use the same slot
+ */
+#define eval_failed(DE) ((DE)->failed)
+
+#define eval_ret_if_failed(DE)                                                                                                 \
+    if (eval_failed(DE)) return dc_dv_nullptr()
+
+#define eval_fail(DE, NUM, MSG)                                                                                                \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        dc_error_init((DE)->error, NUM, MSG);                                                                                  \
+        (DE)->failed = true;                                                                                                   \
+    } while (0)
+
+#define eval_faila(DE, NUM, ...)                                                                                               \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        dc_error_inita((DE)->error, NUM, __VA_ARGS__);                                                                         \
+        (DE)->failed = true;                                                                                                   \
+    } while (0)
+
+/**
+ * Moves the error of the failed result to the error slot
+ */
+#define eval_fail_with(DE, RES)                                                                                                \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        (DE)->error = dc_err2(RES);                                                                                            \
+        (DE)->failed = true;                                                                                                   \
+    } while (0)
+
+/**
+ * Declares the result variable initialized with the CALL, in case of errors it performs
+ * the failure actions, moves the error to the error slot and returns FAIL_RET
+ */
+#define eval_try(DE, RES_TYPE, RES, CALL, FAIL_RET, FAILURE_ACTIONS)                                                           \
+    RES_TYPE RES = CALL;                                                                                                       \
+    if (dc_is_err2(RES))                                                                                                       \
+    {                                                                                                                          \
+        FAILURE_ACTIONS;                                                                                                       \
+        eval_fail_with(DE, RES);                                                                                               \
+        return FAIL_RET;                                                                                                       \
+    }
+
+#define eval_try_temp(DE, RES_TYPE, CALL, FAIL_RET)                                                                            \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        RES_TYPE __eval_res = CALL;                                                                                            \
+        if (dc_is_err2(__eval_res))                                                                                            \
+        {                                                                                                                      \
+            eval_fail_with(DE, __eval_res);                                                                                    \
+            return FAIL_RET;                                                                                                   \
+        }                                                                                                                      \
+    } while (0)
 
 // ***************************************************************************************
 // * FORWARD DECLARATIONS
 // ***************************************************************************************
 
-static DCRes perform_evaluation_process(DEvaluator* de, DCDynValPtr dn, DEnv* env);
+static DCDynVal perform_evaluation_process(DEvaluator* de, DCDynValPtr dn, DEnv* env);
 
 // ***************************************************************************************
 // * PRIVATE HELPER FUNCTIONS
 // ***************************************************************************************
 
-static DC_DV_FREE_FN_DECL(evaluator_pool_cleanup)
+static DC_DV_FREE_FN_DECL(evaluator_compiled_cleanup)
 {
     DC_RES_void();
 
-    if (_value->type == dc_dvt(DEnvPtr))
+    if (_value->type == dc_dvt(DScopePtr))
     {
-        DEnvPtr env = dc_dv_as(*_value, DEnvPtr);
+        DScopePtr scope = dc_dv_as(*_value, DScopePtr);
 
-        dc_try_fail(dang_env_free(env));
+        dc_try_fail(dang_scope_free(scope));
 
-        free(env);
+        dc_dealloc(scope, sizeof(DScope));
 
-        dc_dv_set(*_value, DEnvPtr, NULL);
+        dc_dv_set(*_value, DScopePtr, NULL);
     }
 
-    dc_ret();
-}
-
-static u32 string_hash(string key)
-{
-    u32 hash = 5381;
-    i32 c;
-    while ((c = *key++))
+    else if (_value->type == dc_dvt(DFnProtoPtr))
     {
-        hash = ((hash << 5) + hash) + c;
+        dc_try_fail(dang_fn_proto_free(dc_dv_as(*_value, DFnProtoPtr)));
+
+        dc_dv_set(*_value, DFnProtoPtr, NULL);
     }
 
-    return hash;
+    dc_ret();
 }
 
-static u32 bool_hash(b1 key)
+static u32 bool_hash(b1 key, u64 seed)
 {
-    return !!key;
+    return dang_int_hash(key ? 0x9e3779b97f4a7c15ULL : 0x7f4a7c159e3779b9ULL, seed);
 }
 
-static u32 integer_hash(i64 key)
+static u32 integer_hash(i64 key, u64 seed)
 {
-    return key < 0 ? (-1 * key) : key;
+    return dang_int_hash((u64)key, seed);
 }
 
 static DC_HT_HASH_FN_DECL(hash_obj_hash_fn)
@@ -79,13 +137,13 @@ static DC_HT_HASH_FN_DECL(hash_obj_hash_fn)
     switch (_key->type)
     {
         case DO_STRING:
-            dc_ret_ok(string_hash(do_as_string(*_key)));
+            dc_ret_ok(do_string_hash(do_as_string(*_key), _seed));
 
         case DO_INTEGER:
-            dc_ret_ok(integer_hash(do_as_int(*_key)));
+            dc_ret_ok(integer_hash(do_as_int(*_key), _seed));
 
         case DO_BOOLEAN:
-            dc_ret_ok(bool_hash(dc_dv_as(*_key, b1)));
+            dc_ret_ok(bool_hash(dc_dv_as(*_key, b1), _seed));
 
         default:
             break;
@@ -96,32 +154,144 @@ static DC_HT_HASH_FN_DECL(hash_obj_hash_fn)
 
 static DC_HT_KEY_CMP_FN_DECL(hash_obj_hash_key_cmp_fn)
 {
-    return dc_dv_eq(_key1, _key2);
+    return do_eq(_key1, _key2);
 }
 
-static DC_HT_HASH_FN_DECL(env_hash_fn)
+/**
+ * Scopes and builtins are looked up by names that are either interned or plain C strings,
+ * the interned ones are found by their pointer without comparing the text
+ */
+static DC_HT_HASH_FN_DECL(scope_hash_fn)
 {
     DC_RES_u32();
 
-    if (_key->type != DO_STRING) dc_ret_e(dc_e_code(TYPE), dc_e_msg(TYPE));
+    if (_key->type != dc_dvt(string)) dc_ret_e(dc_e_code(TYPE), dc_e_msg(TYPE));
+
+    string name = dc_dv_as(*_key, string);
 
-    dc_ret_ok(string_hash(do_as_string(*_key)));
+    dc_ret_ok(dang_str_hash(name, strlen(name), _seed));
 }
 
 static DC_HT_KEY_CMP_FN_DECL(string_key_cmp)
 {
-    return dc_dv_eq(_key1, _key2);
+    DC_RES_bool();
+
+    string name1 = dc_dv_as(*_key1, string);
+    string name2 = dc_dv_as(*_key2, string);
+
+    dc_ret_ok(name1 == name2 || strcmp(name1, name2) == 0);
 }
 
 // ***************************************************************************************
 // * PRIVATE FUNCTIONS
 // ***************************************************************************************
 
-static ResEnv _env_new()
+/**
+ * Unwraps the value of the result of the shared evaluation functions, the error goes to the error slot
+ */
+static inline DCDynVal eval_take(DEvaluator* de, DCRes res)
+{
+    if (dc_is_ok2(res)) return dc_unwrap2(res);
+
+    eval_fail_with(de, res);
+
+    return dc_dv_nullptr();
+}
+
+/**
+ * Compact value of the resolved identifier, it's undefined if the slot is not defined (see `dang_env_get_resolved`)
+ */
+static inline DValue env_resolved_value(DEnv* env, DNodeIdentifier* ident)
+{
+    DEnv* target = env;
+
+    for (usize i = 0; i < ident->depth && target; ++i)
+        target = target->outer;
+
+    if (target && ident->slot < target->slot_count) return target->slots[ident->slot];
+
+    return DANG_VALUE_UNDEFINED;
+}
+
+static DCResVoid env_reserve_slots(DEnv* env, usize count)
+{
+    DC_RES_void();
+
+    if (count <= env->slot_count) dc_ret();
+
+    // only the function scopes are on the frame stack and they don't grow after being resolved
+    if (env->on_stack) dc_ret_e(-1, "cannot grow an environment on the frame stack");
+
+    DValue* slots = (DValue*)dc_resize(env->slots, env->slot_count * sizeof(DValue), count * sizeof(DValue));
+    if (slots == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    // new slots are not defined until a let statement or a parameter binds them
+    memset(slots + env->slot_count, 0, (count - env->slot_count) * sizeof(DValue));
+
+    env->slots = slots;
+    env->slot_count = count;
+
+    dc_ret();
+}
+
+static void frame_stack_init(DFrameStack* frames)
+{
+    *frames = (DFrameStack){0};
+}
+
+static void frame_stack_free(DFrameStack* frames)
+{
+    for (usize i = 0; i < DANG_FRAME_CHUNKS; ++i)
+        if (frames->chunks[i]) dc_dealloc(frames->chunks[i], DANG_FRAME_CHUNK_SIZE * sizeof(DFrame));
+
+    for (usize i = 0; i < DANG_FRAME_SLOT_CHUNKS; ++i)
+        if (frames->slot_chunks[i]) dc_dealloc(frames->slot_chunks[i], DANG_FRAME_CHUNK_SLOTS * sizeof(DValue));
+
+    *frames = (DFrameStack){0};
+}
+
+/**
+ * Frame for the next environment and the start of its `slot_count` slots, NULL if it doesn't fit
+ *
+ * NOTE: The slots of an environment are never split over two chunks, the rest of the chunk is skipped instead
+ */
+static DFrame* frame_stack_reserve(DFrameStack* frames, usize slot_count, DValue** slots, usize* slot_start)
+{
+    if (frames->count == DANG_FRAME_STACK_SIZE || slot_count > DANG_FRAME_CHUNK_SLOTS) return NULL;
+
+    usize start = frames->slot_count;
+    if (start % DANG_FRAME_CHUNK_SLOTS + slot_count > DANG_FRAME_CHUNK_SLOTS)
+        start += DANG_FRAME_CHUNK_SLOTS - start % DANG_FRAME_CHUNK_SLOTS;
+
+    if (start + slot_count > DANG_FRAME_STACK_SLOTS) return NULL;
+
+    DFrame** chunk = &frames->chunks[frames->count / DANG_FRAME_CHUNK_SIZE];
+    if (*chunk == NULL && (*chunk = (DFrame*)dc_alloc(DANG_FRAME_CHUNK_SIZE * sizeof(DFrame))) == NULL) return NULL;
+
+    *slots = NULL;
+    *slot_start = start;
+
+    if (slot_count == 0) return &(*chunk)[frames->count % DANG_FRAME_CHUNK_SIZE];
+
+    DValue** slot_chunk = &frames->slot_chunks[start / DANG_FRAME_CHUNK_SLOTS];
+    if (*slot_chunk == NULL && (*slot_chunk = (DValue*)dc_alloc(DANG_FRAME_CHUNK_SLOTS * sizeof(DValue))) == NULL)
+        return NULL;
+
+    *slots = *slot_chunk + start % DANG_FRAME_CHUNK_SLOTS;
+
+    return &(*chunk)[frames->count % DANG_FRAME_CHUNK_SIZE];
+}
+
+static ResEnv _env_new(DScopePtr scope)
 {
     DC_RES2(ResEnv);
 
-    DEnv* env = (DEnv*)malloc(sizeof(DEnv));
+    DEnv* env = (DEnv*)dc_alloc(sizeof(DEnv));
     if (env == NULL)
     {
         dc_dbg_log("Memory allocation failed");
@@ -129,60 +299,156 @@ static ResEnv _env_new()
         dc_ret_e(2, "Memory allocation failed");
     }
 
-    dc_try_or_fail_with3(DCResVoid, res, dang_env_init(env), free(env));
+    dc_try_or_fail_with3(DCResVoid, res, dang_env_init(env, scope), dc_dealloc(env, sizeof(DEnv)));
 
     dc_ret_ok(env);
 }
 
-static ResEnv _env_new_enclosed(DEvaluator* de, DEnv* outer)
+ResEnv dang_env_new_enclosed(DEvaluator* de, DScopePtr scope, DEnv* outer)
 {
-    DC_TRY_DEF2(ResEnv, _env_new());
+    DC_TRY_DEF2(ResEnv, _env_new(scope));
 
     dc_unwrap()->outer = outer;
 
-    dc_try_or_fail_with3(DCResVoid, res, dc_da_push(&de->pool, dc_dva(DEnvPtr, dc_unwrap())), {
+    dc_try_or_fail_with3(DCResVoid, res, dang_gc_track(de, dc_dva(DEnvPtr, dc_unwrap())), {
         dc_try_fail_temp(DCResVoid, dang_env_free(dc_unwrap()));
-        free(dc_unwrap());
+        dc_dealloc(dc_unwrap(), sizeof(DEnv));
     });
 
     dc_ret();
 }
 
-static DCRes eval_program_statements(DEvaluator* de, DCDynArrPtr statements, DEnv* env)
+/**
+ * Environment of a call, it's taken from the frame stack when the scope doesn't escape
+ * and there is room left, otherwise it's allocated on the heap and tracked by the garbage collector
+ *
+ * NOTE: Environments on the frame stack must be popped in the reverse order (see `dang_env_pop`)
+ */
+ResEnv dang_env_push(DEvaluator* de, DScopePtr scope, DEnv* outer)
 {
-    DC_RES();
+    DC_RES2(ResEnv);
+
+    DFrameStack* frames = &de->frames;
+    usize slot_count = scope->names.count;
+
+    DValue* slots = NULL;
+    usize slot_start = 0;
+
+    DFrame* frame = scope->escapes ? NULL : frame_stack_reserve(frames, slot_count, &slots, &slot_start);
+    if (frame == NULL) return dang_env_new_enclosed(de, scope, outer);
+
+    frame->index = frames->count++;
+    frame->slot_mark = frames->slot_count;
+
+    DEnv* env = &frame->env;
+
+    env->scope = scope;
+    env->slots = slots;
+    env->slot_count = slot_count;
+    env->outer = outer;
+    env->captured = false;
+    env->on_stack = true;
+    env->gc_flags = 0;
+
+    if (slots) memset(slots, 0, slot_count * sizeof(DValue));
+    frames->slot_count = slot_start + slot_count;
+
+    dc_ret_ok(env);
+}
+
+/**
+ * Called when the call of the environment is done, it pops the environment (and everything above it)
+ * from the frame stack, environments on the heap are left to the garbage collector
+ *
+ * NOTE: A heap environment is written during its call only, if it has been promoted meanwhile
+ * it might hold young values so it gets the write barrier (which ignores the young ones)
+ */
+DCResVoid dang_env_pop(DEvaluator* de, DEnv* env)
+{
+    DC_RES_void();
+
+    if (!env) dc_ret();
+
+    if (!env->on_stack)
+    {
+        dc_try_fail(dang_gc_write_barrier(de, &dc_dv(DEnvPtr, env)));
+
+        dc_ret();
+    }
+
+    // the environment is the first member of its frame
+    DFrame* frame = (DFrame*)env;
+
+    de->frames.count = frame->index;
+    de->frames.slot_count = frame->slot_mark;
+
+    dc_ret();
+}
+
+/**
+ * Environment of a call in a tail position, the environment of the caller is reused (with all the slots
+ * undefined) when it belongs to the same closure and no closure has captured it, otherwise a new one is created
+ *
+ * NOTE: The caller is done when its tail call starts so its environment is popped if it's on the frame stack
+ */
+ResEnv dang_env_new_tail(DEvaluator* de, DEnv* current, DScopePtr scope, DEnv* outer)
+{
+    DC_RES2(ResEnv);
+
+    if (current && !current->captured && current->scope == scope && current->outer == outer)
+    {
+        memset(current->slots, 0, current->slot_count * sizeof(DValue));
+
+        dc_ret_ok(current);
+    }
+
+    dc_try_fail_temp(DCResVoid, dang_env_pop(de, current));
+
+    return dang_env_push(de, scope, outer);
+}
 
-    if (!statements || statements->count == 0) dc_ret_ok_dv_nullptr();
+static DCDynVal eval_program_statements(DEvaluator* de, DCDynArrPtr statements, DEnv* env)
+{
+    DCDynVal result = dc_dv_nullptr();
+
+    if (!statements) return result;
 
     dc_da_for(program_eval_loop, *statements, {
-        dc_try_fail(perform_evaluation_process(de, _it, env));
+        // statement boundaries are the safe points of the tree walker
+        if (dang_gc_should_collect(de)) eval_try_temp(de, DCResVoid, dang_gc_collect(de), dc_dv_nullptr());
 
-        if_dv_is_DoReturn_return_unwrapped();
+        result = perform_evaluation_process(de, _it, env);
+        eval_ret_if_failed(de);
+
+        if (result.type == DO_RETURN) return *(dc_dv_as(result, DoReturn).ret_val);
     });
 
-    dc_ret();
+    return result;
 }
 
-static DCRes eval_block_statements(DEvaluator* de, DCDynArrPtr statements, DEnv* env)
+static DCDynVal eval_block_statements(DEvaluator* de, DCDynArrPtr statements, DEnv* env)
 {
-    DC_RES();
+    DCDynVal result = dc_dv_nullptr();
 
-    if (!statements || statements->count == 0) dc_ret_ok_dv_nullptr();
+    if (!statements) return result;
 
     dc_da_for(block_eval_loop, *statements, {
-        dc_try_fail(perform_evaluation_process(de, _it, env));
+        if (dang_gc_should_collect(de)) eval_try_temp(de, DCResVoid, dang_gc_collect(de), dc_dv_nullptr());
+
+        result = perform_evaluation_process(de, _it, env);
+        eval_ret_if_failed(de);
 
-        if (dc_unwrap().type == DO_RETURN) DC_BREAK(block_eval_loop);
+        if (result.type == DO_RETURN) DC_BREAK(block_eval_loop);
     });
 
-    dc_ret();
+    return result;
 }
 
 static DCRes eval_bang_operator(DCDynValPtr right)
 {
     DC_RES();
 
-    dc_try_or_fail_with3(DCResBool, bool_val, dc_dv_to_bool(right), {});
+    dc_try_or_fail_with3(DCResBool, bool_val, do_to_bool(right), {});
 
     dc_ret_ok_dv_bool(!dc_unwrap2(bool_val));
 }
@@ -196,108 +462,212 @@ static DCRes eval_minus_prefix_operator(DCDynValPtr right)
     dc_ret_ok(do_int(-do_as_int(*right)));
 }
 
-static DCRes eval_prefix_expression(string op, DCDynValPtr operand)
+DCRes dang_eval_prefix(DOperator op, DCDynValPtr operand)
 {
     DC_RES();
 
-    if (strcmp(op, "!") == 0)
-        return eval_bang_operator(operand);
+    switch (op)
+    {
+        case DOP_NOT:
+            return eval_bang_operator(operand);
 
-    else if (strcmp(op, "-") == 0)
-        return eval_minus_prefix_operator(operand);
+        case DOP_NEG:
+            return eval_minus_prefix_operator(operand);
 
+        default:
+            break;
+    };
 
-    dc_ret_ea(-1, "unimplemented infix operator '%s'", op);
+    dc_ret_ea(-1, "unimplemented prefix operator '%s'", tostr_DOperator(op));
 }
 
-static DCRes eval_integer_infix_expression(string op, DCDynValPtr left, DCDynValPtr right)
+static DCRes eval_integer_infix_expression(DOperator op, DCDynValPtr left, DCDynValPtr right)
 {
     DC_RES();
 
     i64 lval = do_as_int(*left);
     i64 rval = do_as_int(*right);
 
-    DCDynVal value = {0};
+    switch (op)
+    {
+        case DOP_ADD:
+            dc_ret_ok(do_int(lval + rval));
 
-    if (strcmp(op, "+") == 0)
-        value = dc_dv(i64, (lval + rval));
+        case DOP_SUB:
+            dc_ret_ok(do_int(lval - rval));
 
-    else if (strcmp(op, "-") == 0)
-        value = dc_dv(i64, (lval - rval));
+        case DOP_MUL:
+            dc_ret_ok(do_int(lval * rval));
 
-    else if (strcmp(op, "*") == 0)
-        value = dc_dv(i64, (lval * rval));
+        case DOP_DIV:
+            if (rval == 0) dc_ret_e(-1, "division by zero");
+            if (rval == -1 && lval == INT64_MIN) dc_ret_e(-1, "integer overflow in division");
 
-    else if (strcmp(op, "/") == 0)
-        value = dc_dv(i64, (lval / rval));
+            dc_ret_ok(do_int(lval / rval));
 
-    else if (strcmp(op, "<") == 0)
-        dc_ret_ok_dv_bool(lval < rval);
+        case DOP_LT:
+            dc_ret_ok_dv_bool(lval < rval);
 
-    else if (strcmp(op, ">") == 0)
-        dc_ret_ok_dv_bool(lval > rval);
+        case DOP_GT:
+            dc_ret_ok_dv_bool(lval > rval);
 
-    else if (strcmp(op, "==") == 0)
-        dc_ret_ok_dv_bool(lval == rval);
+        case DOP_EQ:
+            dc_ret_ok_dv_bool(lval == rval);
 
-    else if (strcmp(op, "!=") == 0)
-        dc_ret_ok_dv_bool(lval != rval);
+        case DOP_NEQ:
+            dc_ret_ok_dv_bool(lval != rval);
 
-    else
-        dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", op, dv_type_tostr(left), dv_type_tostr(right));
+        default:
+            break;
+    };
 
-    dc_ret_ok(value);
+    dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", tostr_DOperator(op), dv_type_tostr(left),
+              dv_type_tostr(right));
 }
 
-static DCRes eval_boolean_infix_expression(string op, DCDynValPtr left, DCDynValPtr right)
+static DCRes eval_boolean_infix_expression(DOperator op, DCDynValPtr left, DCDynValPtr right)
 {
     DC_RES();
 
-    dc_try_or_fail_with3(DCResBool, lval_bool, dc_dv_to_bool(left), {});
-    dc_try_or_fail_with3(DCResBool, rval_bool, dc_dv_to_bool(right), {});
+    dc_try_or_fail_with3(DCResBool, lval_bool, do_to_bool(left), {});
+    dc_try_or_fail_with3(DCResBool, rval_bool, do_to_bool(right), {});
 
     b1 lval = dc_unwrap2(lval_bool);
     b1 rval = dc_unwrap2(rval_bool);
 
-    if (strcmp(op, "==") == 0)
-        dc_ret_ok_dv_bool(lval == rval);
+    switch (op)
+    {
+        case DOP_EQ:
+            dc_ret_ok_dv_bool(lval == rval);
+
+        case DOP_NEQ:
+            dc_ret_ok_dv_bool(lval != rval);
+
+        default:
+            break;
+    };
+
+    dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", tostr_DOperator(op), dv_type_tostr(left),
+              dv_type_tostr(right));
+}
+
+/**
+ * Allocates a string buffer with room for `cap` bytes and hands it over to the collector
+ */
+static DCResVoidptr string_buffer_new(DEvaluator* de, usize cap)
+{
+    DC_RES_voidptr();
+
+    DStringBufferPtr buf = (DStringBufferPtr)dc_alloc(sizeof(DStringBuffer) + cap + 1);
+    if (buf == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    buf->data[0] = '\0';
+    buf->len = 0;
+    buf->cap = cap;
+    buf->hash_len = 0;
+    buf->hash_seed = 0;
+    buf->hash = dang_str_hash(buf->data, 0, 0);
+    buf->gc_flags = 0;
+
+    dc_try_or_fail_with3(DCResVoid, res, dang_gc_track(de, dc_dva(DStringBufferPtr, buf)), {
+        dc_dbg_log("failed to track the string buffer");
+        dc_dealloc(buf, sizeof(DStringBuffer) + cap + 1);
+    });
+
+    dc_ret_ok(buf);
+}
+
+/**
+ * Appends the right string to the left one, in place when the left string is the written part
+ * of its buffer and there's room for the right one, so accumulating a string is amortized O(len(piece))
+ *
+ * NOTE: Otherwise the result gets a new buffer with twice the room it needs for the next appends
+ */
+static DCRes string_concat(DEvaluator* de, DoString left, DoString right)
+{
+    DC_RES();
+
+    if (right.len == 0) dc_ret_ok_dv(DoString, left);
 
-    else if (strcmp(op, "!=") == 0)
-        dc_ret_ok_dv_bool(lval != rval);
+    usize len = left.len + right.len;
+    DStringBufferPtr buf = left.buf;
 
-    dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", op, dv_type_tostr(left), dv_type_tostr(right));
+    if (!buf || buf->len != left.len || buf->cap < len)
+    {
+        usize cap = len * 2 > DANG_STRING_MIN_CAPACITY ? len * 2 : DANG_STRING_MIN_CAPACITY;
+
+        dc_try_or_fail_with3(DCResVoidptr, buf_res, string_buffer_new(de, cap), {});
+
+        buf = (DStringBufferPtr)dc_unwrap2(buf_res);
+
+        memcpy(buf->data, left.str, left.len);
+        buf->len = left.len;
+    }
+
+    memcpy(buf->data + buf->len, right.str, right.len);
+    buf->len = len;
+    buf->data[len] = '\0';
+
+    dc_ret_ok_dv(DoString, do_string_of(buf->data, len, buf));
 }
 
-static DCRes eval_string_infix_expression(DEvaluator* de, string op, DCDynValPtr left, DCDynValPtr right)
+static DCRes eval_string_infix_expression(DEvaluator* de, DOperator op, DCDynValPtr left, DCDynValPtr right)
 {
     DC_RES();
 
-    string lval = do_as_string(*left);
-    string rval = do_as_string(*right);
+    DoString lval = do_as_string(*left);
+    DoString rval = do_as_string(*right);
 
-    if (strcmp(op, "+") == 0)
+    switch (op)
     {
-        string result;
-        dc_sprintf(&result, "%s%s", lval, rval);
+        case DOP_ADD:
+            return string_concat(de, lval, rval);
 
-        if (result)
+        case DOP_EQ:
         {
-            dc_try_or_fail_with3(DCResVoid, res, dc_da_push(&de->pool, dc_dva(string, result)), {
-                dc_dbg_log("failed to push result array to the pool");
-                free(result);
-            });
+            dc_try_or_fail_with3(DCResBool, eq_res, do_eq(left, right), {});
+
+            dc_ret_ok_dv_bool(dc_unwrap2(eq_res));
         }
 
-        dc_ret_ok_dv(string, result);
-    }
+        default:
+            break;
+    };
+
+    dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", tostr_DOperator(op), dv_type_tostr(left),
+              dv_type_tostr(right));
+}
+
+/**
+ * The other operand of a string is converted to its string representation
+ */
+static DCRes eval_mixed_string_infix_expression(DEvaluator* de, DOperator op, DCDynValPtr left, DCDynValPtr right)
+{
+    DC_RES();
+
+    DCDynValPtr other = do_is_string(*left) ? right : left;
+
+    dc_try_or_fail_with3(DCResString, converted_res, do_tostr(other), {});
+
+    string converted = dc_unwrap2(converted_res);
+
+    DCDynVal converted_str = dc_dv(DoString, do_string_of(converted, converted ? strlen(converted) : 0, NULL));
 
-    else if (strcmp(op, "==") == 0)
-        dc_ret_ok_dv_bool(strcmp(lval, rval) == 0);
+    DCRes res = other == right ? eval_string_infix_expression(de, op, left, &converted_str)
+                               : eval_string_infix_expression(de, op, &converted_str, right);
 
-    dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", op, dv_type_tostr(left), dv_type_tostr(right));
+    // the result never refers to the converted string (see `string_concat`)
+    dc_sfree(converted);
+
+    return res;
 }
 
-static DCRes eval_infix_expression(DEvaluator* de, string op, DCDynValPtr left, DCDynValPtr right)
+DCRes dang_eval_infix(DEvaluator* de, DOperator op, DCDynValPtr left, DCDynValPtr right)
 {
     DC_RES();
 
@@ -312,29 +682,11 @@ static DCRes eval_infix_expression(DEvaluator* de, string op, DCDynValPtr left,
     else if (do_is_string(*right) && do_is_string(*left))
         return eval_string_infix_expression(de, op, left, right);
 
-    else if (do_is_string(*left) && strcmp(op, "==") != 0)
-    {
-        DCDynVal right_converted = dc_dva(string, dc_unwrap2(dc_tostr_dv(right)));
-        DCRes res = eval_string_infix_expression(de, op, left, &right_converted);
-
-        // free the allocated string (in conversion)
-        dc_dv_free(&right_converted, NULL);
-
-        return res;
-    }
-
-    else if (do_is_string(*right) && strcmp(op, "==") != 0)
-    {
-        DCDynVal left_converted = dc_dva(string, dc_unwrap2(dc_tostr_dv(left)));
-        DCRes res = eval_string_infix_expression(de, op, &left_converted, right);
-
-        // free the allocated string (in conversion)
-        dc_dv_free(&left_converted, NULL);
+    else if ((do_is_string(*left) || do_is_string(*right)) && op != DOP_EQ)
+        return eval_mixed_string_infix_expression(de, op, left, right);
 
-        return res;
-    }
-
-    dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", op, dv_type_tostr(left), dv_type_tostr(right));
+    dc_ret_ea(-1, "unimplemented infix operator '%s' for '%s' and '%s'", tostr_DOperator(op), dv_type_tostr(left),
+              dv_type_tostr(right));
 }
 
 static DCRes eval_array_index_expression(DCDynValPtr left, DCDynValPtr index)
@@ -342,11 +694,11 @@ static DCRes eval_array_index_expression(DCDynValPtr left, DCDynValPtr index)
     DC_RES();
 
     usize idx = (usize)(do_as_int(*index));
-    DCDynArrPtr arr = dc_dv_as(*left, DCDynArrPtr);
+    DArrayPtr arr = do_as_array(*left);
 
-    if (idx > arr->count - 1) dc_ret_ok_dv_nullptr();
+    if (idx >= arr->count) dc_ret_ok_dv_nullptr();
 
-    dc_ret_ok(dc_da_get2(*arr, idx));
+    dc_ret_ok(dang_array_get(arr, idx));
 }
 
 static DCRes eval_hash_index_expression(DCDynValPtr left, DCDynValPtr index)
@@ -363,154 +715,342 @@ static DCRes eval_hash_index_expression(DCDynValPtr left, DCDynValPtr index)
     dc_ret_ok(*found);
 }
 
-static DCRes eval_if_expression(DEvaluator* de, DNodeIfExpression* if_node, DEnv* env)
+DCRes dang_eval_index(DCDynValPtr operand, DCDynValPtr index)
 {
     DC_RES();
 
-    dc_try_or_fail_with3(DCRes, condition_evaluated, perform_evaluation_process(de, if_node->condition, env), {});
+    if (operand->type != DO_ARRAY && operand->type != DO_HASH_TABLE)
+    {
+        dc_dbg_log("indexing of '%s' is not supporting on '%s'", dv_type_tostr(index), dv_type_tostr(operand));
+        dc_ret_e(-1, "indexing is not supporting on this type");
+    }
 
-    dc_try_or_fail_with3(DCResBool, condition_as_bool, dc_dv_to_bool(&dc_unwrap2(condition_evaluated)), {});
+    else if (operand->type == DO_ARRAY && index->type != DO_INTEGER)
+    {
+        dc_dbg_log("indexing of '%s' is not supporting on '%s'", dv_type_tostr(index), dv_type_tostr(operand));
+        dc_ret_e(-1, "indexing is not supporting on this type");
+    }
 
-    if (dc_unwrap2(condition_as_bool))
-        return perform_evaluation_process(de, &dc_dv(DNodeBlockStatement, dn_block(if_node->consequence)), env);
+    if (index->type == DO_INTEGER && do_as_int(*index) < 0) dc_ret_ok_dv_nullptr();
 
-    else if (if_node->alternative)
-        return perform_evaluation_process(de, &dc_dv(DNodeBlockStatement, dn_block(if_node->alternative)), env);
+    if (operand->type == DO_ARRAY) return eval_array_index_expression(operand, index);
 
-    dc_ret_ok_dv_nullptr();
+    return eval_hash_index_expression(operand, index);
 }
 
-static DCRes eval_let_statement(DEvaluator* de, DNodeLetStatement* let_node, DEnv* env)
+/**
+ * Makes a new (untracked) hash table object with room for `capacity` pairs,
+ * it's seeded with the hash seed of the evaluator
+ */
+DCResHt dang_hash_table_new(DEvaluator* de, usize capacity)
 {
-    DC_RES();
-
-    DCDynVal value = de->nullptr;
-    if (let_node->value)
-    {
-        dc_try_or_fail_with3(DCRes, v_res, perform_evaluation_process(de, let_node->value, env), {});
+    DC_RES_ht();
 
-        value = dc_unwrap2(v_res);
-    }
+    dc_try_or_fail_with3(DCResHt, ht_res, dc_ht_new(capacity, hash_obj_hash_fn, hash_obj_hash_key_cmp_fn, NULL), {});
 
-    dc_try_fail_temp(DCRes, dang_env_set(env, let_node->name, &value, false));
+    // it's empty, so nothing has to be moved
+    dc_unwrap2(ht_res)->seed = de->hash_seed;
 
-    dc_ret_ok_dv_nullptr();
+    dc_ret_ok(dc_unwrap2(ht_res));
 }
 
-static DCRes eval_hash_literal(DEvaluator* de, DNodeHashTableLiteral* ht_node, DEnv* env)
+/**
+ * Makes a new array object of `count` elements of the storage starting at `offset`
+ *
+ * NOTE: The storage must already be tracked by the garbage collector
+ */
+DCRes dang_array_new(DEvaluator* de, DArrayStoragePtr storage, usize offset, usize count)
 {
     DC_RES();
 
-    if (ht_node->key_values->count % 2 != 0) dc_ret_e(-1, "wrong hash literal node");
-
-    dc_try_or_fail_with3(DCResHt, ht_res, dc_ht_new(17, hash_obj_hash_fn, hash_obj_hash_key_cmp_fn, NULL), {});
-
-    DCHashTablePtr ht = dc_unwrap2(ht_res);
-
-    dc_da_for(hash_lit_eval_loop, *ht_node->key_values, {
-        if (_idx % 2 != 0) continue; // odd numbers are values
+    DArrayPtr arr = (DArrayPtr)dc_alloc(sizeof(DArray));
+    if (arr == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
 
-        // this child is the key
-        dc_try_or_fail_with3(DCRes, key_obj, perform_evaluation_process(de, _it, env), {
-            dc_try_fail_temp(DCResVoid, dc_ht_free(ht));
-            free(ht);
-        });
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
 
-        // next child is the value
-        dc_try_or_fail_with3(DCRes, value_obj, perform_evaluation_process(de, _it + 1, env), {
-            dc_try_fail_temp(DCResVoid, dc_ht_free(ht));
-            free(ht);
-        });
-
-        dc_try_or_fail_with3(DCResVoid, res,
-                             dc_ht_set(ht, dc_unwrap2(key_obj), dc_unwrap2(value_obj), DC_HT_SET_CREATE_OR_UPDATE), {
-                                 dc_try_fail_temp(DCResVoid, dc_ht_free(ht));
-                                 free(ht);
-                             });
-    });
+    arr->storage = storage;
+    arr->offset = offset;
+    arr->count = count;
+    arr->gc_flags = 0;
 
-    dc_try_or_fail_with3(DCResVoid, res, dc_da_push(&de->pool, dc_dva(DCHashTablePtr, ht)), {
-        dc_dbg_log("failed to push result array to the pool");
-        dc_try_fail_temp(DCResVoid, dc_ht_free(ht));
-        free(ht);
+    dc_try_or_fail_with3(DCResVoid, res, dang_gc_track(de, dc_dva(DArrayPtr, arr)), {
+        dc_dbg_log("failed to track the array");
+        dc_dealloc(arr, sizeof(DArray));
     });
 
-    dc_ret_ok_dv(DCHashTablePtr, ht);
+    dc_ret_ok_dv(DArrayPtr, arr);
 }
 
-static DCResDa eval_children_nodes(DEvaluator* de, DCDynArrPtr source, DEnv* env)
+static DCDynVal eval_if_expression(DEvaluator* de, DNodeIfExpression* if_node, DEnv* env)
 {
-    DC_RES_da();
+    DCDynVal condition = perform_evaluation_process(de, if_node->condition, env);
+    eval_ret_if_failed(de);
+
+    eval_try(de, DCResBool, condition_as_bool, do_to_bool(&condition), dc_dv_nullptr(), {});
+
+    if (dc_unwrap2(condition_as_bool))
+        return perform_evaluation_process(de, &dc_dv(DNodeBlockStatement, dn_block(if_node->consequence)), env);
+
+    else if (if_node->alternative)
+        return perform_evaluation_process(de, &dc_dv(DNodeBlockStatement, dn_block(if_node->alternative)), env);
 
-    dc_try_fail(dc_da_new2(10, 3, NULL));
+    return dc_dv_nullptr();
+}
 
-    // first child is the function identifier or expression
-    // the rest is function argument
-    for (usize i = 0; i < source->count; ++i)
+static DCDynVal eval_let_statement(DEvaluator* de, DNodeLetStatement* let_node, DEnv* env)
+{
+    DCDynVal value = de->nullptr;
+    if (let_node->value)
     {
-        dc_try_or_fail_with3(DCRes, arg_res, perform_evaluation_process(de, &dc_da_get2(*source, i), env), {
-            dc_dbg_log("failed to evaluate the child from source");
-            dc_try_fail_temp(DCResVoid, dc_da_free(dc_unwrap()));
-            free(dc_unwrap());
-        });
-
-        dc_try_or_fail_with3(DCResVoid, res, dc_da_push(dc_unwrap(), dc_unwrap2(arg_res)), {
-            dc_dbg_log("failed to push object to result dynamic array");
-            dc_try_fail_temp(DCResVoid, dc_da_free(dc_unwrap()));
-            free(dc_unwrap());
-        });
+        value = perform_evaluation_process(de, let_node->value, env);
+        eval_ret_if_failed(de);
     }
 
-    dc_try_or_fail_with3(DCResVoid, res, dc_da_push(&de->pool, dc_dva(DCDynArrPtr, dc_unwrap())), {
-        dc_dbg_log("failed to push result array to the pool");
-        dc_try_fail_temp(DCResVoid, dc_da_free(dc_unwrap()));
-        free(dc_unwrap());
-    });
+    eval_try_temp(de, DCRes, dang_env_define(de, env, let_node->slot, let_node->name, &value), dc_dv_nullptr());
 
-    dc_ret();
+    return dc_dv_nullptr();
 }
 
-static ResEnv extend_function_env(DEvaluator* de, DCDynValPtr call_obj, DCDynArrPtr params)
+static DCDynVal eval_hash_literal(DEvaluator* de, DNodeHashTableLiteral* ht_node, DEnv* env)
 {
-    DC_TRY_DEF2(ResEnv, _env_new_enclosed(de, call_obj->env));
+    if (ht_node->key_values->count % 2 != 0)
+    {
+        eval_fail(de, -1, "wrong hash literal node");
+        return dc_dv_nullptr();
+    }
 
-    DCDynArrPtr arr = dc_dv_as(*call_obj, DCDynArrPtr);
+    eval_try(de, DCResHt, ht_res, dang_hash_table_new(de, ht_node->key_values->count / 2), dc_dv_nullptr(), {});
 
-    if (arr->count != params->count)
-        dc_ret_ea(-1, "function needs " dc_fmt(usize) " arguments, got=" dc_fmt(usize), params->count, arr->count);
+    DCHashTablePtr ht = dc_unwrap2(ht_res);
 
-    // extending the environment by defining arguments
-    // with given evaluated objects assigning to them
-    dc_da_for(extend_env_loop, *params, {
-        string arg_name = dc_dv_as(*_it, DNodeIdentifier).value;
+    eval_try(de, DCResVoid, res, dang_gc_track(de, dc_dva(DCHashTablePtr, ht)), dc_dv_nullptr(), {
+        dc_dbg_log("failed to track the result hash table");
+        dc_ht_free(ht);
+        dc_dealloc(ht, sizeof(DCHashTable));
+    });
+
+    // the hash table is owned by the collector from now on, it's rooted while it's being filled
+    DCDynVal result = dc_dv(DCHashTablePtr, ht);
+
+    usize roots_mark = dang_gc_roots_mark(de);
+    eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &result), dc_dv_nullptr());
+
+    dc_da_for(hash_lit_eval_loop, *ht_node->key_values, {
+        if (_idx % 2 != 0) continue; // odd numbers are values
+
+        // this child is the key
+        DCDynVal key_obj = perform_evaluation_process(de, _it, env);
+        eval_ret_if_failed(de);
 
-        dc_try_fail_temp(DCRes, dang_env_set(dc_unwrap(), arg_name, &dc_da_get2(*arr, _idx), false));
+        usize key_mark = dang_gc_roots_mark(de);
+        eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &key_obj), dc_dv_nullptr());
+
+        // next child is the value
+        DCDynVal value_obj = perform_evaluation_process(de, _it + 1, env);
+        eval_ret_if_failed(de);
+
+        DCPairPtr entry = NULL;
+        eval_try_temp(de, DCResBool, dc_ht_entry(ht, key_obj, &entry), dc_dv_nullptr());
+
+        entry->second = value_obj;
+
+        dang_gc_roots_restore(de, key_mark);
     });
 
-    dc_ret();
+    dang_gc_roots_restore(de, roots_mark);
+
+    // it's old now if it has been promoted while being filled
+    eval_try_temp(de, DCResVoid, dang_gc_write_barrier(de, &result), dc_dv_nullptr());
+
+    return result;
 }
 
 /**
- * fn_obj's node is a pointer to the "fn" declaration node that has been saved in the env
- * fn_obj's node's children are arguments except the last one that is the body
- * call_obj holds all the evaluated object arguments in its children field
- * call_obj holds current env as well
+ * Evaluates the elements into a new (tracked) storage, returns NULL in case of errors
  */
-static DCRes apply_function(DEvaluator* de, DCDynValPtr call_obj, DNodeFunctionLiteral* fn)
+static DArrayStoragePtr eval_array_elements(DEvaluator* de, DCDynArrPtr source, DEnv* env)
 {
-    DC_RES();
+    usize count = source ? source->count : 0;
 
-    dc_try_or_fail_with3(ResEnv, fn_env_res, extend_function_env(de, call_obj, fn->parameters), {});
+    eval_try(de, ResStorage, storage_res, dang_storage_new(de, count), NULL, {});
 
-    DEnv* fn_env = dc_unwrap2(fn_env_res);
+    DArrayStoragePtr storage = dc_unwrap2(storage_res);
 
-    dc_try_fail(perform_evaluation_process(de, &dc_dv(DNodeBlockStatement, dn_block(fn->body)), fn_env));
+    // the storage is owned by the collector from now on, it's rooted while it's being filled
+    DCDynVal result = dc_dv(DArrayStoragePtr, storage);
 
-    // if we've returned of a function that's ok
-    // but we don't need to pass it on to the upper level
-    if_dv_is_DoReturn_return_unwrapped();
+    usize roots_mark = dang_gc_roots_mark(de);
+    eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &result), NULL);
 
-    dc_ret();
+    for (usize i = 0; i < count; ++i)
+    {
+        DCDynVal element = perform_evaluation_process(de, &dc_da_get2(*source, i), env);
+        if (eval_failed(de))
+        {
+            dc_dbg_log("failed to evaluate the element from source");
+            return NULL;
+        }
+
+        eval_try(de, DCResVoid, push_res, dang_storage_push(de, storage, &element), NULL,
+                 { dc_dbg_log("failed to push object to result storage"); });
+    }
+
+    dang_gc_roots_restore(de, roots_mark);
+
+    // it's old now if it has been promoted while being filled
+    eval_try_temp(de, DCResVoid, dang_gc_write_barrier(de, &result), NULL);
+
+    return storage;
+}
+
+/**
+ * Evaluates the arguments of the builtin and tail calls on the scratch stack of the temporary arena,
+ * they're roots while they're there and the caller drops them (at the mark taken before) once they're consumed
+ */
+static void eval_arguments(DEvaluator* de, DCDynArrPtr source, DEnv* env)
+{
+    for (usize i = 0; source && i < source->count; ++i)
+    {
+        DCDynVal arg = perform_evaluation_process(de, &dc_da_get2(*source, i), env);
+        if (eval_failed(de)) return;
+
+        DCResVoid res = dang_arena_list_push(&de->temp, arg);
+        if (dc_is_err2(res))
+        {
+            eval_fail_with(de, res);
+            return;
+        }
+    }
+}
+
+/**
+ * View over the arguments that are pushed to the scratch stack since the mark, it's invalid after the next push
+ */
+static DCDynArr temp_arguments(DEvaluator* de, usize mark)
+{
+    usize count = de->temp.scratch.count - mark;
+
+    return (DCDynArr){
+        .elements = &de->temp.scratch.elements[mark], .cap = count, .count = count, .multiplier = 1, .element_free_fn = NULL};
+}
+
+/**
+ * `current` is the environment of the caller when the call is in a tail position, returns NULL in case of errors
+ */
+static DEnv* extend_function_env(DEvaluator* de, DEnv* current, DoFunction fn_obj, DCDynArrPtr arr)
+{
+    DCDynArrPtr params = fn_obj.fn->parameters;
+
+    if (arr->count != params->count)
+    {
+        eval_faila(de, -1, "function needs " dc_fmt(usize) " arguments, got=" dc_fmt(usize), params->count, arr->count);
+        return NULL;
+    }
+
+    eval_try(de, ResEnv, env_res, dang_env_new_tail(de, current, fn_obj.fn->scope, fn_obj.env), NULL, {});
+
+    DEnv* fn_env = dc_unwrap2(env_res);
+
+    // extending the environment by defining arguments
+    // with given evaluated objects assigning to them
+    dc_da_for(extend_env_loop, *params, {
+        DNodeIdentifier param = dc_dv_as(*_it, DNodeIdentifier);
+
+        eval_try_temp(de, DCRes, dang_env_define(de, fn_env, param.slot, param.value, &dc_da_get2(*arr, _idx)), NULL);
+    });
+
+    return fn_env;
+}
+
+/**
+ * Creates the environment of the call and evaluates the arguments (in the environment of the caller)
+ * right into its slots, so the call doesn't need any temporary array
+ *
+ * NOTE: Calls made while evaluating the arguments are pushed on top of the new environment
+ * and popped before it's used, the frame stack keeps the evaluated arguments alive
+ */
+static DEnv* bind_arguments(DEvaluator* de, DoFunction fn_obj, DCDynArrPtr arguments, DEnv* env)
+{
+    DCDynArrPtr params = fn_obj.fn->parameters;
+    usize argc = arguments ? arguments->count : 0;
+
+    if (argc != params->count)
+    {
+        eval_faila(de, -1, "function needs " dc_fmt(usize) " arguments, got=" dc_fmt(usize), params->count, argc);
+        return NULL;
+    }
+
+    eval_try(de, ResEnv, env_res, dang_env_push(de, fn_obj.fn->scope, fn_obj.env), NULL, {});
+
+    DEnv* fn_env = dc_unwrap2(env_res);
+
+    usize roots_mark = dang_gc_roots_mark(de);
+    if (!fn_env->on_stack) eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &dc_dv(DEnvPtr, fn_env)), NULL);
+
+    dc_da_for(bind_arguments_loop, *params, {
+        DNodeIdentifier param = dc_dv_as(*_it, DNodeIdentifier);
+
+        DCDynVal arg = perform_evaluation_process(de, &dc_da_get2(*arguments, _idx), env);
+        if (eval_failed(de)) return NULL;
+
+        eval_try_temp(de, DCRes, dang_env_define(de, fn_env, param.slot, param.value, &arg), NULL);
+    });
+
+    dang_gc_roots_restore(de, roots_mark);
+
+    return fn_env;
+}
+
+/**
+ * fn_obj holds a pointer to the "fn" declaration node and the environment it's been evaluated in
+ * fn_env is the environment of the call with all the arguments bound (see `bind_arguments`)
+ * calls in tail position of the body are returned as `DoTailCall` and performed in a loop
+ * reusing the environment when possible
+ */
+static DCDynVal apply_function(DEvaluator* de, DoFunction fn_obj, DEnv* fn_env)
+{
+    DoFunction current_fn = fn_obj;
+    DCDynVal result;
+
+    usize roots_mark = dang_gc_roots_mark(de);
+    usize temp_mark = dang_arena_list_mark(&de->temp);
+
+    while (true)
+    {
+        // the environment of an active call is a root until the call returns (the frame stack is always a root)
+        dang_gc_roots_restore(de, roots_mark);
+        if (!fn_env->on_stack) eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &dc_dv(DEnvPtr, fn_env)), dc_dv_nullptr());
+
+        result = perform_evaluation_process(de, &dc_dv(DNodeBlockStatement, dn_block(current_fn.fn->body)), fn_env);
+        eval_ret_if_failed(de);
+
+        // if we've returned of a function that's ok
+        // but we don't need to pass it on to the upper level
+        if (result.type == DO_RETURN) result = *(dc_dv_as(result, DoReturn).ret_val);
+
+        if (result.type != DO_TAIL_CALL) break;
+
+        // calls in tail position are performed right here, so the C stack doesn't grow
+        DoTailCall tail_call = dc_dv_as(result, DoTailCall);
+
+        current_fn = dc_dv_as(*tail_call.fn, DoFunction);
+
+        DEnv* next_env = extend_function_env(de, fn_env, current_fn, tail_call.arguments);
+        eval_ret_if_failed(de);
+
+        // the arguments are in the environment now
+        dang_arena_list_drop(&de->temp, temp_mark);
+
+        fn_env = next_env;
+    }
+
+    dang_gc_roots_restore(de, roots_mark);
+    eval_try_temp(de, DCResVoid, dang_env_pop(de, fn_env), dc_dv_nullptr());
+
+    return result;
 }
 
 // ***************************************************************************************
@@ -535,11 +1075,11 @@ static DECL_DBUILTIN_FUNCTION(len)
 
     if (arg.type == DO_STRING)
     {
-        if (do_as_string(arg)) len = (i64)strlen(do_as_string(arg));
+        len = (i64)do_as_string(arg).len;
     }
     else if (arg.type == DO_ARRAY)
     {
-        len = (i64)dc_dv_as(arg, DCDynArrPtr)->count;
+        len = (i64)do_as_array(arg)->count;
     }
 
     return do_int(len);
@@ -553,11 +1093,11 @@ static DECL_DBUILTIN_FUNCTION(first)
 
     BUILTIN_FN_GET_ARG_NO(0, DO_ARRAY, "first argument must be an array");
 
-    DCDynArr arr = *dc_dv_as(arg0, DCDynArrPtr);
+    DArrayPtr arr = do_as_array(arg0);
 
-    if (arr.count == 0) return dc_dv_nullptr();
+    if (arr->count == 0) return dc_dv_nullptr();
 
-    return dc_da_get2(arr, 0);
+    return dang_array_get(arr, 0);
 }
 
 static DECL_DBUILTIN_FUNCTION(last)
@@ -568,68 +1108,321 @@ static DECL_DBUILTIN_FUNCTION(last)
 
     BUILTIN_FN_GET_ARG_NO(0, DO_ARRAY, "first argument must be an array");
 
-    DCDynArr arr = *dc_dv_as(arg0, DCDynArrPtr);
+    DArrayPtr arr = do_as_array(arg0);
 
-    if (arr.count == 0) return dc_dv_nullptr();
+    if (arr->count == 0) return dc_dv_nullptr();
 
-    return dc_da_get2(arr, arr.count - 1);
+    return dang_array_get(arr, arr->count - 1);
 }
 
+/**
+ * The result shares the storage of the array so it's O(1) no matter how long the array is
+ */
 static DECL_DBUILTIN_FUNCTION(rest)
 {
-    (void)de;
-
     BUILTIN_FN_GET_ARGS_VALIDATE("rest", 1);
 
     BUILTIN_FN_GET_ARG_NO(0, DO_ARRAY, "first argument must be an array");
 
-    DCDynArr arr = *dc_dv_as(arg0, DCDynArrPtr);
+    DArrayPtr arr = do_as_array(arg0);
 
-    if (arr.count == 0) return dc_dv_nullptr();
+    if (arr->count == 0) return dc_dv_nullptr();
 
-    DCResDa res = dc_da_new2(10, 3, NULL);
+    DCRes res = dang_array_new(de, arr->storage, arr->offset + 1, arr->count - 1);
     if (dc_is_err2(res))
     {
         *error = dc_err2(res);
         return dc_dv_nullptr();
     }
 
-    DCDynArrPtr result_arr = dc_unwrap2(res);
+    return dc_unwrap2(res);
+}
+
+/**
+ * Elements of the array from `start` up to (not including) `end`, both are clamped to the array
+ * and the result shares the storage of the array so it's O(1) as well
+ */
+static DECL_DBUILTIN_FUNCTION(slice)
+{
+    BUILTIN_FN_GET_ARGS_VALIDATE("slice", 3);
 
-    dc_da_for(rest_fn_loop, arr, {
-        // not the first child but the rest
-        if (_idx == 0) continue;
+    BUILTIN_FN_GET_ARG_NO(0, DO_ARRAY, "first argument must be an array");
+    BUILTIN_FN_GET_ARG_NO(1, DO_INTEGER, "second argument must be an integer");
+    BUILTIN_FN_GET_ARG_NO(2, DO_INTEGER, "third argument must be an integer");
 
-        dc_da_push(result_arr, *_it);
-    });
+    DArrayPtr arr = do_as_array(arg0);
 
-    DCResVoid push_res = dc_da_push(&de->pool, dc_dva(DCDynArrPtr, result_arr));
-    if (dc_is_err2(push_res))
-    {
-        dc_error_init(*error, -1, "'rest' error: cannot push the result array to the pool");
+    i64 count = (i64)arr->count;
+    i64 start = do_as_int(arg1);
+    i64 end = do_as_int(arg2);
 
-        dc_da_free(result_arr);
-        free(result_arr);
+    if (start < 0) start = 0;
+    if (start > count) start = count;
+    if (end > count) end = count;
+    if (end < start) end = start;
 
+    DCRes res = dang_array_new(de, arr->storage, arr->offset + (usize)start, (usize)(end - start));
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
         return dc_dv_nullptr();
     }
 
-    return dc_dv(DCDynArrPtr, result_arr);
+    return dc_unwrap2(res);
 }
 
-static DECL_DBUILTIN_FUNCTION(push)
+/**
+ * Gives the array a storage of its own holding a copy of its elements
+ */
+static DCResVoid array_detach(DEvaluator* de, DCDynValPtr array_obj)
 {
-    (void)de;
+    DC_RES_void();
+
+    DArrayPtr arr = do_as_array(*array_obj);
+
+    dc_try_or_fail_with3(ResStorage, storage_res, dang_storage_new(de, arr->count > 10 ? arr->count * 2 : 10), {});
 
+    DArrayStoragePtr storage = dc_unwrap2(storage_res);
+
+    // the elements are already compact values, the boxes are shared
+    memcpy(storage->values, arr->storage->values + arr->offset, arr->count * sizeof(DValue));
+    storage->count = arr->count;
+
+    arr->storage = storage;
+    arr->offset = 0;
+
+    // the array can be old while the new storage is young
+    return dang_gc_write_barrier(de, array_obj);
+}
+
+/**
+ * Appends to the shared storage in place when the array ends where the storage ends,
+ * otherwise the array is detached from the storage first so the other arrays sharing it don't see the change
+ */
+static DECL_DBUILTIN_FUNCTION(push)
+{
     BUILTIN_FN_GET_ARGS_VALIDATE("push", 2);
 
     BUILTIN_FN_GET_ARG_NO(0, DO_ARRAY, "first argument must be an array");
 
-    dc_da_push(dc_dv_as(arg0, DCDynArrPtr), dc_da_get2(_args, 1));
+    DArrayPtr arr = do_as_array(arg0);
+
+    DCResVoid res;
+
+    if (arr->offset + arr->count != arr->storage->count)
+    {
+        res = array_detach(de, &arg0);
+        if (dc_is_err2(res))
+        {
+            *error = dc_err2(res);
+            return dc_dv_nullptr();
+        }
+    }
+
+    res = dang_storage_push(de, arr->storage, &dc_da_get2(_args, 1));
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
+        return dc_dv_nullptr();
+    }
+
+    ++arr->count;
+
+    // the storage can be old while the pushed value is young, integers and immediates can't be young
+    if (dang_value_is_object(arr->storage->values[arr->storage->count - 1]))
+    {
+        res = dang_gc_write_barrier(de, &dc_dv(DArrayStoragePtr, arr->storage));
+        if (dc_is_err2(res))
+        {
+            *error = dc_err2(res);
+            return dc_dv_nullptr();
+        }
+    }
 
     return dc_dv_nullptr();
 }
 
+/**
+ * Array of the keys or the values of the hash table in insertion order,
+ * they're copied straight from the entries of the table into a storage of the exact size
+ *
+ * NOTE: It's a snapshot rather than a lazy view of the table, the elements of the arrays never change
+ * while the table changes in place (e.g. `delete`), so a view would have to copy on the first change
+ * and every later access would go through the table (and its dynamic values) instead of the compact values
+ */
+static DCRes hash_table_column(DEvaluator* de, DCHashTablePtr ht, b1 keys)
+{
+    DC_RES();
+
+    dc_try_or_fail_with3(ResStorage, storage_res, dang_storage_new(de, ht->key_count), {});
+
+    DArrayStoragePtr storage = dc_unwrap2(storage_res);
+
+    dc_ht_for(hash_table_column_loop, *ht,
+              { dc_try_fail_temp(DCResVoid, dang_storage_push(de, storage, keys ? &_it->first : &_it->second)); });
+
+    return dang_array_new(de, storage, 0, storage->count);
+}
+
+static DECL_DBUILTIN_FUNCTION(keys)
+{
+    BUILTIN_FN_GET_ARGS_VALIDATE("keys", 1);
+
+    BUILTIN_FN_GET_ARG_NO(0, DO_HASH_TABLE, "first argument must be a hash table");
+
+    DCRes res = hash_table_column(de, dc_dv_as(arg0, DCHashTablePtr), true);
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
+        return dc_dv_nullptr();
+    }
+
+    return dc_unwrap2(res);
+}
+
+static DECL_DBUILTIN_FUNCTION(values)
+{
+    BUILTIN_FN_GET_ARGS_VALIDATE("values", 1);
+
+    BUILTIN_FN_GET_ARG_NO(0, DO_HASH_TABLE, "first argument must be a hash table");
+
+    DCRes res = hash_table_column(de, dc_dv_as(arg0, DCHashTablePtr), false);
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
+        return dc_dv_nullptr();
+    }
+
+    return dc_unwrap2(res);
+}
+
+/**
+ * Array of `[key, value]` arrays in insertion order
+ *
+ * NOTE: All the pairs are views over one storage holding the keys and values side by side,
+ * so there are only two storages no matter how many pairs the hash table has, like `keys` and `values`
+ * it's a snapshot of the table
+ */
+static DCRes hash_table_entries(DEvaluator* de, DCHashTablePtr ht)
+{
+    DC_RES();
+
+    dc_try_or_fail_with3(ResStorage, kv_res, dang_storage_new(de, ht->key_count * 2), {});
+    dc_try_or_fail_with3(ResStorage, entries_res, dang_storage_new(de, ht->key_count), {});
+
+    DArrayStoragePtr kv_storage = dc_unwrap2(kv_res);
+    DArrayStoragePtr entries_storage = dc_unwrap2(entries_res);
+
+    dc_ht_for(hash_table_entries_loop, *ht, {
+        usize offset = kv_storage->count;
+
+        dc_try_fail_temp(DCResVoid, dang_storage_push(de, kv_storage, &_it->first));
+        dc_try_fail_temp(DCResVoid, dang_storage_push(de, kv_storage, &_it->second));
+
+        dc_try_or_fail_with3(DCRes, pair_res, dang_array_new(de, kv_storage, offset, 2), {});
+        dc_try_fail_temp(DCResVoid, dang_storage_push(de, entries_storage, &dc_unwrap2(pair_res)));
+    });
+
+    return dang_array_new(de, entries_storage, 0, entries_storage->count);
+}
+
+static DECL_DBUILTIN_FUNCTION(entries)
+{
+    BUILTIN_FN_GET_ARGS_VALIDATE("entries", 1);
+
+    BUILTIN_FN_GET_ARG_NO(0, DO_HASH_TABLE, "first argument must be a hash table");
+
+    DCRes res = hash_table_entries(de, dc_dv_as(arg0, DCHashTablePtr));
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
+        return dc_dv_nullptr();
+    }
+
+    return dc_unwrap2(res);
+}
+
+static DECL_DBUILTIN_FUNCTION(has)
+{
+    (void)de;
+
+    BUILTIN_FN_GET_ARGS_VALIDATE("has", 2);
+
+    BUILTIN_FN_GET_ARG_NO(0, DO_HASH_TABLE, "first argument must be a hash table");
+
+    DCDynValPtr found = NULL;
+
+    DCResUsize res = dc_ht_find_by_key(dc_dv_as(arg0, DCHashTablePtr), dc_da_get2(_args, 1), &found);
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
+        return dc_dv_nullptr();
+    }
+
+    return dc_dv_bool(found != NULL);
+}
+
+/**
+ * Removes the key from the hash table in place, the result tells whether the key existed
+ */
+static DECL_DBUILTIN_FUNCTION(delete)
+{
+    (void)de;
+
+    BUILTIN_FN_GET_ARGS_VALIDATE("delete", 2);
+
+    BUILTIN_FN_GET_ARG_NO(0, DO_HASH_TABLE, "first argument must be a hash table");
+
+    DCResBool res = dc_ht_delete(dc_dv_as(arg0, DCHashTablePtr), dc_da_get2(_args, 1));
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
+        return dc_dv_nullptr();
+    }
+
+    return dc_dv_bool(dc_unwrap2(res));
+}
+
+/**
+ * New hash table with the pairs of both, the values of the second one win for the shared keys
+ */
+static DCRes hash_table_merge(DEvaluator* de, DCHashTablePtr first, DCHashTablePtr second)
+{
+    DC_RES();
+
+    dc_try_or_fail_with3(DCResHt, ht_res, dang_hash_table_new(de, first->key_count + second->key_count), {});
+
+    DCHashTablePtr ht = dc_unwrap2(ht_res);
+
+    dc_try_or_fail_with3(DCResVoid, res, dang_gc_track(de, dc_dva(DCHashTablePtr, ht)), {
+        dc_dbg_log("failed to track the result hash table");
+        dc_ht_free(ht);
+        dc_dealloc(ht, sizeof(DCHashTable));
+    });
+
+    dc_try_fail_temp(DCResVoid, dc_ht_merge(ht, first, DC_HT_SET_CREATE_OR_UPDATE));
+    dc_try_fail_temp(DCResVoid, dc_ht_merge(ht, second, DC_HT_SET_CREATE_OR_UPDATE));
+
+    dc_ret_ok(dc_dv(DCHashTablePtr, ht));
+}
+
+static DECL_DBUILTIN_FUNCTION(merge)
+{
+    BUILTIN_FN_GET_ARGS_VALIDATE("merge", 2);
+
+    BUILTIN_FN_GET_ARG_NO(0, DO_HASH_TABLE, "first argument must be a hash table");
+    BUILTIN_FN_GET_ARG_NO(1, DO_HASH_TABLE, "second argument must be a hash table");
+
+    DCRes res = hash_table_merge(de, dc_dv_as(arg0, DCHashTablePtr), dc_dv_as(arg1, DCHashTablePtr));
+    if (dc_is_err2(res))
+    {
+        *error = dc_err2(res);
+        return dc_dv_nullptr();
+    }
+
+    return dc_unwrap2(res);
+}
+
 static DECL_DBUILTIN_FUNCTION(print)
 {
     (void)de;
@@ -648,49 +1441,57 @@ static DECL_DBUILTIN_FUNCTION(print)
     return dc_dv_nullptr();
 }
 
-static DCRes find_builtin(string name)
+/**
+ * Builtin functions every evaluator starts with, more can be added by `dang_register_builtin`
+ */
+static const struct
 {
-    DC_RES();
-
+    string name;
     DBuiltinFunction fn;
+} core_builtins[] = {
+    {"len", len}, {"first", first}, {"last", last}, {"rest", rest}, {"slice", slice}, {"push", push}, {"print", print},
+    {"keys", keys}, {"values", values}, {"has", has}, {"delete", delete}, {"entries", entries}, {"merge", merge},
+};
 
-    if (strcmp(name, "len") == 0)
-        fn = len;
+static DCResVoid register_core_builtins(DEvaluator* de)
+{
+    DC_RES_void();
 
-    else if (strcmp(name, "first") == 0)
-        fn = first;
+    for (size i = 0; i < dc_count(core_builtins); ++i)
+        dc_try_fail(dang_register_builtin(de, core_builtins[i].name, core_builtins[i].fn));
 
-    else if (strcmp(name, "last") == 0)
-        fn = last;
+    dc_ret();
+}
 
-    else if (strcmp(name, "rest") == 0)
-        fn = rest;
+DCRes dang_call_builtin(DEvaluator* de, DBuiltinFunction fn, DCDynValPtr call_obj)
+{
+    DC_RES();
 
-    else if (strcmp(name, "push") == 0)
-        fn = push;
+    DCError error = (DCError){0};
 
-    else if (strcmp(name, "print") == 0)
-        fn = print;
+    DCDynVal result = fn(de, call_obj, &error);
 
-    else
+    if (error.code != 0)
     {
-        dc_dbg_log("key '%s' not found in the environment", name);
-
-        dc_ret_ea(6, "'%s' is not defined", name);
+        dc_status() = DC_RES_ERR;
+        dc_err() = error;
+        dc_ret();
     }
 
-    dc_ret_ok_dv(DBuiltinFunction, fn);
+    dc_ret_ok(result);
 }
 
 // ***************************************************************************************
 // * MAIN EVALUATION PROCESS
 // ***************************************************************************************
 
-static DCRes perform_evaluation_process(DEvaluator* de, DCDynValPtr dn, DEnv* env)
+static DCDynVal perform_evaluation_process(DEvaluator* de, DCDynValPtr dn, DEnv* env)
 {
-    DC_RES();
-
-    if (!dn) dc_ret_e(-1, "got NULL node");
+    if (!dn)
+    {
+        eval_fail(de, -1, "got NULL node");
+        return dc_dv_nullptr();
+    }
 
     dc_dbg_log("evaluating node of type: '%s'", tostr_DNType(dn->type));
 
@@ -703,253 +1504,668 @@ static DCRes perform_evaluation_process(DEvaluator* de, DCDynValPtr dn, DEnv* en
         {
             DNodePrefixExpression prefix_node = dc_dv_as(*dn, DNodePrefixExpression);
 
-            dc_try_or_fail_with3(DCRes, operand, perform_evaluation_process(de, prefix_node.operand, env), {});
+            DCDynVal operand = perform_evaluation_process(de, prefix_node.operand, env);
+            eval_ret_if_failed(de);
 
-            return eval_prefix_expression(prefix_node.op, &dc_unwrap2(operand));
+            return eval_take(de, dang_eval_prefix(prefix_node.op, &operand));
         }
 
         case dc_dvt(DNodeInfixExpression):
         {
             DNodeInfixExpression infix_node = dc_dv_as(*dn, DNodeInfixExpression);
 
-            dc_try_or_fail_with3(DCRes, left, perform_evaluation_process(de, infix_node.left, env), {});
-            dc_try_or_fail_with3(DCRes, right, perform_evaluation_process(de, infix_node.right, env), {});
+            DCDynVal left = perform_evaluation_process(de, infix_node.left, env);
+            eval_ret_if_failed(de);
+
+            usize roots_mark = dang_gc_roots_mark(de);
+            eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &left), dc_dv_nullptr());
+
+            DCDynVal right = perform_evaluation_process(de, infix_node.right, env);
+            eval_ret_if_failed(de);
+
+            dang_gc_roots_restore(de, roots_mark);
+
+            return eval_take(de, dang_eval_infix(de, infix_node.op, &left, &right));
+        }
+
+        case DO_BOOLEAN:
+        case DO_INTEGER:
+        case DO_STRING:
+        {
+            DCDynVal result = *dn;
+            result.allocated = false;
+            return result;
+        }
+
+        case dc_dvt(DNodeIdentifier):
+        {
+            DNodeIdentifier* ident = &dc_dv_as(*dn, DNodeIdentifier);
+
+            DValue value = env_resolved_value(env, ident);
+            if (dang_value_is_defined(value)) return dang_value_unpack(value);
+
+            // builtins and the names that are not defined
+            return eval_take(de, dang_env_get_resolved(env, ident));
+        }
+
+        case dc_dvt(DNodeBlockStatement):
+        {
+            DCDynArrPtr statements = dc_dv_as(*dn, DNodeBlockStatement).statements;
+            return eval_block_statements(de, statements, env);
+        }
+
+        case dc_dvt(DNodeIfExpression):
+            return eval_if_expression(de, &dc_dv_as(*dn, DNodeIfExpression), env);
+
+        case dc_dvt(DNodeReturnStatement):
+        {
+            DNodeReturnStatement ret_node = dc_dv_as(*dn, DNodeReturnStatement);
+
+            if (!ret_node.ret_val) return dc_dv(DoReturn, do_return(&de->nullptr));
+
+            DCDynVal value = perform_evaluation_process(de, ret_node.ret_val, env);
+            eval_ret_if_failed(de);
+
+            // the value is only kept until the function call unwraps it
+            de->ret_val = value;
+
+            return dc_dv(DoReturn, do_return(&de->ret_val));
+        }
+
+        case dc_dvt(DNodeLetStatement):
+            return eval_let_statement(de, &dc_dv_as(*dn, DNodeLetStatement), env);
+
+        case dc_dvt(DNodeFunctionLiteral):
+        {
+            // function object holds a pointer to the actual node
+            // and the pointer to the environment it's being evaluated
+            env->captured = true;
+            return dc_dv(DoFunction, do_function(&dc_dv_as(*dn, DNodeFunctionLiteral), env));
+        }
+
+        case dc_dvt(DNodeArrayLiteral):
+        {
+            DCDynArrPtr arr = dc_dv_as(*dn, DNodeArrayLiteral).array;
+
+            DArrayStoragePtr storage = eval_array_elements(de, arr, env);
+            eval_ret_if_failed(de);
+
+            return eval_take(de, dang_array_new(de, storage, 0, storage->count));
+        }
+
+        case dc_dvt(DNodeHashTableLiteral):
+            return eval_hash_literal(de, &dc_dv_as(*dn, DNodeHashTableLiteral), env);
+
+        case dc_dvt(DNodeIndexExpression):
+        {
+            DNodeIndexExpression index_exp = dc_dv_as(*dn, DNodeIndexExpression);
+
+            DCDynVal operand = perform_evaluation_process(de, index_exp.operand, env);
+            eval_ret_if_failed(de);
+
+            usize roots_mark = dang_gc_roots_mark(de);
+            eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &operand), dc_dv_nullptr());
+
+            DCDynVal index = perform_evaluation_process(de, index_exp.index, env);
+            eval_ret_if_failed(de);
+
+            dang_gc_roots_restore(de, roots_mark);
+
+            return eval_take(de, dang_eval_index(&operand, &index));
+        }
+
+        case dc_dvt(DNodeCallExpression):
+        {
+            DNodeCallExpression call_exp = dc_dv_as(*dn, DNodeCallExpression);
+
+            // evaluating it must return a function object
+            // that points to the function literal node and the environment it's been evaluated in
+            DCDynVal fn_obj = perform_evaluation_process(de, call_exp.function, env);
+            eval_ret_if_failed(de);
+
+            if (fn_obj.type != DO_FUNCTION && fn_obj.type != DO_BUILTIN_FUNCTION)
+            {
+                dc_dbg_log("not a function got: '%s'", dv_type_tostr(&fn_obj));
+
+                eval_faila(de, -1, "not a function got: '%s'", dv_type_tostr(&fn_obj));
+                return dc_dv_nullptr();
+            }
+
+            usize roots_mark = dang_gc_roots_mark(de);
+            eval_try_temp(de, DCResVoid, dang_gc_push_root(de, &fn_obj), dc_dv_nullptr());
+
+            if (fn_obj.type == DO_FUNCTION && !call_exp.tail)
+            {
+                DoFunction function = dc_dv_as(fn_obj, DoFunction);
+
+                DEnv* fn_env = bind_arguments(de, function, call_exp.arguments, env);
+                eval_ret_if_failed(de);
+
+                dang_gc_roots_restore(de, roots_mark);
+
+                return apply_function(de, function, fn_env);
+            }
+
+            usize temp_mark = dang_arena_list_mark(&de->temp);
+
+            eval_arguments(de, call_exp.arguments, env);
+            eval_ret_if_failed(de);
+
+            dang_gc_roots_restore(de, roots_mark);
+
+            if (fn_obj.type == DO_BUILTIN_FUNCTION)
+            {
+                // this is a temporary object to hold the evaluated arguments
+                DCDynArr args = temp_arguments(de, temp_mark);
+                DCDynVal call_obj = dc_dv(DCDynArrPtr, &args);
+
+                // builtins report the errors right into the error slot
+                DCDynVal result = dc_dv_as(fn_obj, DBuiltinFunction)(de, &call_obj, &de->error);
+                if (de->error.code != 0) de->failed = true;
+
+                dang_arena_list_drop(&de->temp, temp_mark);
+
+                return result;
+            }
+
+            // it's returned to the running `apply_function` that performs it and drops the arguments (see `DoTailCall`)
+            de->tail_fn = fn_obj;
+            de->tail_args = temp_arguments(de, temp_mark);
+            return dc_dv(DoTailCall, do_tail_call(&de->tail_fn, &de->tail_args));
+        }
+
+        default:
+            break;
+    };
+
+    eval_faila(de, -1, "Unimplemented or unsupported node type: %s", dv_type_tostr(dn));
+    return dc_dv_nullptr();
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+DCResVoid dang_scope_init(DScopePtr scope)
+{
+    DC_RES_void();
+
+    scope->escapes = false;
+
+    dc_try_fail(dc_da_init2(&scope->names, 8, 2, NULL));
+
+    dc_try_or_fail_with3(DCResVoid, res, dc_ht_init(&scope->index, 17, scope_hash_fn, string_key_cmp, NULL), {
+        dc_dbg_log("cannot initialize dang scope hash table");
+        dc_try_fail_temp(DCResVoid, dc_da_free(&scope->names));
+    });
+
+    dc_ret();
+}
+
+DCResVoid dang_scope_free(DScopePtr scope)
+{
+    DC_RES_void();
+
+    dc_try_fail(dc_ht_free(&scope->index));
+
+    dc_try_fail(dc_da_free(&scope->names));
+
+    dc_ret();
+}
+
+DCResUsize dang_scope_find(DScopePtr scope, string name)
+{
+    DC_RES_usize();
+
+    DCDynValPtr found = NULL;
+
+    dc_try_fail_temp(DCResUsize, dc_ht_find_by_key(&scope->index, dc_dv(string, name), &found));
+
+    if (!found) dc_ret_e(dc_e_code(NF), "name is not declared in the scope");
+
+    dc_ret_ok(dc_dv_as(*found, usize));
+}
+
+/**
+ * Returns the slot of the name in the scope, the name gets the next free slot
+ * if it is not declared yet
+ *
+ * NOTE: The scope keeps the name, it must outlive the scope (e.g. an interned name)
+ */
+DCResUsize dang_scope_declare(DScopePtr scope, string name)
+{
+    DC_RES_usize();
+
+    DCPairPtr entry = NULL;
+
+    dc_try_or_fail_with3(DCResBool, entry_res, dc_ht_entry(&scope->index, dc_dv(string, name), &entry), {});
+
+    if (!dc_unwrap2(entry_res)) dc_ret_ok(dc_dv_as(entry->second, usize));
+
+    usize slot = scope->names.count;
+    entry->second = dc_dv(usize, slot);
+
+    dc_try_or_fail_with3(DCResVoid, push_res, dc_da_push(&scope->names, dc_dv(string, name)), {
+        dc_try_fail_temp(DCResBool, dc_ht_delete(&scope->index, dc_dv(string, name)));
+    });
+
+    dc_ret_ok(slot);
+}
+
+DCResVoid dang_env_init(DEnvPtr env, DScopePtr scope)
+{
+    DC_RES_void();
+
+    if (!scope) dc_ret_e(dc_e_code(NV), "cannot initialize dang environment with NULL scope");
+
+    env->scope = scope;
+    env->slots = NULL;
+    env->slot_count = 0;
+    env->outer = NULL;
+    env->captured = false;
+    env->on_stack = false;
+    env->gc_flags = 0;
+
+    dc_try_fail(env_reserve_slots(env, scope->names.count));
+
+    dc_ret();
+}
+
+static DCResVoid evaluator_init(DEvaluator* de)
+{
+    DC_RES_void();
+
+    de->backend = DANG_DEFAULT_BACKEND;
+    de->optimize = DANG_DEFAULT_OPTIMIZE;
+
+    dc_try_fail(dang_scope_init(&de->globals));
+
+    dc_try_or_fail_with(dang_env_init(&de->main_env, &de->globals),
+                        { dc_try_fail_temp(DCResVoid, dang_scope_free(&de->globals)); });
+
+    dc_try_fail(dang_arena_init(&de->arena));
+    dc_try_fail(dang_arena_init(&de->temp));
+    dc_try_fail(dc_da_init2(&de->errors, 20, 2, NULL));
+    dc_try_fail(dc_da_init2(&de->compiled, 10, 2, evaluator_compiled_cleanup));
+
+    dc_try_or_fail_with(dang_parser_init(&de->parser, &de->arena, &de->errors), {
+        dc_try_fail_temp(DCResVoid, dang_env_free(&de->main_env));
+        dc_try_fail_temp(DCResVoid, dang_scope_free(&de->globals));
+        dc_try_fail_temp(DCResVoid, dang_arena_free(&de->arena));
+        dc_try_fail_temp(DCResVoid, dang_arena_free(&de->temp));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&de->errors));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&de->compiled));
+    });
+
+    dc_try_or_fail_with(dc_ht_init(&de->builtins, 17, scope_hash_fn, string_key_cmp, NULL), {
+        dc_try_fail_temp(DCResVoid, dang_env_free(&de->main_env));
+        dc_try_fail_temp(DCResVoid, dang_scope_free(&de->globals));
+        dc_try_fail_temp(DCResVoid, dang_arena_free(&de->arena));
+        dc_try_fail_temp(DCResVoid, dang_arena_free(&de->temp));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&de->errors));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&de->compiled));
+    });
+
+    dc_try_or_fail_with(dang_gc_init(&de->gc), {
+        dc_try_fail_temp(DCResVoid, dc_ht_free(&de->builtins));
+        dc_try_fail_temp(DCResVoid, dang_env_free(&de->main_env));
+        dc_try_fail_temp(DCResVoid, dang_scope_free(&de->globals));
+        dc_try_fail_temp(DCResVoid, dang_arena_free(&de->arena));
+        dc_try_fail_temp(DCResVoid, dang_arena_free(&de->temp));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&de->errors));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&de->compiled));
+    });
+
+    frame_stack_init(&de->frames);
+
+    dc_try_fail(register_core_builtins(de));
+
+    de->nullptr = dc_dv_nullptr();
+    de->ret_val = dc_dv_nullptr();
+    de->tail_fn = dc_dv_nullptr();
+    de->tail_args = (DCDynArr){0};
+
+    de->error = (DCError){0};
+    de->failed = false;
+
+    de->hash_seed = 0;
+
+    dc_ret();
+}
+
+static DCResVoid evaluator_free(DEvaluator* de)
+{
+    DC_RES_void();
+
+    dc_try_fail(dang_env_free(&de->main_env));
+
+    dc_try_fail(dang_scope_free(&de->globals));
+
+    dc_try_fail(dc_ht_free(&de->builtins));
+
+    dc_try_fail(dang_gc_free(&de->gc));
+
+    frame_stack_free(&de->frames);
+
+    dc_try_fail(dc_da_free(&de->compiled));
+
+    dc_try_fail(dang_arena_free(&de->arena));
+
+    dc_try_fail(dang_arena_free(&de->temp));
+
+    dc_try_fail(dc_da_free(&de->errors));
+
+    dc_ret();
+}
+
+static DCResVoid register_builtin(DEvaluator* de, string name, DBuiltinFunction fn)
+{
+    DC_RES_void();
+
+    dc_try_or_fail_with3(DCResString, name_res, dang_intern(de, name), {});
+
+    return dc_ht_set(&de->builtins, dc_dv(string, dc_unwrap2(name_res)), dc_dv(DBuiltinFunction, fn),
+                     DC_HT_SET_CREATE_OR_UPDATE);
+}
+
+DCResVoid dang_evaluator_init(DEvaluator* de)
+{
+    return dang_evaluator_init2(de, (DCAllocator){.fn = dc_default_alloc, .ctx = NULL}, DANG_GC_NURSERY_SIZE);
+}
+
+/**
+ * Initializes the evaluator with its own allocator, every allocation of the evaluator goes through it
+ * and is accounted in `memory` (see allocator.h), `nursery_size` is the number of bytes of new objects
+ * that triggers a minor collection (see gc.h)
+ *
+ * NOTE: The allocator is given the size of the blocks it resizes and frees, so it doesn't need to store them
+ */
+DCResVoid dang_evaluator_init2(DEvaluator* de, DCAllocator allocator, usize nursery_size)
+{
+    DC_RES_void();
+
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot initialize NULL evaluator");
+
+    dang_memory_init(&de->memory, allocator);
+
+    DCAllocator previous = dang_memory_enter(de);
+    __dc_res = evaluator_init(de);
+    dang_memory_leave(previous);
+
+    if (dc_is_ok()) dang_gc_set_nursery_size(de, nursery_size);
+
+    dc_ret();
+}
+
+DCResVoid dang_evaluator_free(DEvaluator* de)
+{
+    DC_RES_void();
+
+    if (!de) dc_ret();
 
-            return eval_infix_expression(de, infix_node.op, &dc_unwrap2(left), &dc_unwrap2(right));
-        }
+    DCAllocator previous = dang_memory_enter(de);
+    __dc_res = evaluator_free(de);
+    dang_memory_leave(previous);
 
-        case DO_BOOLEAN:
-        case DO_INTEGER:
-        case DO_STRING:
-        {
-            DCDynVal result = *dn;
-            result.allocated = false;
-            result.env = NULL;
-            dc_ret_ok(result);
-        }
+    dc_ret();
+}
 
-        case dc_dvt(DNodeIdentifier):
-        {
-            string name = dc_dv_as(*dn, DNodeIdentifier).value;
+/**
+ * Sets the seed of the hash table objects that are created from now on, seeding with an unpredictable value
+ * (e.g. from the system's random source) makes it impractical to craft keys that collide in the hash tables
+ *
+ * NOTE: The seed is zero by default, so the order of the keys is the same in every run
+ */
+void dang_evaluator_set_hash_seed(DEvaluator* de, u64 seed)
+{
+    if (!de) return;
 
-            DCRes symbol = dang_env_get(env, name);
+    de->hash_seed = seed;
+}
 
-            if (dc_is_ok2(symbol)) return symbol;
+/**
+ * Registers a native function under the given name, registering an existing name replaces it
+ *
+ * NOTE: The name is interned in the evaluator so it doesn't need to outlive the call
+ * Functions are attached to identifiers when the program is resolved, so the
+ * registration must happen before evaluating the code that uses it
+ */
+DCResVoid dang_register_builtin(DEvaluator* de, string name, DBuiltinFunction fn)
+{
+    DC_RES_void();
 
-            return find_builtin(name);
-        }
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot register builtin function in NULL evaluator");
+    if (!name || !fn) dc_ret_e(dc_e_code(NV), "cannot register builtin function with NULL name or function");
 
-        case dc_dvt(DNodeBlockStatement):
-        {
-            DCDynArrPtr statements = dc_dv_as(*dn, DNodeBlockStatement).statements;
-            return eval_block_statements(de, statements, env);
-        }
+    DCAllocator previous = dang_memory_enter(de);
+    __dc_res = register_builtin(de, name, fn);
+    dang_memory_leave(previous);
 
-        case dc_dvt(DNodeIfExpression):
-            return eval_if_expression(de, &dc_dv_as(*dn, DNodeIfExpression), env);
+    dc_ret();
+}
 
-        case dc_dvt(DNodeReturnStatement):
-        {
-            DNodeReturnStatement ret_node = dc_dv_as(*dn, DNodeReturnStatement);
+/**
+ * Returns the unique copy of the name, scopes, environments and builtins find the interned names
+ * by their pointer
+ *
+ * NOTE: The names the parser produces are already interned, plain names work as well
+ * but they're compared by their text
+ */
+DCResString dang_intern(DEvaluator* de, string name)
+{
+    DC_RES_string();
 
-            if (!ret_node.ret_val) dc_ret_ok_dv(DoReturn, do_return(&de->nullptr));
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot intern in NULL evaluator");
+    if (!name) dc_ret_e(dc_e_code(NV), "cannot intern NULL name");
 
-            dc_try_or_fail_with3(DCRes, value, perform_evaluation_process(de, ret_node.ret_val, env), {});
+    DCAllocator previous = dang_memory_enter(de);
+    __dc_res = dang_arena_intern(&de->arena, dc_sv(name, 0, strlen(name)));
+    dang_memory_leave(previous);
 
-            dc_try_fail_temp(DCResVoid, dc_da_push(&de->pool, dc_unwrap2(value)));
+    dc_ret();
+}
 
-            dc_ret_ok_dv(DoReturn, do_return(pool_last_el(de)));
-        }
+/**
+ * Returns the builtin function registered under the name or NULL
+ */
+DBuiltinFunction dang_find_builtin(DEvaluator* de, string name)
+{
+    DCDynValPtr found = NULL;
 
-        case dc_dvt(DNodeLetStatement):
-            return eval_let_statement(de, &dc_dv_as(*dn, DNodeLetStatement), env);
+    DCResUsize res = dc_ht_find_by_key(&de->builtins, dc_dv(string, name), &found);
+    if (dc_is_err2(res) || !found) return NULL;
 
-        case dc_dvt(DNodeFunctionLiteral):
-        {
-            // function literal holds actual node in object's dv
-            // also holds the pointer to the environment it's being evaluated
-            DCDynVal res = *dn;
-            res.env = env;
-            dc_ret_ok(res);
-        }
+    return dc_dv_as(*found, DBuiltinFunction);
+}
 
-        case dc_dvt(DNodeArrayLiteral):
-        {
-            DCDynArrPtr arr = dc_dv_as(*dn, DNodeArrayLiteral).array;
+/**
+ * Releases the AST, the scopes and the prototypes of the last evaluated program
+ * unless it has function literals, functions that are created from them can outlive the evaluation
+ *
+ * NOTE: The interned strings are kept as they're the names of the environments and the string literals
+ */
+static void release_program(DEvaluator* de, DArenaMark arena_mark, usize compiled_mark)
+{
+    for (usize i = compiled_mark; i < de->compiled.count; ++i)
+        if (dc_da_get2(de->compiled, i).type == dc_dvt(DScopePtr)) return;
 
-            dc_try_or_fail_with3(DCResDa, temp_res, eval_children_nodes(de, arr, env), {});
+    DCResVoid res = dc_da_pop(&de->compiled, de->compiled.count - compiled_mark, NULL, false);
+    dc_result_free(&res);
 
-            dc_ret_ok_dv(DCDynArrPtr, dc_unwrap2(temp_res));
-        }
+    dang_arena_rollback(&de->arena, arena_mark);
+}
 
-        case dc_dvt(DNodeHashTableLiteral):
-            return eval_hash_literal(de, &dc_dv_as(*dn, DNodeHashTableLiteral), env);
+static ResEvaluated evaluate(DEvaluator* de, const string source, b1 inspect)
+{
+    DC_RES2(ResEvaluated);
 
-        case dc_dvt(DNodeIndexExpression):
-        {
-            DNodeIndexExpression index_exp = dc_dv_as(*dn, DNodeIndexExpression);
+    // temporaries and parser errors of the previous evaluation
+    dang_arena_reset(&de->temp);
+    dc_try_fail_temp(DCResVoid, dc_da_pop(&de->errors, de->errors.count, NULL, false));
 
-            dc_try_or_fail_with3(DCRes, operand_res, perform_evaluation_process(de, index_exp.operand, env), {});
-            DCDynVal operand = dc_unwrap2(operand_res);
+    dc_try_or_fail_with3(ResDNodeProgram, program_res, dang_parse(&de->parser, source), {});
 
-            dc_try_or_fail_with3(DCRes, index_res, perform_evaluation_process(de, index_exp.index, env), {});
-            DCDynVal index = dc_unwrap2(index_res);
+    DNodeProgram program = dc_unwrap2(program_res);
 
-            if (operand.type != DO_ARRAY && operand.type != DO_HASH_TABLE)
-            {
-                dc_dbg_log("indexing of '%s' is not supporting on '%s'", dv_type_tostr(index), dv_type_tostr(operand));
-                dc_ret_e(-1, "indexing is not supporting on this type");
-            }
+    if (de->optimize) dc_try_fail_temp(DCResVoid, dang_optimize(de, &program));
 
-            else if (operand.type == DO_ARRAY && index.type != DO_INTEGER)
-            {
-                dc_dbg_log("indexing of '%s' is not supporting on '%s'", dv_type_tostr(index), dv_type_tostr(operand));
-                dc_ret_e(-1, "indexing is not supporting on this type");
-            }
+    dc_try_fail_temp(DCResVoid, dang_resolve(de, &program));
 
-            if (do_as_int(index) < 0) dc_ret_ok_dv_nullptr();
+    // the calls that have failed in the previous evaluations never popped their environments
+    de->frames.count = 0;
+    de->frames.slot_count = 0;
 
-            if (operand.type == DO_ARRAY) return eval_array_index_expression(&operand, &index);
+    DCDynVal result;
 
-            return eval_hash_index_expression(&operand, &index);
-        }
+    if (de->backend == DANG_BACKEND_VM)
+    {
+        dc_try_or_fail_with3(ResFnProto, proto_res, dang_compile(de, &program), {});
 
-        case dc_dvt(DNodeCallExpression):
-        {
-            DNodeCallExpression call_exp = dc_dv_as(*dn, DNodeCallExpression);
+        dc_try_or_fail_with3(DCRes, run_res, dang_vm_run(de, dc_unwrap2(proto_res), &de->main_env), {});
 
-            // evaluating it must return a function object
-            // that is in fact the function literal node saved in the environment before
-            // it also holds pointer to its environment
-            dc_try_or_fail_with3(DCRes, fn_res, perform_evaluation_process(de, call_exp.function, env), {});
+        result = dc_unwrap2(run_res);
+    }
+    else
+    {
+        usize roots_mark = dang_gc_roots_mark(de);
 
-            DCDynVal fn_obj = dc_unwrap2(fn_res);
+        de->error = (DCError){0};
+        de->failed = false;
 
-            if (fn_obj.type != DO_FUNCTION && fn_obj.type != DO_BUILTIN_FUNCTION)
-            {
-                dc_dbg_log("not a function got: '%s'", dv_type_tostr(&fn_obj));
+        result = perform_evaluation_process(de, &dc_dv(DNodeProgram, program), &de->main_env);
 
-                dc_ret_ea(-1, "not a function got: '%s'", dv_type_tostr(&fn_obj));
-            }
+        // the error slot of the tree walker turns back to a result right here
+        if (eval_failed(de))
+        {
+            // in case of errors the rooted temporaries are not popped on the way out
+            dang_gc_roots_restore(de, roots_mark);
 
-            // eval arguments (first element is function symbol the rest is arguments)
-            // so we start evaluating children at index 1
-            dc_try_or_fail_with3(DCResDa, call_obj_res, eval_children_nodes(de, call_exp.arguments, env), {});
+            dc_status() = DC_RES_ERR;
+            dc_err() = de->error;
 
-            // this is a temporary object to hold the evaluated children and the env
-            DCDynVal call_obj = dc_dv(DCDynArrPtr, dc_unwrap2(call_obj_res));
+            de->error = (DCError){0};
+            de->failed = false;
 
-            if (fn_obj.type == DO_BUILTIN_FUNCTION)
-            {
-                DBuiltinFunction fn = dc_dv_as(fn_obj, DBuiltinFunction);
+            dc_ret();
+        }
+    }
 
-                DCError error = (DCError){0};
+    string inspect_str = NULL;
 
-                DCDynVal result = fn(de, &call_obj, &error);
+    if (inspect)
+    {
+        string inspect_tmp = NULL;
+        dc_try_fail_temp(DCResVoid, dang_program_inspect(&program, &inspect_tmp));
 
-                if (error.code != 0)
-                {
-                    dc_status() = DC_RES_ERR;
-                    dc_err() = error;
-                    dc_ret();
-                }
+        if (inspect_tmp)
+        {
+            DCResString copy_res = dang_arena_strdup(&de->temp, dc_sv(inspect_tmp, 0, strlen(inspect_tmp)));
+            dc_sfree(inspect_tmp);
 
-                dc_ret_ok(result);
-            }
+            dc_try_fail_temp(DCResString, copy_res);
 
-            call_obj.env = fn_obj.env;
-            return apply_function(de, &call_obj, &dc_dv_as(fn_obj, DNodeFunctionLiteral));
+            inspect_str = dc_unwrap2(copy_res);
         }
+    }
 
-        default:
-            break;
-    };
-
-    dc_ret_ea(-1, "Unimplemented or unsupported node type: %s", dv_type_tostr(dn));
+    dc_ret_ok(dang_evaluated(result, inspect_str));
 }
 
-// ***************************************************************************************
-// * PUBLIC FUNCTIONS
-// ***************************************************************************************
-
-DCResVoid dang_env_init(DEnvPtr env)
+/**
+ * Evaluate input code and return a result containing the evaluated object
+ * And the inspected source code if asked for
+ *
+ * NOTE: Depending on `de->backend` the program is either walked directly
+ * Or compiled to bytecode and run by the vm, both share the same arena, heap and environments
+ *
+ * NOTE: The result (if it's a runtime object) is valid until the next evaluation,
+ * the garbage collector may free it afterwards unless it's reachable from the main environment
+ *
+ * NOTE: Temporaries of an evaluation (arguments of the builtin and tail calls, the inspection if it's asked for
+ * and the parser errors) are released when the next evaluation starts, so no need to free the inspection manually
+ * Values that outlive the evaluation (the ones reachable from the main environment) are heap objects
+ * and the program itself is released right away unless it has function literals
+ *
+ * NOTE: Evaluations that need more memory than the limit of the evaluator (see allocator.h) fail with an out of memory error
+ */
+ResEvaluated dang_eval(DEvaluator* de, const string source, b1 inspect)
 {
-    DC_RES_void();
+    DC_RES2(ResEvaluated);
 
-    dc_try_or_fail_with3(DCResVoid, res, dc_ht_init(&env->memory, 17, env_hash_fn, string_key_cmp, NULL),
-                         { dc_dbg_log("cannot initialize dang environment hash table"); });
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot evaluate using NULL evaluator");
+    if (!source) dc_ret_e(dc_e_code(NV), "cannot run evaluation on NULL source");
 
-    env->outer = NULL;
+    de->memory.exceeded = false;
 
-    dc_ret();
-}
+    DArenaMark arena_mark = dang_arena_mark(&de->arena);
+    usize compiled_mark = de->compiled.count;
 
-DCResVoid dang_evaluator_init(DEvaluator* de)
-{
-    DC_RES_void();
+    DCAllocator previous = dang_memory_enter(de);
+    __dc_res = evaluate(de, source, inspect);
+    release_program(de, arena_mark, compiled_mark);
+    dang_memory_leave(previous);
 
-    dc_try_fail(dang_env_init(&de->main_env));
+    // the failure of the allocation might have been reported differently (or not at all) on the way out
+    if (de->memory.exceeded)
+    {
+        dc_result_free(&__dc_res);
 
-    dc_try_fail(dc_da_init2(&de->pool, 50, 3, evaluator_pool_cleanup));
-    dc_try_fail(dc_da_init2(&de->errors, 20, 2, NULL));
+        // the objects of the failed evaluation can be old already, they're freed right away by a major collection
+        // so the next evaluation has room to be parsed, the arguments left on the scratch stack are not roots anymore
+        de->frames.count = 0;
+        de->frames.slot_count = 0;
+        dang_arena_list_drop(&de->temp, 0);
+        de->gc.next_gc = de->gc.bytes_allocated;
 
-    dc_try_or_fail_with(dang_parser_init(&de->parser, &de->pool, &de->errors), {
-        dc_try_fail_temp(DCResVoid, dang_env_free(&de->main_env));
-        dc_try_fail_temp(DCResVoid, dc_da_free(&de->pool));
-        dc_try_fail_temp(DCResVoid, dc_da_free(&de->errors));
-    });
+        DCResVoid gc_res = dang_gc_collect(de);
+        dc_result_free(&gc_res);
 
-    de->nullptr = dc_dv_nullptr();
+        dc_ret_ea(dc_e_code(MEM), "out of memory, evaluation exceeded the memory limit of " dc_fmt(usize) " bytes",
+                  de->memory.limit);
+    }
 
     dc_ret();
 }
 
-DCResVoid dang_evaluator_free(DEvaluator* de)
+/**
+ * Appends the key value pair of a hash table in the form of "(key, value)"
+ */
+static DCResVoid tostr_append_pair(DCPairPtr pair, string* result)
 {
     DC_RES_void();
 
-    dc_try_fail(dang_env_free(&de->main_env));
+    dc_try_or_fail_with3(DCResString, key, do_tostr(&pair->first), {});
+    dc_try_or_fail_with3(DCResString, value, do_tostr(&pair->second), dc_sfree(dc_unwrap2(key)));
 
-    dc_try_fail(dc_da_free(&de->pool));
+    dc_sappend(result, "(%s, %s)", dc_unwrap2(key), dc_unwrap2(value));
 
-    dc_try_fail(dc_da_free(&de->errors));
+    dc_sfree(dc_unwrap2(key));
+    dc_sfree(dc_unwrap2(value));
 
     dc_ret();
 }
 
 /**
- * Evaluate input code and return a result containing the evaluated object
- * And the inspected source code if asked for
- *
- * NOTE: in case the inspection is being asked it is saved in the pool
- * No need to free it manually it will be taken care of when the evaluator is freed
+ * Appends the string representation of each element of the array separated by ", "
  */
-ResEvaluated dang_eval(DEvaluator* de, const string source, b1 inspect)
+static DCResVoid tostr_append_elements(DArrayPtr arr, string* result)
 {
-    DC_RES2(ResEvaluated);
-
-    if (!de) dc_ret_e(dc_e_code(NV), "cannot evaluate using NULL evaluator");
-    if (!source) dc_ret_e(dc_e_code(NV), "cannot run evaluation on NULL source");
-
-    dc_try_or_fail_with3(ResDNodeProgram, program_res, dang_parse(&de->parser, source), {});
+    DC_RES_void();
 
-    DNodeProgram program = dc_unwrap2(program_res);
+    for (usize i = 0; i < arr->count; ++i)
+    {
+        if (i > 0) dc_sappend(result, "%s", ", ");
 
-    dc_try_or_fail_with3(DCRes, result, perform_evaluation_process(de, &dc_dv(DNodeProgram, program), &de->main_env), {});
+        DCDynVal element = dang_array_get(arr, i);
 
-    string inspect_str = NULL;
+        dc_try_or_fail_with3(DCResString, item, do_tostr(&element), {});
 
-    if (inspect)
-    {
-        dc_try_fail_temp(DCResVoid, dang_program_inspect(&program, &inspect_str));
+        dc_sappend(result, "%s", dc_unwrap2(item));
 
-        if (inspect_str)
-        {
-            dc_try_or_fail_with3(DCResVoid, res, dc_da_push(&de->pool, dc_dva(string, inspect_str)), free(inspect_str));
-        }
+        dc_sfree(dc_unwrap2(item));
     }
 
-    dc_ret_ok(dang_evaluated(dc_unwrap2(result), inspect_str));
+    dc_ret();
 }
 
 DCResString do_tostr(DCDynValPtr obj)
@@ -960,15 +2176,46 @@ DCResString do_tostr(DCDynValPtr obj)
 
     switch (obj->type)
     {
-        case DO_HASH_TABLE:
-        case DO_ARRAY:
         case DO_BOOLEAN:
         case DO_INTEGER:
-        case DO_STRING:
             return dc_tostr_dv(obj);
+
+        case DO_STRING:
+            dc_sprintf(&result, DCPRIsv, dc_sv_fmt(do_as_string(*obj)));
+            break;
+
+        case DO_ARRAY:
+        {
+            DArrayPtr arr = do_as_array(*obj);
+
+            dc_sprintf(&result, "%s", "[");
+
+            dc_try_or_fail_with3(DCResVoid, res, tostr_append_elements(arr, &result), dc_sfree(result));
+
+            dc_sappend(&result, "%s", "]");
+            break;
+        }
+
+        case DO_HASH_TABLE:
+        {
+            DCHashTablePtr ht = dc_dv_as(*obj, DCHashTablePtr);
+
+            dc_sprintf(&result, "%s", "{");
+
+            usize printed = 0;
+
+            dc_ht_for(tostr_hash_table_loop, *ht, {
+                if (printed++ > 0) dc_sappend(&result, "%s", ", ");
+
+                dc_try_or_fail_with3(DCResVoid, res, tostr_append_pair(_it, &result), dc_sfree(result));
+            });
+
+            dc_sappend(&result, "%s", "}");
             break;
+        }
 
         case DO_FUNCTION:
+        case DO_COMPILED_FUNCTION:
             dc_sprintf(&result, "%s", "(function)");
             break;
 
@@ -1000,36 +2247,107 @@ void do_print(DCDynValPtr obj)
 
     printf("%s", dc_unwrap2(res));
 
-    free(dc_unwrap2(res));
+    dc_sfree(dc_unwrap2(res));
+}
+
+/**
+ * Strings and arrays are true when they're not empty, other objects follow the dynamic value rules
+ */
+DCResBool do_to_bool(DCDynValPtr obj)
+{
+    DC_RES_bool();
+
+    if (obj && obj->type == DO_STRING) dc_ret_ok(do_as_string(*obj).len != 0);
+    if (obj && obj->type == DO_ARRAY) dc_ret_ok(do_as_array(*obj)->count != 0);
+
+    return dc_dv_to_bool(obj);
+}
+
+/**
+ * Returns the hash of the string with the seed, it's cached in the buffer of the string
+ * so hashing the same string (or any string of the same buffer and length) again with the same seed is O(1)
+ *
+ * NOTE: A hash cached for the same length with another seed is kept, so the interned strings never lose
+ * the hash they're interned with
+ */
+u32 do_string_hash(DoString str, u64 seed)
+{
+    DStringBufferPtr buf = str.buf;
+
+    if (buf && buf->hash_len == str.len && buf->hash_seed == seed) return buf->hash;
+
+    u32 hash = dang_str_hash(str.str, str.len, seed);
+
+    if (buf && buf->hash_len != str.len)
+    {
+        buf->hash = hash;
+        buf->hash_len = str.len;
+        buf->hash_seed = seed;
+    }
+
+    return hash;
+}
+
+/**
+ * Strings are equal when they have the same bytes, other objects follow the dynamic value rules
+ *
+ * NOTE: Strings of different lengths or different cached hashes are told apart without comparing the bytes
+ */
+DCResBool do_eq(DCDynValPtr obj1, DCDynValPtr obj2)
+{
+    DC_RES_bool();
+
+    if (obj1->type == DO_STRING && obj2->type == DO_STRING)
+    {
+        DoString str1 = do_as_string(*obj1);
+        DoString str2 = do_as_string(*obj2);
+
+        if (str1.len != str2.len) dc_ret_ok(false);
+        if (str1.str == str2.str) dc_ret_ok(true);
+
+        if (str1.buf && str2.buf && str1.buf->hash_len == str1.len && str2.buf->hash_len == str2.len &&
+            str1.buf->hash_seed == str2.buf->hash_seed && str1.buf->hash != str2.buf->hash)
+            dc_ret_ok(false);
+
+        dc_ret_ok(memcmp(str1.str, str2.str, str1.len) == 0);
+    }
+
+    if (obj1->type == DO_ARRAY && obj2->type == DO_ARRAY) dc_ret_ok(do_as_array(*obj1) == do_as_array(*obj2));
+
+    return dc_dv_eq(obj1, obj2);
 }
 
-ResEnv dang_env_new()
+ResEnv dang_env_new(DScopePtr scope)
 {
-    return _env_new();
+    return _env_new(scope);
 }
 
 DCResVoid dang_env_free(DEnv* de)
 {
     DC_RES_void();
 
-    dc_dbg_log("number of memory elements: " dc_fmt(usize) ", number of cleanup elements: " dc_fmt(usize), de->memory.key_count,
-               de->cleanups.count);
+    dc_dbg_log("number of slots: " dc_fmt(usize), de->slot_count);
 
-    dc_try_fail(dc_ht_free(&de->memory));
+    if (de->slots) dc_dealloc(de->slots, de->slot_count * sizeof(DValue));
+
+    de->slots = NULL;
+    de->slot_count = 0;
 
     dc_ret();
 }
 
-
 DCRes dang_env_get(DEnv* env, string name)
 {
     DC_RES();
 
-    DCDynValPtr found = NULL;
+    DCResUsize slot_res = dang_scope_find(env->scope, name);
 
-    dc_try_fail_temp(DCResUsize, dc_ht_find_by_key(&env->memory, dc_dv(string, name), &found));
+    if (dc_is_ok2(slot_res))
+    {
+        usize slot = dc_unwrap2(slot_res);
 
-    if (found) dc_ret_ok(*found);
+        if (slot < env->slot_count && dang_value_is_defined(env->slots[slot])) dc_ret_ok(dang_value_unpack(env->slots[slot]));
+    }
 
     if (env->outer) return dang_env_get(env->outer, name);
 
@@ -1038,23 +2356,77 @@ DCRes dang_env_get(DEnv* env, string name)
     dc_ret_ea(dc_e_code(NF), "'%s' is not defined", name);
 }
 
-DCRes dang_env_set(DEnv* env, string name, DCDynValPtr value, b1 update_only)
+DCRes dang_env_set(DEvaluator* de, DEnv* env, string name, DCDynValPtr value, b1 update_only)
 {
     DC_RES();
 
     DCDynVal val_to_save = value ? *value : dc_dv_nullptr();
 
-    DCResVoid res = dc_ht_set(&env->memory, dc_dv(string, name), val_to_save,
-                              update_only ? DC_HT_SET_UPDATE_OR_FAIL : DC_HT_SET_CREATE_OR_FAIL);
+    if (!update_only)
+    {
+        // the scope keeps the name, so the name of the caller is interned first
+        dc_try_or_fail_with3(DCResString, name_res, dang_intern(de, name), {});
+        name = dc_unwrap2(name_res);
+
+        dc_try_or_fail_with3(DCResUsize, slot_res, dang_scope_declare(env->scope, name), {});
 
-    if (dc_is_err2(res))
+        return dang_env_define(de, env, dc_unwrap2(slot_res), name, &val_to_save);
+    }
+
+    DCResUsize slot_res = dang_scope_find(env->scope, name);
+
+    if (dc_is_err2(slot_res) || dc_unwrap2(slot_res) >= env->slot_count ||
+        !dang_value_is_defined(env->slots[dc_unwrap2(slot_res)]))
+        dc_ret_ea(dc_e_code(HT_SET), "'%s' is not defined.", name);
+
+    dc_try_or_fail_with3(ResDValue, packed, dang_value_pack(de, &val_to_save), {});
+
+    env->slots[dc_unwrap2(slot_res)] = dc_unwrap2(packed);
+
+    dc_ret_ok(val_to_save);
+}
+
+/**
+ * Defines the value in the given slot of the environment, it fails if the slot is already defined
+ */
+DCRes dang_env_define(DEvaluator* de, DEnv* env, usize slot, string name, DCDynValPtr value)
+{
+    DC_RES();
+
+    // scopes might grow after the environment is created (e.g. globals in the REPL)
+    if (slot >= env->slot_count)
     {
-        if (dc_err_code2(res) == dc_e_code(HT_SET))
-            dc_ret_ea(dc_e_code(HT_SET), "'%s' %s", name, (update_only ? "is not defined." : "is already defined."));
+        usize count = env->scope->names.count > slot ? env->scope->names.count : slot + 1;
 
-        dc_err_cpy(res);
-        dc_ret();
+        dc_try_fail_temp(DCResVoid, env_reserve_slots(env, count));
     }
 
+    if (dang_value_is_defined(env->slots[slot])) dc_ret_ea(dc_e_code(HT_SET), "'%s' is already defined.", name);
+
+    DCDynVal val_to_save = value ? *value : dc_dv_nullptr();
+
+    dc_try_or_fail_with3(ResDValue, packed, dang_value_pack(de, &val_to_save), {});
+
+    env->slots[slot] = dc_unwrap2(packed);
+
     dc_ret_ok(val_to_save);
 }
+
+/**
+ * Reads a resolved identifier by hopping `depth` environments and indexing `slot`
+ *
+ * NOTE: In case the slot is not defined yet it is either a builtin function (already attached
+ * to the identifier by the resolver) or a name that is not defined, the latter falls back to
+ * the name based lookup which reports the error
+ */
+DCRes dang_env_get_resolved(DEnv* env, DNodeIdentifier* ident)
+{
+    DC_RES();
+
+    DValue value = env_resolved_value(env, ident);
+    if (dang_value_is_defined(value)) dc_ret_ok(dang_value_unpack(value));
+
+    if (ident->builtin) dc_ret_ok_dv(DBuiltinFunction, ident->builtin);
+
+    return dang_env_get(env, ident->value);
+}
@@ -24,26 +24,208 @@
 // * TYPES
 // ***************************************************************************************
 
+/**
+ * Scope holds the variable names of a function (or the global environment) in slot order
+ * `escapes` is set by the resolver when a function literal is nested in the function,
+ * only then its environments can be captured and outlive the call
+ *
+ * NOTE: Scopes are created by the resolver and shared between all the environments
+ * of the same function, the index is only used for name based lookups
+ */
+struct DScope
+{
+    DCDynArr names;
+    DCHashTable index;
+    b1 escapes;
+};
+
+/**
+ * `slots` are compact values (see value.h), the slots that are not defined yet are undefined (zero)
+ * `captured` is set once a closure is created in the environment,
+ * environments that are not captured can be reused by the calls in tail position
+ * `on_stack` environments (and their slots) live on the frame stack of the evaluator
+ * `gc_flags` is the collector state of a heap environment (see `dang_gc_write_barrier`)
+ */
 struct DEnv
 {
-    DCHashTable memory;
+    DScopePtr scope;
+
+    DValue* slots;
+    usize slot_count;
+
     struct DEnv* outer;
+    b1 captured;
+    b1 on_stack;
+    u8 gc_flags;
 };
 
 DCResType(DEnv*, ResEnv);
 
+#ifndef DANG_FRAME_STACK_SIZE
+#define DANG_FRAME_STACK_SIZE 1024
+#endif
+
+#ifndef DANG_FRAME_STACK_SLOTS
+#define DANG_FRAME_STACK_SLOTS (16 * 1024)
+#endif
+
+#ifndef DANG_FRAME_CHUNK_SIZE
+#define DANG_FRAME_CHUNK_SIZE 64
+#endif
+
+#ifndef DANG_FRAME_CHUNK_SLOTS
+#define DANG_FRAME_CHUNK_SLOTS 1024
+#endif
+
+#define DANG_FRAME_CHUNKS ((DANG_FRAME_STACK_SIZE + DANG_FRAME_CHUNK_SIZE - 1) / DANG_FRAME_CHUNK_SIZE)
+#define DANG_FRAME_SLOT_CHUNKS ((DANG_FRAME_STACK_SLOTS + DANG_FRAME_CHUNK_SLOTS - 1) / DANG_FRAME_CHUNK_SLOTS)
+
+/**
+ * Environment on the frame stack, `index` and `slot_mark` are where the frame stack was before it's pushed
+ */
+typedef struct
+{
+    DEnv env;
+
+    usize index;
+    usize slot_mark;
+} DFrame;
+
+/**
+ * Environments of the calls whose scope doesn't escape, they're pushed on call and popped on return
+ * so such calls don't allocate at all, the slots of an environment are taken from `slot_chunks` in the same order
+ *
+ * NOTE: Chunks are allocated on the first call that reaches them and kept for the next calls,
+ * they never move so the environments don't either, calls that don't fit (past `DANG_FRAME_STACK_SIZE`
+ * frames or `DANG_FRAME_STACK_SLOTS` slots) get their environment from the heap like the escaping ones
+ */
+typedef struct
+{
+    DFrame* chunks[DANG_FRAME_CHUNKS];
+    usize count;
+
+    DValue* slot_chunks[DANG_FRAME_SLOT_CHUNKS];
+    usize slot_count;
+} DFrameStack;
+
+#define dang_frame_at(FRAMES, IDX) (&(FRAMES)->chunks[(IDX) / DANG_FRAME_CHUNK_SIZE][(IDX) % DANG_FRAME_CHUNK_SIZE])
+
+/**
+ * Execution strategies available behind `dang_eval`
+ *
+ * The tree walker is kept as the reference implementation for differential testing
+ * against the bytecode compiler + vm
+ */
+typedef enum
+{
+    DANG_BACKEND_TREE_WALKER,
+    DANG_BACKEND_VM,
+} DangBackend;
+
+#ifdef DANG_DEFAULT_BACKEND_VM
+#define DANG_DEFAULT_BACKEND DANG_BACKEND_VM
+#else
+#define DANG_DEFAULT_BACKEND DANG_BACKEND_TREE_WALKER
+#endif
+
+/**
+ * The optimizer (see optimizer.h) runs between parsing and resolving,
+ * it can be turned off per evaluator (`optimize` field) or by default with `DANG_NO_OPTIMIZER`
+ */
+#ifdef DANG_NO_OPTIMIZER
+#define DANG_DEFAULT_OPTIMIZE false
+#else
+#define DANG_DEFAULT_OPTIMIZE true
+#endif
+
+/**
+ * Accounting of the memory the evaluator allocates through `allocator` (see allocator.h)
+ *
+ * `current` is the number of bytes in use, `peak` is the most that has been in use at once
+ * and `total` is every byte that has ever been allocated, `limit` caps `current` (0 for no limit)
+ * and `exceeded` is set when an allocation is refused because of it
+ */
+typedef struct
+{
+    DCAllocator allocator;
+
+    usize limit;
+    usize current;
+    usize peak;
+    usize total;
+
+    b1 exceeded;
+} DMemory;
+
+/**
+ * Heap of the runtime objects (string buffers, arrays and their storages, hash tables and environments)
+ * managed by a generational mark and sweep collector (see gc.h)
+ *
+ * New objects go to the `nursery` and the ones surviving a minor collection are promoted to
+ * `objects` (the old space), `remembered` holds the old objects that were mutated since the last minor collection
+ * `roots` holds in-flight temporaries and the heap environments of the active tree walker calls,
+ * `vm` is the running vm (if any) whose stack and frames are roots as well (like the frame stack of the evaluator)
+ * Program memory is not part of the heap, the AST is in the arena and scopes and function prototypes
+ * created by the resolver and the compiler are in `compiled`, the programs without any function literal
+ * are released once they're evaluated (see `dang_eval`)
+ * The arguments of the builtin and tail calls of the tree walker are on the scratch stack of `temp`, they're roots as well
+ */
+typedef struct
+{
+    DCDynArr nursery;
+    DCDynArr objects;
+    DCDynArr remembered;
+    DCDynArr roots;
+    DVM* vm;
+
+    usize nursery_size;
+    usize nursery_bytes;
+
+    usize bytes_allocated;
+    usize threshold;
+    usize next_gc;
+
+    usize minor_collections;
+    usize major_collections;
+} DGC;
+
 struct DEvaluator
 {
+    DangBackend backend;
+    b1 optimize;
+
+    DMemory memory;
+
+    DScope globals;
     DEnv main_env;
+    DFrameStack frames;
+
+    DCHashTable builtins;
+
+    DGC gc;
 
     DParser parser;
 
-    DCDynArr pool;
+    DArena arena;
     DCDynArr errors;
+    DCDynArr compiled;
+
+    // temporaries of the current evaluation (see `dang_eval`)
+    DArena temp;
 
     DCDynVal nullptr;
+    DCDynVal ret_val;
+    DCDynVal tail_fn;
+    DCDynArr tail_args;
     DCDynVal bool_true;
     DCDynVal bool_false;
+
+    // error of the failed tree walker evaluation, `failed` is checked after each call (see evaluator.c)
+    DCError error;
+    b1 failed;
+
+    // mixed with the hashes of the keys of the hash table objects (see `dang_evaluator_set_hash_seed`)
+    u64 hash_seed;
 };
 
 typedef struct
@@ -58,14 +240,16 @@ DCResType(Evaluated, ResEvaluated);
 // * MACROS
 // ***************************************************************************************
 
-#define DO_STRING dc_dvt(string)
+#define DO_STRING dc_dvt(DoString)
 #define DO_INTEGER dc_dvt(i64)
 #define DO_BOOLEAN dc_dvt(b1)
-#define DO_ARRAY dc_dvt(DCDynArrPtr)
+#define DO_ARRAY dc_dvt(DArrayPtr)
 #define DO_HASH_TABLE dc_dvt(DCHashTablePtr)
-#define DO_FUNCTION dc_dvt(DNodeFunctionLiteral)
+#define DO_FUNCTION dc_dvt(DoFunction)
+#define DO_COMPILED_FUNCTION dc_dvt(DoClosure)
 #define DO_BUILTIN_FUNCTION dc_dvt(DBuiltinFunction)
 #define DO_RETURN dc_dvt(DoReturn)
+#define DO_TAIL_CALL dc_dvt(DoTailCall)
 
 #define dang_evaluated(RES, INSPECT)                                                                                           \
     (Evaluated)                                                                                                                \
@@ -73,30 +257,28 @@ DCResType(Evaluated, ResEvaluated);
         .result = (RES), .inspect = (INSPECT)                                                                                  \
     }
 
-#define do_def(TYPE, VALUE, ENV)                                                                                               \
+#define do_def(TYPE, VALUE)                                                                                                    \
     (DCDynVal)                                                                                                                 \
     {                                                                                                                          \
-        .type = dc_dvt(TYPE), .value.dc_dvf(TYPE) = VALUE, .allocated = false, .env = ENV                                      \
+        .type = dc_dvt(TYPE), .value.dc_dvf(TYPE) = VALUE, .allocated = false                                                  \
     }
 
-#define do_defa(TYPE, VALUE, ENV)                                                                                              \
+#define do_defa(TYPE, VALUE)                                                                                                   \
     (DCDynVal)                                                                                                                 \
     {                                                                                                                          \
-        .type = dc_dvt(TYPE), .value.dc_dvf(TYPE) = VALUE, .allocated = true, .env = ENV                                       \
+        .type = dc_dvt(TYPE), .value.dc_dvf(TYPE) = VALUE, .allocated = true                                                   \
     }
 
-#define do_int(NUM) do_def(i64, (NUM), NULL)
-#define do_string(STR) do_def(string, (STR), NULL)
+#define do_int(NUM) do_def(i64, (NUM))
+#define do_string(STR) do_def(DoString, do_string_of((STR), strlen(STR), NULL))
 
 #define do_as_arr(DO) (*dc_dv_as((DO), DCDynArrPtr))
+#define do_as_array(DO) dc_dv_as((DO), DArrayPtr)
 #define do_as_int(DO) dc_dv_as((DO), i64)
-#define do_as_string(DO) dc_dv_as((DO), string)
+#define do_as_string(DO) dc_dv_as((DO), DoString)
 
 #define do_is_int(DO) (dc_dv_is((DO), i64))
-#define do_is_string(DO) (dc_dv_is((DO), string))
-
-#define if_dv_is_DoReturn_return_unwrapped()                                                                                   \
-    if (dc_unwrap().type == dc_dvt(DoReturn)) dc_ret_ok(*(dc_dv_as(dc_unwrap(), DoReturn).ret_val))
+#define do_is_string(DO) (dc_dv_is((DO), DoString))
 
 #define DECL_DBUILTIN_FUNCTION(NAME) DCDynVal NAME(DEvaluator* de, DCDynValPtr call_obj, DCError* error)
 
@@ -113,7 +295,7 @@ DCResType(Evaluated, ResEvaluated);
 
 #define BUILTIN_FN_GET_ARG_NO(NUM, TYPE, ERR_MSG)                                                                              \
     DCDynVal arg##NUM = dc_da_get2(_args, NUM);                                                                                \
-    if (arg0.type != TYPE)                                                                                                     \
+    if (arg##NUM.type != TYPE)                                                                                                 \
     {                                                                                                                          \
         dc_error_inita(*error, -1, ERR_MSG ", got arg of type '%s'", dv_type_tostr(&arg##NUM));                                \
         return dc_dv_nullptr();                                                                                                \
@@ -124,17 +306,50 @@ DCResType(Evaluated, ResEvaluated);
 // ***************************************************************************************
 
 DCResVoid dang_evaluator_init(DEvaluator* de);
+DCResVoid dang_evaluator_init2(DEvaluator* de, DCAllocator allocator, usize nursery_size);
 DCResVoid dang_evaluator_free(DEvaluator* de);
+void dang_evaluator_set_hash_seed(DEvaluator* de, u64 seed);
 
 ResEvaluated dang_eval(DEvaluator* de, const string source, b1 inspect);
 
+DCResVoid dang_register_builtin(DEvaluator* de, string name, DBuiltinFunction fn);
+DBuiltinFunction dang_find_builtin(DEvaluator* de, string name);
+DCResString dang_intern(DEvaluator* de, string name);
+
 DCResString do_tostr(DCDynValPtr obj);
 void do_print(DCDynValPtr obj);
+DCResBool do_to_bool(DCDynValPtr obj);
+DCResBool do_eq(DCDynValPtr obj1, DCDynValPtr obj2);
+u32 do_string_hash(DoString str, u64 seed);
 
-DCResVoid dang_env_init(DEnvPtr env);
-ResEnv dang_env_new();
+DCResVoid dang_scope_init(DScopePtr scope);
+DCResVoid dang_scope_free(DScopePtr scope);
+DCResUsize dang_scope_find(DScopePtr scope, string name);
+DCResUsize dang_scope_declare(DScopePtr scope, string name);
+
+DCResVoid dang_env_init(DEnvPtr env, DScopePtr scope);
+ResEnv dang_env_new(DScopePtr scope);
 DCResVoid dang_env_free(DEnv* de);
 DCRes dang_env_get(DEnv* env, string name);
-DCRes dang_env_set(DEnv* env, string name, DCDynValPtr value, b1 update_only);
+DCRes dang_env_set(DEvaluator* de, DEnv* env, string name, DCDynValPtr value, b1 update_only);
+DCRes dang_env_get_resolved(DEnv* env, DNodeIdentifier* ident);
+DCRes dang_env_define(DEvaluator* de, DEnv* env, usize slot, string name, DCDynValPtr value);
+
+// ***************************************************************************************
+// * SHARED EVALUATION FUNCTIONS
+// *    Operations that both the tree walker and the vm backend perform the same way
+// ***************************************************************************************
+
+ResEnv dang_env_new_enclosed(DEvaluator* de, DScopePtr scope, DEnv* outer);
+ResEnv dang_env_new_tail(DEvaluator* de, DEnv* current, DScopePtr scope, DEnv* outer);
+ResEnv dang_env_push(DEvaluator* de, DScopePtr scope, DEnv* outer);
+DCResVoid dang_env_pop(DEvaluator* de, DEnv* env);
+
+DCRes dang_eval_prefix(DOperator op, DCDynValPtr operand);
+DCRes dang_eval_infix(DEvaluator* de, DOperator op, DCDynValPtr left, DCDynValPtr right);
+DCRes dang_eval_index(DCDynValPtr operand, DCDynValPtr index);
+DCResHt dang_hash_table_new(DEvaluator* de, usize capacity);
+DCRes dang_array_new(DEvaluator* de, DArrayStoragePtr storage, usize offset, usize count);
+DCRes dang_call_builtin(DEvaluator* de, DBuiltinFunction fn, DCDynValPtr call_obj);
 
 #endif // DANG_EVAL_H
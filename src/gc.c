@@ -0,0 +1,709 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: gc.c
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Garbage collector source file
+// *               Precise generational mark and sweep collector for the runtime objects
+// ***************************************************************************************
+
+#include "gc.h"
+#include "allocator.h"
+#include "value.h"
+#include "vm.h"
+
+// ***************************************************************************************
+// * TYPES
+// ***************************************************************************************
+
+/**
+ * State of a single collection
+ *
+ * Objects are marked in place (see `DANG_GC_MARKED`), the ones that are not tracked or not owned
+ * by the collected space (e.g. strings in the AST, the main environment or old objects in a minor collection)
+ * are simply ignored
+ * `gray` holds marked objects that are not traced yet, every object of the space is pushed at most once
+ */
+typedef struct
+{
+    b1 minor;
+
+    DCDynValPtr gray;
+    usize gray_count;
+} DGCMarker;
+
+// ***************************************************************************************
+// * PRIVATE HELPER FUNCTIONS
+// ***************************************************************************************
+
+static DC_DV_FREE_FN_DECL(gc_object_cleanup)
+{
+    DC_RES_void();
+
+    if (_value->type == dc_dvt(DEnvPtr))
+    {
+        DEnvPtr env = dc_dv_as(*_value, DEnvPtr);
+
+        if (env)
+        {
+            dc_try_fail(dang_env_free(env));
+
+            dc_dealloc(env, sizeof(DEnv));
+        }
+
+        dc_dv_set(*_value, DEnvPtr, NULL);
+    }
+
+    else if (_value->type == dc_dvt(DStringBufferPtr))
+    {
+        DStringBufferPtr buf = dc_dv_as(*_value, DStringBufferPtr);
+
+        dc_dealloc(buf, sizeof(DStringBuffer) + buf->cap + 1);
+
+        dc_dv_set(*_value, DStringBufferPtr, NULL);
+    }
+
+    else if (_value->type == DO_ARRAY)
+    {
+        dc_dealloc(do_as_array(*_value), sizeof(DArray));
+
+        dc_dv_set(*_value, DArrayPtr, NULL);
+    }
+
+    else if (_value->type == dc_dvt(DArrayStoragePtr))
+    {
+        DArrayStoragePtr storage = dc_dv_as(*_value, DArrayStoragePtr);
+
+        dc_try_fail(dang_storage_free(storage));
+
+        dc_dealloc(storage, sizeof(DArrayStorage));
+
+        dc_dv_set(*_value, DArrayStoragePtr, NULL);
+    }
+
+    else if (_value->type == dc_dvt(DBoxPtr))
+    {
+        dc_dealloc(dc_dv_as(*_value, DBoxPtr), sizeof(DBox));
+
+        dc_dv_set(*_value, DBoxPtr, NULL);
+    }
+
+    dc_ret();
+}
+
+static voidptr object_address(DCDynValPtr value)
+{
+    switch (value->type)
+    {
+        case DO_STRING:
+            return do_as_string(*value).buf;
+
+        case dc_dvt(DStringBufferPtr):
+            return dc_dv_as(*value, DStringBufferPtr);
+
+        case DO_ARRAY:
+            return do_as_array(*value);
+
+        case dc_dvt(DArrayStoragePtr):
+            return dc_dv_as(*value, DArrayStoragePtr);
+
+        case dc_dvt(DBoxPtr):
+            return dc_dv_as(*value, DBoxPtr);
+
+        case DO_HASH_TABLE:
+            return dc_dv_as(*value, DCHashTablePtr);
+
+        case dc_dvt(DEnvPtr):
+            return dc_dv_as(*value, DEnvPtr);
+
+        default:
+            break;
+    };
+
+    return NULL;
+}
+
+/**
+ * Collector state of the runtime objects, strings share the state of their buffer
+ *
+ * NOTE: String buffers only hold bytes and boxes never change so they're never remembered
+ */
+static u8* object_flags(DCDynValPtr object)
+{
+    voidptr address = object_address(object);
+    if (!address) return NULL;
+
+    switch (object->type)
+    {
+        case DO_STRING:
+        case dc_dvt(DStringBufferPtr):
+            return &((DStringBufferPtr)address)->gc_flags;
+
+        case DO_ARRAY:
+            return &((DArrayPtr)address)->gc_flags;
+
+        case dc_dvt(DArrayStoragePtr):
+            return &((DArrayStoragePtr)address)->gc_flags;
+
+        case dc_dvt(DBoxPtr):
+            return &((DBoxPtr)address)->gc_flags;
+
+        case DO_HASH_TABLE:
+            return &((DCHashTablePtr)address)->flags;
+
+        case dc_dvt(DEnvPtr):
+            return &((DEnvPtr)address)->gc_flags;
+
+        default:
+            break;
+    };
+
+    return NULL;
+}
+
+/**
+ * Object a compact value refers to as the type it's tracked with, a null value for the integers and the immediates
+ */
+static DCDynVal compact_object(DValue value)
+{
+    if (!dang_value_is_object(value)) return dc_dv_nullptr();
+
+    switch (value & DANG_VALUE_TAG_MASK)
+    {
+        case DANG_VALUE_TAG_ARRAY:
+            return dc_dv(DArrayPtr, (DArrayPtr)dang_value_object(value));
+
+        case DANG_VALUE_TAG_HASH_TABLE:
+            return dc_dv(DCHashTablePtr, (DCHashTablePtr)dang_value_object(value));
+
+        case DANG_VALUE_TAG_STRING:
+            return dc_dv(DStringBufferPtr, (DStringBufferPtr)dang_value_object(value));
+
+        default:
+            break;
+    };
+
+    return dc_dv(DBoxPtr, (DBoxPtr)dang_value_object(value));
+}
+
+/**
+ * Functions are not objects themselves, they only reach the environment they're created in
+ */
+static DEnvPtr function_env(DCDynValPtr value)
+{
+    if (value->type == DO_FUNCTION) return dc_dv_as(*value, DoFunction).env;
+    if (value->type == DO_COMPILED_FUNCTION) return dc_dv_as(*value, DoClosure).env;
+
+    return NULL;
+}
+
+/**
+ * Approximate number of bytes an object is holding, it's only used for the collection pacing
+ */
+static usize object_size(DCDynValPtr object)
+{
+    switch (object->type)
+    {
+        case dc_dvt(DStringBufferPtr):
+            return sizeof(DStringBuffer) + dc_dv_as(*object, DStringBufferPtr)->cap + 1;
+
+        case DO_ARRAY:
+            return sizeof(DArray);
+
+        case dc_dvt(DArrayStoragePtr):
+            return sizeof(DArrayStorage) + dc_dv_as(*object, DArrayStoragePtr)->cap * sizeof(DValue);
+
+        case dc_dvt(DBoxPtr):
+            return sizeof(DBox);
+
+        case DO_HASH_TABLE:
+        {
+            DCHashTablePtr ht = dc_dv_as(*object, DCHashTablePtr);
+
+            return sizeof(DCHashTable) + dc_ht_storage_size(*ht);
+        }
+
+        case dc_dvt(DEnvPtr):
+            return sizeof(DEnv) + dc_dv_as(*object, DEnvPtr)->slot_count * sizeof(DValue);
+
+        default:
+            break;
+    };
+
+    return 0;
+}
+
+/**
+ * Bytes an object costs the evaluator, the entry in the space matters for the small objects (e.g. strings)
+ */
+static inline usize space_size(DCDynValPtr object)
+{
+    return sizeof(DCDynVal) + object_size(object);
+}
+
+static inline b1 in_space(DGCMarker* m, u8* flags)
+{
+    return flags && (*flags & DANG_GC_TRACKED) && ((*flags & DANG_GC_OLD) == 0) == m->minor;
+}
+
+static void mark_object(DGCMarker* m, DCDynValPtr object)
+{
+    u8* flags = object_flags(object);
+
+    if (!in_space(m, flags) || (*flags & DANG_GC_MARKED)) return;
+
+    *flags |= DANG_GC_MARKED;
+    m->gray[m->gray_count++] = *object;
+}
+
+static void mark_compact(DGCMarker* m, DValue value)
+{
+    DCDynVal object = compact_object(value);
+
+    mark_object(m, &object);
+}
+
+static void mark_value(DGCMarker* m, DCDynValPtr value)
+{
+    // functions keep their defining environment alive
+    DEnvPtr env = function_env(value);
+    if (env) mark_object(m, &dc_dv(DEnvPtr, env));
+
+    mark_object(m, value);
+}
+
+static void trace_env(DGCMarker* m, DEnv* env)
+{
+    for (usize i = 0; i < env->slot_count; ++i)
+        mark_compact(m, env->slots[i]);
+
+    mark_object(m, &dc_dv(DEnvPtr, env->outer));
+}
+
+static void trace_object(DGCMarker* m, DCDynValPtr object)
+{
+    switch (object->type)
+    {
+        case DO_ARRAY:
+            mark_object(m, &dc_dv(DArrayStoragePtr, do_as_array(*object)->storage));
+            break;
+
+        case dc_dvt(DArrayStoragePtr):
+        {
+            DArrayStoragePtr storage = dc_dv_as(*object, DArrayStoragePtr);
+
+            for (usize i = 0; i < storage->count; ++i)
+                mark_compact(m, storage->values[i]);
+
+            break;
+        }
+
+        case dc_dvt(DBoxPtr):
+            mark_value(m, &dc_dv_as(*object, DBoxPtr)->value);
+            break;
+
+        case DO_HASH_TABLE:
+        {
+            DCHashTablePtr ht = dc_dv_as(*object, DCHashTablePtr);
+
+            dc_ht_for(trace_hash_table_loop, *ht, {
+                mark_value(m, &_it->first);
+                mark_value(m, &_it->second);
+            });
+
+            break;
+        }
+
+        case dc_dvt(DEnvPtr):
+            trace_env(m, dc_dv_as(*object, DEnvPtr));
+            break;
+
+        default:
+            break;
+    };
+}
+
+/**
+ * Roots that are not part of the collected space are traced instead, in a minor collection
+ * they can be old objects (e.g. the environment of a long running call) that are written
+ * without any barrier
+ */
+static void mark_root(DGCMarker* m, DCDynValPtr root)
+{
+    if (m->minor && !in_space(m, object_flags(root))) trace_object(m, root);
+
+    mark_value(m, root);
+}
+
+static void mark_roots(DEvaluator* de, DGCMarker* m)
+{
+    trace_env(m, &de->main_env);
+
+    // environments of the active calls that are not on the heap
+    for (usize i = 0; i < de->frames.count; ++i)
+        trace_env(m, &dang_frame_at(&de->frames, i)->env);
+
+    mark_value(m, &de->ret_val);
+
+    // arguments of the builtin and tail calls of the tree walker
+    for (usize i = 0; i < de->temp.scratch.count; ++i)
+        mark_value(m, &de->temp.scratch.elements[i]);
+
+    dc_da_for(mark_roots_loop, de->gc.roots, { mark_root(m, _it); });
+
+    // survivors of the nursery are promoted after the old space is collected (see `collect_old`)
+    if (!m->minor) dc_da_for(mark_nursery_loop, de->gc.nursery, { trace_object(m, _it); });
+
+    // old objects that got young values after their promotion (see `dang_gc_write_barrier`)
+    if (m->minor) dc_da_for(mark_remembered_loop, de->gc.remembered, { mark_root(m, _it); });
+
+    DVM* vm = de->gc.vm;
+    if (!vm) return;
+
+    for (DCDynValPtr it = vm->stack; it < vm->sp; ++it)
+        mark_value(m, it);
+
+    for (usize i = 0; i < vm->frame_count; ++i)
+        if (vm->frames[i].env) mark_root(m, &dc_dv(DEnvPtr, vm->frames[i].env));
+}
+
+/**
+ * Marks everything that is reachable in the given space and frees the rest,
+ * survivors are compacted at the beginning of the space
+ */
+static DCResUsize collect_space(DEvaluator* de, DCDynArrPtr space, b1 minor)
+{
+    DC_RES_usize();
+
+    usize count = space->count;
+    DCDynValPtr objects = space->elements;
+
+    DGCMarker m = {.minor = minor, .gray = NULL, .gray_count = 0};
+
+    // the gray stack is taken from the system allocator so a collection can run when the evaluator is at its memory limit
+    m.gray = (DCDynValPtr)malloc((count + 1) * sizeof(DCDynVal));
+    if (m.gray == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    mark_roots(de, &m);
+
+    while (m.gray_count > 0)
+    {
+        DCDynVal object = m.gray[--m.gray_count];
+
+        trace_object(&m, &object);
+    }
+
+    usize live = 0;
+    usize live_bytes = 0;
+
+    for (usize i = 0; i < count; ++i)
+    {
+        u8* flags = object_flags(&objects[i]);
+
+        if (flags && (*flags & DANG_GC_MARKED))
+        {
+            *flags &= (u8)~DANG_GC_MARKED;
+
+            live_bytes += space_size(&objects[i]);
+            objects[live++] = objects[i];
+
+            continue;
+        }
+
+        DCResVoid res = dc_dv_free(&objects[i], gc_object_cleanup);
+        if (dc_is_err2(res))
+        {
+            dc_err_dbg_log2(res, "could not free runtime object");
+            dc_result_free(&res);
+        }
+    }
+
+    free(m.gray);
+
+    dc_dbg_log("gc (%s) freed " dc_fmt(usize) " of " dc_fmt(usize) " objects", minor ? "minor" : "major", count - live, count);
+
+    space->count = live;
+
+    dc_ret_ok(live_bytes);
+}
+
+/**
+ * Moves the nursery objects to the old space as they are
+ */
+static DCResVoid promote_nursery(DGC* gc)
+{
+    DC_RES_void();
+
+    if (gc->nursery.count > 0) dc_try_fail(dc_da_append(&gc->objects, &gc->nursery));
+
+    dc_da_for(promote_loop, gc->nursery, {
+        u8* flags = object_flags(_it);
+        if (flags) *flags |= DANG_GC_OLD;
+    });
+
+    gc->nursery.count = 0;
+    gc->nursery_bytes = 0;
+
+    dc_ret();
+}
+
+/**
+ * Empties the remembered set, it must be done before the remembered objects can be freed
+ */
+static void forget_remembered(DGC* gc)
+{
+    dc_da_for(forget_loop, gc->remembered, { *object_flags(_it) &= (u8)~DANG_GC_REMEMBERED; });
+
+    gc->remembered.count = 0;
+}
+
+/**
+ * Collects the old space while the survivors of the nursery are waiting to be promoted,
+ * nothing is allocated before the garbage is freed so it goes through at the memory limit
+ */
+static DCResVoid collect_old(DEvaluator* de)
+{
+    DC_RES_void();
+
+    DGC* gc = &de->gc;
+
+    // every old object is visited, the remembered ones don't need to be roots
+    forget_remembered(gc);
+
+    dc_try_or_fail_with3(DCResUsize, live_res, collect_space(de, &gc->objects, false), {});
+
+    gc->bytes_allocated = dc_unwrap2(live_res);
+    gc->major_collections++;
+
+    dc_ret();
+}
+
+static DCResVoid collect_minor(DEvaluator* de)
+{
+    DC_RES_void();
+
+    DGC* gc = &de->gc;
+
+    dc_try_or_fail_with3(DCResUsize, live_res, collect_space(de, &gc->nursery, true), {});
+
+    DCResVoid res = promote_nursery(gc);
+
+    // the old space can't grow (e.g. at the memory limit), its garbage makes room for the survivors
+    if (dc_is_err2(res))
+    {
+        dc_result_free(&res);
+
+        dc_try_fail(collect_old(de));
+        dc_try_fail(promote_nursery(gc));
+    }
+
+    forget_remembered(gc);
+    gc->bytes_allocated += dc_unwrap2(live_res);
+    gc->minor_collections++;
+
+    dc_ret();
+}
+
+static DCResVoid collect_major(DEvaluator* de)
+{
+    DC_RES_void();
+
+    DGC* gc = &de->gc;
+
+    dc_try_or_fail_with3(DCResUsize, live_res, collect_space(de, &gc->nursery, true), {});
+
+    dc_try_fail(collect_old(de));
+    dc_try_fail(promote_nursery(gc));
+
+    gc->bytes_allocated += dc_unwrap2(live_res);
+
+    usize live_bytes = gc->bytes_allocated;
+    gc->next_gc = live_bytes * DANG_GC_GROWTH_FACTOR > gc->threshold ? live_bytes * DANG_GC_GROWTH_FACTOR : gc->threshold;
+
+    dc_ret();
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+DCResVoid dang_gc_init(DGC* gc)
+{
+    DC_RES_void();
+
+    dc_try_fail(dc_da_init2(&gc->nursery, DANG_GC_NURSERY_CAPACITY, 2, gc_object_cleanup));
+
+    dc_try_or_fail_with(dc_da_init2(&gc->objects, 64, 2, gc_object_cleanup), {
+        dc_dbg_log("cannot initialize gc old space");
+        dc_try_fail_temp(DCResVoid, dc_da_free(&gc->nursery));
+    });
+
+    dc_try_or_fail_with(dc_da_init2(&gc->remembered, 16, 2, NULL), {
+        dc_dbg_log("cannot initialize gc remembered set");
+        dc_try_fail_temp(DCResVoid, dc_da_free(&gc->nursery));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&gc->objects));
+    });
+
+    dc_try_or_fail_with(dc_da_init2(&gc->roots, 32, 2, NULL), {
+        dc_dbg_log("cannot initialize gc roots");
+        dc_try_fail_temp(DCResVoid, dc_da_free(&gc->nursery));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&gc->objects));
+        dc_try_fail_temp(DCResVoid, dc_da_free(&gc->remembered));
+    });
+
+    gc->vm = NULL;
+
+    gc->nursery_size = DANG_GC_NURSERY_SIZE;
+    gc->nursery_bytes = 0;
+
+    gc->bytes_allocated = 0;
+    gc->threshold = DANG_GC_THRESHOLD;
+    gc->next_gc = DANG_GC_THRESHOLD;
+
+    gc->minor_collections = 0;
+    gc->major_collections = 0;
+
+    dc_ret();
+}
+
+DCResVoid dang_gc_free(DGC* gc)
+{
+    DC_RES_void();
+
+    dc_dbg_log("gc collections, minor: " dc_fmt(usize) ", major: " dc_fmt(usize), gc->minor_collections,
+               gc->major_collections);
+
+    dc_try_fail(dc_da_free(&gc->roots));
+
+    dc_try_fail(dc_da_free(&gc->remembered));
+
+    dc_try_fail(dc_da_free(&gc->nursery));
+
+    dc_try_fail(dc_da_free(&gc->objects));
+
+    gc->nursery_bytes = 0;
+    gc->bytes_allocated = 0;
+
+    dc_ret();
+}
+
+/**
+ * Hands over the ownership of a runtime object (string buffer, array, hash table or environment)
+ * to the collector, on failure the object is still owned by the caller
+ *
+ * NOTE: The object itself is already allocated by the caller, only its handle is pushed to the nursery,
+ * which has room for `DANG_GC_NURSERY_CAPACITY` handles before it needs to grow
+ */
+DCResVoid dang_gc_track(DEvaluator* de, DCDynVal object)
+{
+    DC_RES_void();
+
+    object.allocated = true;
+
+    dc_try_fail(dc_da_push(&de->gc.nursery, object));
+
+    u8* flags = object_flags(&object);
+    if (flags) *flags |= DANG_GC_TRACKED;
+
+    de->gc.nursery_bytes += space_size(&object);
+
+    dc_ret();
+}
+
+/**
+ * Keeps the value alive until the roots are restored (see `dang_gc_roots_mark`)
+ *
+ * NOTE: Values that cannot reach any runtime object are not pushed at all
+ */
+DCResVoid dang_gc_push_root(DEvaluator* de, DCDynValPtr value)
+{
+    DC_RES_void();
+
+    if (!function_env(value) && !object_address(value)) dc_ret();
+
+    DCDynVal root = *value;
+    root.allocated = false;
+
+    dc_try_fail(dc_da_push(&de->gc.roots, root));
+
+    dc_ret();
+}
+
+/**
+ * Records an object that is mutated after its creation (e.g. pushing to an array),
+ * so the minor collections can find the young values that an old object is holding
+ *
+ * Only old objects are recorded and only once until the next collection, the callers can skip it
+ * when the written values can't reach any object (e.g. integers)
+ *
+ * NOTE: Environments get it once their call is done (see `dang_env_pop`), they are only written
+ * while they are the active environment of a call, which is a root
+ */
+DCResVoid dang_gc_write_barrier(DEvaluator* de, DCDynValPtr object)
+{
+    DC_RES_void();
+
+    u8* flags = object_flags(object);
+
+    if (!flags || (*flags & (DANG_GC_OLD | DANG_GC_REMEMBERED)) != DANG_GC_OLD) dc_ret();
+
+    DCDynVal remembered = *object;
+    remembered.allocated = false;
+
+    dc_try_fail(dc_da_push(&de->gc.remembered, remembered));
+
+    *flags |= DANG_GC_REMEMBERED;
+
+    dc_ret();
+}
+
+/**
+ * Frees every runtime object that is not reachable from the main environment,
+ * the rooted temporaries, the return value and the stack and frames of the running vm
+ *
+ * A minor collection only visits the nursery and promotes the survivors to the old space,
+ * the old space is only collected (major) when it grows past `next_gc`
+ *
+ * NOTE: It must only be called at safe points, where every live value is reachable from a root
+ */
+DCResVoid dang_gc_collect(DEvaluator* de)
+{
+    DC_RES_void();
+
+    DGC* gc = &de->gc;
+
+    // objects are freed by the allocator that has allocated them
+    DCAllocator previous = dang_memory_enter(de);
+
+    if (gc->bytes_allocated < gc->next_gc) __dc_res = collect_minor(de);
+
+    if (dc_is_ok() && gc->bytes_allocated >= gc->next_gc) __dc_res = collect_major(de);
+
+    dang_memory_leave(previous);
+
+    dc_ret();
+}
+
+void dang_gc_set_threshold(DEvaluator* de, usize threshold)
+{
+    de->gc.threshold = threshold;
+    de->gc.next_gc = threshold;
+}
+
+void dang_gc_set_nursery_size(DEvaluator* de, usize nursery_size)
+{
+    de->gc.nursery_size = nursery_size;
+}
@@ -0,0 +1,97 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: gc.h
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Garbage collector header file
+// ***************************************************************************************
+
+#ifndef DANG_GC_H
+#define DANG_GC_H
+
+#include "evaluator.h"
+
+// ***************************************************************************************
+// * CONFIGS
+// ***************************************************************************************
+
+/**
+ * Approximate number of bytes of new objects that triggers a minor collection
+ * It can be given per evaluator to `dang_evaluator_init2` or changed later using `dang_gc_set_nursery_size`
+ */
+#ifndef DANG_GC_NURSERY_SIZE
+#define DANG_GC_NURSERY_SIZE (256 * 1024)
+#endif
+
+/**
+ * Number of objects the nursery has room for before it needs to grow
+ */
+#ifndef DANG_GC_NURSERY_CAPACITY
+#define DANG_GC_NURSERY_CAPACITY 4096
+#endif
+
+/**
+ * Approximate number of bytes of old (promoted) objects that triggers the first major collection
+ * It can be changed per evaluator using `dang_gc_set_threshold`
+ */
+#ifndef DANG_GC_THRESHOLD
+#define DANG_GC_THRESHOLD (1024 * 1024)
+#endif
+
+/**
+ * After each collection the next one happens when the heap grows to
+ * this factor of the survived bytes (but never sooner than the threshold)
+ */
+#ifndef DANG_GC_GROWTH_FACTOR
+#define DANG_GC_GROWTH_FACTOR 2
+#endif
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+#define dang_gc_should_collect(DE)                                                                                             \
+    ((DE)->gc.nursery_bytes >= (DE)->gc.nursery_size || (DE)->gc.bytes_allocated >= (DE)->gc.next_gc)
+
+/**
+ * Temporaries are rooted in a stack discipline, the mark is taken before pushing
+ * and restored once the temporaries are consumed
+ */
+#define dang_gc_roots_mark(DE) ((DE)->gc.roots.count)
+#define dang_gc_roots_restore(DE, MARK) ((DE)->gc.roots.count = (MARK))
+
+/**
+ * Collector state of the runtime objects, `DANG_GC_REMEMBERED` is only set on the objects
+ * that can be written after their creation (see `dang_gc_write_barrier`)
+ *
+ * NOTE: Objects that are not tracked (e.g. the interned strings or the main environment)
+ * are never collected, `DANG_GC_MARKED` is only set during a collection
+ */
+#define DANG_GC_OLD 0x1
+#define DANG_GC_REMEMBERED 0x2
+#define DANG_GC_TRACKED 0x4
+#define DANG_GC_MARKED 0x8
+
+// ***************************************************************************************
+// * FUNCTION DECLARATIONS
+// ***************************************************************************************
+
+DCResVoid dang_gc_init(DGC* gc);
+DCResVoid dang_gc_free(DGC* gc);
+
+DCResVoid dang_gc_track(DEvaluator* de, DCDynVal object);
+DCResVoid dang_gc_push_root(DEvaluator* de, DCDynValPtr value);
+DCResVoid dang_gc_write_barrier(DEvaluator* de, DCDynValPtr object);
+DCResVoid dang_gc_collect(DEvaluator* de);
+void dang_gc_set_threshold(DEvaluator* de, usize threshold);
+void dang_gc_set_nursery_size(DEvaluator* de, usize nursery_size);
+
+#endif // DANG_GC_H
@@ -17,6 +17,7 @@
 #include "evaluator.h"
 
 #define DANG_REPL_EXIT ":q"
+#define DANG_REPL_GC_STATS ":gc"
 
 static void repl()
 {
@@ -48,6 +49,13 @@ static void repl()
 
         if (strncmp(line, DANG_REPL_EXIT, strlen(DANG_REPL_EXIT)) == 0) break;
 
+        if (strncmp(line, DANG_REPL_GC_STATS, strlen(DANG_REPL_GC_STATS)) == 0)
+        {
+            printf("gc collections, minor: " dc_fmt(usize) ", major: " dc_fmt(usize) "\n", de.gc.minor_collections,
+                   de.gc.major_collections);
+            continue;
+        }
+
         ResEvaluated evaluation_res = dang_eval(&de, line, true);
         if (dc_is_err2(evaluation_res))
         {
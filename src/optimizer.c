@@ -0,0 +1,249 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: optimizer.c
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Optimizer (constant folding) source file
+// *               Folds constant expressions and if expressions with constant conditions
+// ***************************************************************************************
+
+#include "optimizer.h"
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+#define is_constant_node(DN) ((DN)->type == DO_INTEGER || (DN)->type == DO_BOOLEAN || (DN)->type == DO_STRING)
+
+// ***************************************************************************************
+// * FORWARD DECLARATIONS
+// ***************************************************************************************
+
+static DCResVoid optimize_node(DEvaluator* de, DCDynValPtr dn);
+
+// ***************************************************************************************
+// * PRIVATE FUNCTIONS
+// ***************************************************************************************
+
+static DCResVoid optimize_children(DEvaluator* de, DCDynArrPtr children)
+{
+    DC_RES_void();
+
+    if (!children) dc_ret();
+
+    dc_da_for(optimize_children_loop, *children, { dc_try_fail(optimize_node(de, _it)); });
+
+    dc_ret();
+}
+
+static DCDynValPtr actual_node(DCDynValPtr dn)
+{
+    while (dn && dn->type == dc_dvt(DCDynValPtr))
+        dn = dc_dv_as(*dn, DCDynValPtr);
+
+    return dn;
+}
+
+/**
+ * Replaces the node with the folded value in place, so every reference to the node sees the value
+ *
+ * NOTE: Strings are interned in the arena of the evaluator so they belong to the program
+ * and not to the garbage collector
+ */
+static DCResVoid replace_with_constant(DEvaluator* de, DCDynValPtr dn, DCDynVal value)
+{
+    DC_RES_void();
+
+    if (value.type == DO_STRING)
+    {
+        DoString str = do_as_string(value);
+
+        dc_try_or_fail_with3(DCResString, copy_res, dang_arena_intern(&de->arena, dc_sv(str.str, 0, str.len)), {});
+
+        value = dc_dv(DoString, do_string_of(dc_unwrap2(copy_res), str.len, dang_symbol_of(dc_unwrap2(copy_res))));
+    }
+
+    value.allocated = false;
+
+    *dn = value;
+
+    dc_ret();
+}
+
+static DCResVoid fold_prefix(DEvaluator* de, DCDynValPtr dn)
+{
+    DC_RES_void();
+
+    DNodePrefixExpression prefix_node = dc_dv_as(*dn, DNodePrefixExpression);
+
+    dc_try_fail(optimize_node(de, prefix_node.operand));
+
+    DCDynValPtr operand = actual_node(prefix_node.operand);
+    if (!operand || !is_constant_node(operand)) dc_ret();
+
+    DCRes res = dang_eval_prefix(prefix_node.op, operand);
+
+    // invalid operations are left to be reported when (and if) they are evaluated
+    if (dc_is_err2(res))
+    {
+        dc_result_free(&res);
+        dc_ret();
+    }
+
+    return replace_with_constant(de, dn, dc_unwrap2(res));
+}
+
+static DCResVoid fold_infix(DEvaluator* de, DCDynValPtr dn)
+{
+    DC_RES_void();
+
+    DNodeInfixExpression infix_node = dc_dv_as(*dn, DNodeInfixExpression);
+
+    dc_try_fail(optimize_node(de, infix_node.left));
+    dc_try_fail(optimize_node(de, infix_node.right));
+
+    DCDynValPtr left = actual_node(infix_node.left);
+    DCDynValPtr right = actual_node(infix_node.right);
+    if (!left || !right || !is_constant_node(left) || !is_constant_node(right)) dc_ret();
+
+    // integer division traps are left to the runtime as well, it reports them as evaluation errors
+    if (infix_node.op == DOP_DIV && do_is_int(*left) && do_is_int(*right) &&
+        (do_as_int(*right) == 0 || (do_as_int(*right) == -1 && do_as_int(*left) == INT64_MIN)))
+        dc_ret();
+
+    DCRes res = dang_eval_infix(de, infix_node.op, left, right);
+
+    if (dc_is_err2(res))
+    {
+        dc_result_free(&res);
+        dc_ret();
+    }
+
+    return replace_with_constant(de, dn, dc_unwrap2(res));
+}
+
+/**
+ * If expressions with a constant condition are replaced by the block of the taken branch,
+ * a false condition without an alternative becomes an empty block that evaluates to null
+ */
+static DCResVoid fold_if(DEvaluator* de, DCDynValPtr dn)
+{
+    DC_RES_void();
+
+    DNodeIfExpression if_node = dc_dv_as(*dn, DNodeIfExpression);
+
+    dc_try_fail(optimize_node(de, if_node.condition));
+    dc_try_fail(optimize_children(de, if_node.consequence));
+    dc_try_fail(optimize_children(de, if_node.alternative));
+
+    DCDynValPtr condition = actual_node(if_node.condition);
+    if (!condition || !is_constant_node(condition)) dc_ret();
+
+    DCResBool condition_as_bool = do_to_bool(condition);
+    if (dc_is_err2(condition_as_bool))
+    {
+        dc_result_free(&condition_as_bool);
+        dc_ret();
+    }
+
+    *dn = dc_dv(DNodeBlockStatement, dn_block(dc_unwrap2(condition_as_bool) ? if_node.consequence : if_node.alternative));
+
+    dc_ret();
+}
+
+static DCResVoid optimize_node(DEvaluator* de, DCDynValPtr dn)
+{
+    DC_RES_void();
+
+    if (!dn) dc_ret();
+
+    switch (dn->type)
+    {
+        case dc_dvt(DCDynValPtr):
+            return optimize_node(de, dc_dv_as(*dn, DCDynValPtr));
+
+        case dc_dvt(DNodeProgram):
+            return optimize_children(de, dc_dv_as(*dn, DNodeProgram).statements);
+
+        case dc_dvt(DNodeLetStatement):
+            return optimize_node(de, dc_dv_as(*dn, DNodeLetStatement).value);
+
+        case dc_dvt(DNodeReturnStatement):
+            return optimize_node(de, dc_dv_as(*dn, DNodeReturnStatement).ret_val);
+
+        case dc_dvt(DNodeBlockStatement):
+            return optimize_children(de, dc_dv_as(*dn, DNodeBlockStatement).statements);
+
+        case dc_dvt(DNodePrefixExpression):
+            return fold_prefix(de, dn);
+
+        case dc_dvt(DNodeInfixExpression):
+            return fold_infix(de, dn);
+
+        case dc_dvt(DNodeIfExpression):
+            return fold_if(de, dn);
+
+        case dc_dvt(DNodeArrayLiteral):
+            return optimize_children(de, dc_dv_as(*dn, DNodeArrayLiteral).array);
+
+        case dc_dvt(DNodeHashTableLiteral):
+            return optimize_children(de, dc_dv_as(*dn, DNodeHashTableLiteral).key_values);
+
+        case dc_dvt(DNodeIndexExpression):
+        {
+            DNodeIndexExpression index_exp = dc_dv_as(*dn, DNodeIndexExpression);
+
+            dc_try_fail(optimize_node(de, index_exp.operand));
+
+            return optimize_node(de, index_exp.index);
+        }
+
+        case dc_dvt(DNodeCallExpression):
+        {
+            DNodeCallExpression call_exp = dc_dv_as(*dn, DNodeCallExpression);
+
+            dc_try_fail(optimize_node(de, call_exp.function));
+
+            return optimize_children(de, call_exp.arguments);
+        }
+
+        case dc_dvt(DNodeFunctionLiteral):
+            return optimize_children(de, dc_dv_as(*dn, DNodeFunctionLiteral).body);
+
+        default:
+            break;
+    };
+
+    dc_ret();
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Folds the prefix and infix expressions over integer, boolean and string constants
+ * and replaces the if expressions with a constant condition by the taken branch
+ *
+ * NOTE: It runs before the resolver, operations that fail are not folded so the error
+ * is still reported at runtime, and only if the expression is actually evaluated
+ */
+DCResVoid dang_optimize(DEvaluator* de, DNodeProgram* program)
+{
+    DC_RES_void();
+
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot optimize using NULL evaluator");
+    if (!program) dc_ret_e(dc_e_code(NV), "cannot optimize NULL program");
+
+    dc_try_fail(optimize_children(de, program->statements));
+
+    dc_ret();
+}
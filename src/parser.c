@@ -96,9 +96,12 @@ static DCRes parse_statement(DParser* p);
 
 #define unexpected_token_err_fmt(TYPE) "unexpected token '%s'.", tostr_DTokType(TYPE)
 
-#define pool_last_el(P) &dc_da_get2(*(P)->pool, (P)->pool->count - 1)
-
-#define return_pool_last_el(P) dc_res_ok(dc_dv(DCDynValPtr, pool_last_el(P)))
+/**
+ * Copies the node to the arena and declares `NAME` as its stable address
+ */
+#define arena_node_or_fail(P, NAME, NODE)                                                                                      \
+    dc_try_or_fail_with3(ResDNodePtr, NAME##_res, dang_arena_push_node((P)->arena, (NODE)), {});                               \
+    DCDynValPtr NAME = dc_unwrap2(NAME##_res)
 
 static DCResVoid next_token(DParser* p)
 {
@@ -167,6 +170,41 @@ static Precedence get_precedence(DTokType type)
     return PREC_LOWEST;
 }
 
+static DOperator infix_operator(DTokType type)
+{
+    switch (type)
+    {
+        case TOK_PLUS:
+            return DOP_ADD;
+
+        case TOK_MINUS:
+            return DOP_SUB;
+
+        case TOK_ASTERISK:
+            return DOP_MUL;
+
+        case TOK_SLASH:
+            return DOP_DIV;
+
+        case TOK_LT:
+            return DOP_LT;
+
+        case TOK_GT:
+            return DOP_GT;
+
+        case TOK_EQ:
+            return DOP_EQ;
+
+        case TOK_NEQ:
+            return DOP_NEQ;
+
+        default:
+            break;
+    };
+
+    return DOP__MAX;
+}
+
 static DCRes parse_illegal(DParser* p)
 {
     DC_RES();
@@ -177,32 +215,21 @@ static DCRes parse_illegal(DParser* p)
 static DCRes parse_identifier(DParser* p)
 {
     DC_RES();
-    string data = NULL;
-    dc_try_fail_temp(DCResUsize, dc_sprintf(&data, DCPRIsv, dc_sv_fmt(p->current_token.text)));
 
-    dc_try_or_fail_with3(DCResVoid, res, dc_da_push(p->pool, dc_dva(string, data)), { free(data); });
+    dc_try_or_fail_with3(DCResString, data_res, dang_arena_intern(p->arena, p->current_token.text), {});
 
-    dc_ret_ok_dv(DNodeIdentifier, dn_identifier(data));
+    dc_ret_ok_dv(DNodeIdentifier, dn_identifier(dc_unwrap2(data_res)));
 }
 
 static DCRes parse_string_literal(DParser* p)
 {
     DC_RES();
 
-    DCDynVal data;
+    DCStringView text = p->current_token.text;
 
-    if (p->current_token.text.len == 0)
-        data = dc_dv(string, "");
-    else
-    {
-        string data_str = NULL;
-        dc_try_fail_temp(DCResUsize, dc_sprintf(&data_str, DCPRIsv, dc_sv_fmt(p->current_token.text)));
-        data = dc_dv(string, data_str);
+    dc_try_or_fail_with3(DCResString, data_res, dang_arena_intern(p->arena, text), {});
 
-        dc_try_or_fail_with3(DCResVoid, res, dc_da_push(p->pool, dc_dva(string, data_str)), { free(data_str); });
-    }
-
-    dc_ret_ok(data);
+    dc_ret_ok_dv(DoString, do_string_of(dc_unwrap2(data_res), text.len, dang_symbol_of(dc_unwrap2(data_res))));
 }
 
 static DCRes parse_integer_literal(DParser* p)
@@ -215,10 +242,10 @@ static DCRes parse_integer_literal(DParser* p)
     DCResI64 i64_res = dc_str_to_i64(str);
     dc_ret_if_err2(i64_res, {
         dc_err_dbg_log2(i64_res, "could not parse token text to i64 number");
-        free(str);
+        dc_sfree(str);
     });
 
-    free(str);
+    dc_sfree(str);
 
     dc_ret_ok_dv(i64, dc_unwrap2(i64_res));
 }
@@ -235,49 +262,30 @@ static DCResDa parse_function_params(DParser* p)
 
     dc_try_fail_temp(DCResVoid, next_token(p));
 
-    dc_try_fail(dc_da_new(NULL));
-
-    DCDynArrPtr arr = dc_unwrap();
+    usize mark = dang_arena_list_mark(p->arena);
 
     while (current_token_is_not(p, TOK_RPAREN) && current_token_is_not(p, TOK_EOF))
     {
         DCRes ident = parse_identifier(p);
-        dc_ret_if_err2(ident, {
-            dc_try_fail_temp(DCResVoid, dc_da_free(arr));
-            free(arr);
-        });
+        dc_ret_if_err2(ident, { dang_arena_list_drop(p->arena, mark); });
 
-        dc_try_or_fail_with3(DCResVoid, res, dc_da_push(arr, dc_unwrap2(ident)), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(arr));
-            free(arr);
-        });
+        dc_try_or_fail_with3(DCResVoid, res, dang_arena_list_push(p->arena, dc_unwrap2(ident)),
+                             { dang_arena_list_drop(p->arena, mark); });
 
-        dc_try_or_fail_with2(res, next_token(p), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(arr));
-            free(arr);
-        });
+        dc_try_or_fail_with2(res, next_token(p), { dang_arena_list_drop(p->arena, mark); });
 
         if (current_token_is(p, TOK_COMMA))
-            dc_try_or_fail_with2(res, next_token(p), {
-                dc_try_fail_temp(DCResVoid, dc_da_free(arr));
-                free(arr);
-            });
+            dc_try_or_fail_with2(res, next_token(p), { dang_arena_list_drop(p->arena, mark); });
     }
 
     if (current_token_is_not(p, TOK_RPAREN))
     {
-        dc_try_fail_temp(DCResVoid, dc_da_free(arr));
-        free(arr);
+        dang_arena_list_drop(p->arena, mark);
 
         dc_ret_ea(-1, "unclosed parenthesis, " current_token_err_fmt(p, TOK_RPAREN));
     }
 
-    dc_try_or_fail_with3(DCResVoid, res, dc_da_push(p->pool, dc_dva(DCDynArrPtr, arr)), {
-        dc_try_fail_temp(DCResVoid, dc_da_free(arr));
-        free(arr);
-    });
-
-    dc_ret();
+    return dang_arena_list_end(p->arena, mark);
 }
 
 /**
@@ -297,23 +305,13 @@ static DCRes parse_function_literal(DParser* p)
     /* a function also needs body which can be empty but it's mandatory */
 
     DCResVoid res = move_if_peek_token_is(p, TOK_LBRACE);
-    dc_ret_if_err2(res, {
-        dc_err_dbg_log2(res, "function literal needs body");
-
-        dc_try_fail_temp(DCResVoid, dc_da_free(params_arr));
-        free(params_arr);
-    });
+    dc_ret_if_err2(res, { dc_err_dbg_log2(res, "function literal needs body"); });
 
     dang_parser_location_preserve(p);
     DCRes body = parse_block_statement(p);
     dang_parser_location_revert(p);
 
-    dc_ret_if_err2(body, {
-        dc_err_dbg_log2(body, "could not parse function literal body");
-
-        dc_try_fail_temp(DCResVoid, dc_da_free(params_arr));
-        free(params_arr);
-    });
+    dc_ret_if_err2(body, { dc_err_dbg_log2(body, "could not parse function literal body"); });
 
     DCDynArrPtr body_statements = dc_dv_as(dc_unwrap2(body), DNodeBlockStatement).statements;
 
@@ -331,44 +329,25 @@ static DCResDa parse_expression_list(DParser* p)
 {
     DC_RES_da();
 
-    dc_try_fail(dc_da_new(NULL));
-
-    DCDynArrPtr exp_list = dc_unwrap();
+    usize mark = dang_arena_list_mark(p->arena);
 
     while (!token_is_end_of_the_statement(p, current) && current_token_is_not(p, TOK_EOF))
     {
         DCRes param = parse_expression(p, PREC_LOWEST);
 
-        dc_ret_if_err2(param, {
-            dc_try_fail_temp(DCResVoid, dc_da_free(exp_list));
-            free(exp_list);
-        });
+        dc_ret_if_err2(param, { dang_arena_list_drop(p->arena, mark); });
 
-        DCResVoid res = dc_da_push(exp_list, dc_unwrap2(param));
-        dc_ret_if_err2(res, {
-            dc_try_fail_temp(DCResVoid, dc_da_free(exp_list));
-            free(exp_list);
-        });
+        DCResVoid res = dang_arena_list_push(p->arena, dc_unwrap2(param));
+        dc_ret_if_err2(res, { dang_arena_list_drop(p->arena, mark); });
 
         dang_parser_dbg_log_tokens(p);
 
-        dc_try_or_fail_with2(res, next_token(p), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(exp_list));
-            free(exp_list);
-        });
+        dc_try_or_fail_with2(res, next_token(p), { dang_arena_list_drop(p->arena, mark); });
         if (current_token_is(p, TOK_COMMA))
-            dc_try_or_fail_with2(res, next_token(p), {
-                dc_try_fail_temp(DCResVoid, dc_da_free(exp_list));
-                free(exp_list);
-            });
+            dc_try_or_fail_with2(res, next_token(p), { dang_arena_list_drop(p->arena, mark); });
     }
 
-    dc_try_or_fail_with3(DCResVoid, res, dc_da_push(p->pool, dc_dva(DCDynArrPtr, exp_list)), {
-        dc_try_fail_temp(DCResVoid, dc_da_free(exp_list));
-        free(exp_list);
-    });
-
-    dc_ret();
+    return dang_arena_list_end(p->arena, mark);
 }
 
 /**
@@ -410,9 +389,9 @@ static DCRes parse_call_expression(DParser* p)
         params = dc_unwrap2(params_res);
     }
 
-    dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_unwrap2(callee)), {});
+    arena_node_or_fail(p, function, dc_unwrap2(callee));
 
-    dc_ret_ok_dv(DNodeCallExpression, dn_call(pool_last_el(p), params));
+    dc_ret_ok_dv(DNodeCallExpression, dn_call(function, params));
 }
 
 /**
@@ -428,8 +407,7 @@ static DCRes parse_hash_literal(DParser* p)
     /* Bypassing all the meaningless newlines */
     try_bypassing_all_nls_or_fail_with(p, { dc_err_dbg_log2(res, "could move to the next token"); });
 
-    dc_try_or_fail_with3(DCResDa, key_values_res, dc_da_new(NULL), {});
-    DCDynArrPtr key_values = dc_unwrap2(key_values_res);
+    usize mark = dang_arena_list_mark(p->arena);
 
     dang_parser_location_preserve(p);
 
@@ -439,67 +417,39 @@ static DCRes parse_hash_literal(DParser* p)
         DCRes key = parse_expression(p, PREC_LOWEST);
         dang_parser_location_revert(p);
 
-        dc_ret_if_err2(key, {
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
-        });
+        dc_ret_if_err2(key, { dang_arena_list_drop(p->arena, mark); });
 
-        dc_try_or_fail_with2(res, dc_da_push(key_values, dc_unwrap2(key)), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
-        });
+        dc_try_or_fail_with2(res, dang_arena_list_push(p->arena, dc_unwrap2(key)), { dang_arena_list_drop(p->arena, mark); });
 
         dang_parser_dbg_log_tokens(p);
 
-        dc_try_or_fail_with2(res, move_if_peek_token_is(p, TOK_COLON), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
-        });
-        dc_try_or_fail_with2(res, next_token(p), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
-        });
+        dc_try_or_fail_with2(res, move_if_peek_token_is(p, TOK_COLON), { dang_arena_list_drop(p->arena, mark); });
+        dc_try_or_fail_with2(res, next_token(p), { dang_arena_list_drop(p->arena, mark); });
 
         DCRes value = parse_expression(p, PREC_LOWEST);
         dang_parser_location_revert(p);
 
-        dc_ret_if_err2(value, {
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
-        });
+        dc_ret_if_err2(value, { dang_arena_list_drop(p->arena, mark); });
 
-        dc_try_or_fail_with2(res, dc_da_push(key_values, dc_unwrap2(value)), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
-        });
+        dc_try_or_fail_with2(res, dang_arena_list_push(p->arena, dc_unwrap2(value)), { dang_arena_list_drop(p->arena, mark); });
 
         dang_parser_dbg_log_tokens(p);
 
-        dc_try_or_fail_with2(res, next_token(p), {
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
-        });
+        dc_try_or_fail_with2(res, next_token(p), { dang_arena_list_drop(p->arena, mark); });
         if (current_token_is(p, TOK_COMMA))
-            dc_try_or_fail_with2(res, next_token(p), {
-                dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-                free(key_values);
-            });
+            dc_try_or_fail_with2(res, next_token(p), { dang_arena_list_drop(p->arena, mark); });
 
         /* Bypassing all the meaningless newlines */
         try_bypassing_all_nls_or_fail_with(p, {
             dc_err_dbg_log2(res, "could move to the next token");
 
-            dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-            free(key_values);
+            dang_arena_list_drop(p->arena, mark);
         });
     }
 
-    dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_dva(DCDynArrPtr, key_values)), {
-        dc_try_fail_temp(DCResVoid, dc_da_free(key_values));
-        free(key_values);
-    });
+    dc_try_or_fail_with3(DCResDa, key_values, dang_arena_list_end(p->arena, mark), {});
 
-    dc_ret_ok_dv(DNodeHashTableLiteral, dn_hash_table(key_values));
+    dc_ret_ok_dv(DNodeHashTableLiteral, dn_hash_table(dc_unwrap2(key_values)));
 }
 
 /**
@@ -599,10 +549,10 @@ static DCRes parse_if_expression(DParser* p)
         alternative_statements = dc_dv_as(dc_unwrap2(alternative), DNodeBlockStatement).statements;
     }
 
-    // push condition to the pool
-    dc_try_fail_temp(DCResVoid, dc_da_push(p->pool, dc_unwrap2(condition)));
+    // move condition to the arena
+    arena_node_or_fail(p, condition_node, dc_unwrap2(condition));
 
-    dc_ret_ok_dv(DNodeIfExpression, (dn_if(pool_last_el(p), consequence_statements, alternative_statements)));
+    dc_ret_ok_dv(DNodeIfExpression, (dn_if(condition_node, consequence_statements, alternative_statements)));
 }
 
 static DCRes parse_prefix_expression(DParser* p)
@@ -619,14 +569,9 @@ static DCRes parse_prefix_expression(DParser* p)
 
     dc_ret_if_err2(right, { dc_err_dbg_log2(right, "could not parse right hand side"); });
 
-    string op = NULL;
-    dc_try_fail_temp(DCResUsize, dc_sprintf(&op, DCPRIsv, dc_sv_fmt(tok.text)));
-
-    dc_try_or_fail_with3(DCResVoid, res, dc_da_push(p->pool, dc_dva(string, op)), if (op) free(op));
-
-    dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_unwrap2(right)), if (op) free(op));
+    arena_node_or_fail(p, operand, dc_unwrap2(right));
 
-    dc_ret_ok_dv(DNodePrefixExpression, dn_prefix(op, pool_last_el(p)));
+    dc_ret_ok_dv(DNodePrefixExpression, dn_prefix(tok.type == TOK_BANG ? DOP_NOT : DOP_NEG, operand));
 }
 
 /**
@@ -636,35 +581,25 @@ static DCRes parse_infix_expression(DParser* p, DCDynValPtr left)
 {
     DC_RES();
 
-    string op = NULL;
-    dc_try_fail_temp(DCResUsize, dc_sprintf(&op, DCPRIsv, dc_sv_fmt(p->current_token.text)));
+    DOperator op = infix_operator(p->current_token.type);
+    if (op == DOP__MAX)
+        dc_ret_ea(-1, "unsupported infix operator '" DCPRIsv "'", dc_sv_fmt(p->current_token.text));
 
     Precedence prec = current_prec(p);
 
-    DCResVoid res = next_token(p);
-    dc_ret_if_err2(res, {
-        dc_err_dbg_log2(res, "could not move to the next token");
-
-        if (op) free(op);
-    });
+    dc_try_fail_temp(DCResVoid, next_token(p));
 
     dang_parser_location_preserve(p);
     DCRes right = parse_expression(p, prec);
     dang_parser_location_revert(p);
 
-    dc_ret_if_err2(right, {
-        dc_err_dbg_log2(right, "could not parse right hand side");
-
-        if (op) free(op);
-    });
+    dc_ret_if_err2(right, { dc_err_dbg_log2(right, "could not parse right hand side"); });
 
     dang_parser_dbg_log_tokens(p);
 
-    dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_dva(string, op)), if (op) free(op));
-
-    dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_unwrap2(right)), if (op) free(op));
+    arena_node_or_fail(p, right_node, dc_unwrap2(right));
 
-    dc_ret_ok_dv(DNodeInfixExpression, dn_infix(op, left, pool_last_el(p)));
+    dc_ret_ok_dv(DNodeInfixExpression, dn_infix(op, left, right_node));
 }
 
 static DCRes parse_index_expression(DParser* p, DCDynValPtr operand)
@@ -682,9 +617,9 @@ static DCRes parse_index_expression(DParser* p, DCDynValPtr operand)
     dc_try_or_fail_with3(DCResVoid, res, move_if_peek_token_is(p, TOK_RBRACKET),
                          { dc_err_dbg_log2(res, "index expression must have one expression and closed with ']'"); });
 
-    dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_unwrap2(expression)), {});
+    arena_node_or_fail(p, index, dc_unwrap2(expression));
 
-    dc_ret_ok_dv(DNodeIndexExpression, dn_index(operand, pool_last_el(p)));
+    dc_ret_ok_dv(DNodeIndexExpression, dn_index(operand, index));
 }
 
 /**
@@ -727,10 +662,10 @@ static DCRes parse_let_statement(DParser* p)
     {
         dc_try_or_fail_with2(res, next_token(p), { dc_err_dbg_log2(res, "could not move to the next token"); });
 
-        // push the temp_node that is the initial value to the pool
-        dc_try_fail_temp(DCResVoid, dc_da_push(p->pool, dc_unwrap2(temp_node)));
+        // move the temp_node that is the initial value to the arena
+        arena_node_or_fail(p, value, dc_unwrap2(temp_node));
 
-        dc_ret_ok_dv(DNodeLetStatement, dn_let(ident.value, pool_last_el(p))); // return successfully
+        dc_ret_ok_dv(DNodeLetStatement, dn_let(ident.value, value)); // return successfully
     }
 
     dc_ret_ea(-1, "end of statement needed, got token of type %s.", tostr_DTokType(p->peek_token.type));
@@ -764,10 +699,10 @@ static DCRes parse_return_statement(DParser* p)
     {
         dc_try_or_fail_with2(res, next_token(p), { dc_err_dbg_log2(res, "could not move to the next token"); });
 
-        // push the value that is the initial value to the pool
-        dc_try_fail_temp(DCResVoid, dc_da_push(p->pool, dc_unwrap2(value)));
+        // move the return value to the arena
+        arena_node_or_fail(p, ret_val, dc_unwrap2(value));
 
-        dc_ret_ok_dv(DNodeReturnStatement, dn_return(pool_last_el(p))); // return successfully
+        dc_ret_ok_dv(DNodeReturnStatement, dn_return(ret_val)); // return successfully
     }
 
     dc_ret_ea(-1, "end of statement needed, got token of type %s.", tostr_DTokType(p->peek_token.type));
@@ -780,57 +715,57 @@ static DCRes parse_block_statement(DParser* p)
     // Try to bypass the '{'
     dc_try_fail_temp(DCResVoid, next_token(p));
 
-    dc_try_or_fail_with3(DCResDa, statements_res, dc_da_new(NULL), {});
-
-    DCDynArrPtr statements = dc_unwrap2(statements_res);
+    usize mark = dang_arena_list_mark(p->arena);
 
     DCResVoid res;
 
     while (current_token_is_not(p, TOK_RBRACE) && current_token_is_not(p, TOK_EOF))
     {
         /* Bypassing all the meaningless newlines and semicolons */
-        try_bypassing_all_sc_and_nls_or_fail_with(p, { dc_err_dbg_log2(res, "could move to the next token"); });
+        try_bypassing_all_sc_and_nls_or_fail_with(p, {
+            dc_err_dbg_log2(res, "could move to the next token");
+
+            dang_arena_list_drop(p->arena, mark);
+        });
 
         // Enter the block
         dang_parser_location_set(p, LOC_BLOCK);
 
         DCRes stmt = parse_statement(p);
-        dc_ret_if_err2(stmt, { dc_err_dbg_log2(stmt, "cannot parse block statement"); });
+        dc_ret_if_err2(stmt, {
+            dc_err_dbg_log2(stmt, "cannot parse block statement");
+
+            dang_arena_list_drop(p->arena, mark);
+        });
 
         dang_parser_dbg_log_tokens(p);
 
-        res = dc_da_push(statements, dc_unwrap2(stmt));
+        res = dang_arena_list_push(p->arena, dc_unwrap2(stmt));
         dc_ret_if_err2(res, {
             dc_err_dbg_log2(res, "could not push the statement to the block");
 
-            dc_try_fail_temp(DCResVoid, dc_da_free(statements));
-            free(statements);
+            dang_arena_list_drop(p->arena, mark);
         });
 
         /* Bypassing all the meaningless newlines and semicolons */
         try_bypassing_all_sc_and_nls_or_fail_with(p, {
             dc_err_dbg_log2(res, "could move to the next token");
 
-            dc_try_fail_temp(DCResVoid, dc_da_free(statements));
-            free(statements);
+            dang_arena_list_drop(p->arena, mark);
         });
     }
 
     if (current_token_is(p, TOK_EOF))
     {
-        dc_try_fail_temp(DCResVoid, dc_da_free(statements));
-        free(statements);
+        dang_arena_list_drop(p->arena, mark);
 
         dc_ret_e(-1, "block ended with EOF, expected '}' instead");
     }
 
-    // push the statements to the pool
-    dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_dva(DCDynArrPtr, statements)), {
-        dc_try_fail_temp(DCResVoid, dc_da_free(statements));
-        free(statements);
-    });
+    // the statements are moved to the arena
+    dc_try_or_fail_with3(DCResDa, statements, dang_arena_list_end(p->arena, mark), {});
 
-    dc_ret_ok_dv(DNodeBlockStatement, dn_block(statements));
+    dc_ret_ok_dv(DNodeBlockStatement, dn_block(dc_unwrap2(statements)));
 }
 
 /**
@@ -868,11 +803,11 @@ static DCRes parse_expression(DParser* p, Precedence precedence)
 
         dc_try_or_fail_with3(DCResVoid, res, next_token(p), { dc_err_dbg_log2(res, "could not move to the next token"); });
 
-        // push the left to the pool
-        dc_try_or_fail_with2(res, dc_da_push(p->pool, dc_unwrap2(left_exp)), {});
+        // move the left to the arena
+        arena_node_or_fail(p, left, dc_unwrap2(left_exp));
 
         dang_parser_location_preserve(p);
-        left_exp = infix(p, pool_last_el(p));
+        left_exp = infix(p, left);
         dang_parser_location_revert(p);
     }
 
@@ -912,10 +847,10 @@ static DCRes parse_expression_statement(DParser* p)
 
     DCDynArrPtr params = dc_unwrap2(params_res);
 
-    // push the callee to the pool
-    dc_try_fail_temp(DCResVoid, dc_da_push(p->pool, dc_unwrap2(callee)));
+    // move the callee to the arena
+    arena_node_or_fail(p, function, dc_unwrap2(callee));
 
-    dc_ret_ok_dv(DNodeCallExpression, dn_call(pool_last_el(p), params));
+    dc_ret_ok_dv(DNodeCallExpression, dn_call(function, params));
 }
 
 /**
@@ -965,9 +900,7 @@ static ResDNodeProgram parser_parse_program(DParser* p)
 {
     DC_RES2(ResDNodeProgram);
 
-    dc_try_or_fail_with3(DCResDa, statements_res, dc_da_new2(30, 3, NULL), {});
-
-    DCDynArrPtr statements = dc_unwrap2(statements_res);
+    usize mark = dang_arena_list_mark(p->arena);
 
     DCResVoid res = {0};
 
@@ -995,9 +928,9 @@ static ResDNodeProgram parser_parse_program(DParser* p)
 
         if (dc_is_ok2(stmt))
         {
-            // stmt is a DCDynValPtr to the actual dynamic value in the pool
+            // stmt is a DCDynValPtr to the actual dynamic value in the arena
             // or it might be actual value if the value doesn't worth to be saved
-            res = dc_da_push(statements, dc_unwrap2(stmt));
+            res = dang_arena_list_push(p->arena, dc_unwrap2(stmt));
             if (dc_is_err2(res))
             {
                 dc_err_dbg_log2(res, "could not push the statement to program");
@@ -1014,16 +947,15 @@ static ResDNodeProgram parser_parse_program(DParser* p)
     // all errors are saved in the parser's errors field
     if (dang_parser_has_error(p))
     {
-        dc_try_fail_temp(DCResVoid, dc_da_free(statements));
-        free(statements);
+        dang_arena_list_drop(p->arena, mark);
 
         dc_ret_e(-1, "parser has error");
     }
 
-    // push the program statements in the pool
-    dc_da_push(p->pool, dc_dva(DCDynArrPtr, statements));
+    // the program statements are moved to the arena as well
+    dc_try_or_fail_with3(DCResDa, statements, dang_arena_list_end(p->arena, mark), {});
 
-    dc_ret_ok(dn_program(statements));
+    dc_ret_ok(dn_program(dc_unwrap2(statements)));
 }
 
 // ***************************************************************************************
@@ -1066,11 +998,11 @@ ResDNodeProgram dang_parse(DParser* p, const string source)
     return parser_parse_program(p);
 }
 
-DCResVoid dang_parser_init(DParser* p, DCDynArrPtr pool, DCDynArrPtr errors)
+DCResVoid dang_parser_init(DParser* p, DArena* arena, DCDynArrPtr errors)
 {
     DC_RES_void();
 
-    if (!p || !pool || !errors)
+    if (!p || !arena || !errors)
     {
         dc_dbg_log("DParser or DScanner cannot be NULL");
 
@@ -1078,10 +1010,10 @@ DCResVoid dang_parser_init(DParser* p, DCDynArrPtr pool, DCDynArrPtr errors)
     }
 
     p->scanner = (DScanner){0};
-    if (pool->cap == 0) dc_try_fail(dc_da_init2(pool, 50, 3, NULL));
+    if (!arena->chunks) dc_try_fail(dang_arena_init(arena));
     if (errors->cap == 0) dc_try_fail(dc_da_init2(errors, 20, 2, NULL));
 
-    p->pool = pool;
+    p->arena = arena;
     p->errors = errors;
 
     p->current_token.type = TOK_TYPE_MAX;
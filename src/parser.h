@@ -48,7 +48,7 @@ typedef struct
 
     DScanner scanner;
 
-    DCDynArrPtr pool;
+    DArena* arena;
     DCDynArrPtr errors;
 } DParser;
 
@@ -56,7 +56,7 @@ typedef struct
 
 ResDNodeProgram dang_parse(DParser* p, const string source);
 
-DCResVoid dang_parser_init(DParser* p, DCDynArrPtr pool, DCDynArrPtr errors);
+DCResVoid dang_parser_init(DParser* p, DArena* arena, DCDynArrPtr errors);
 void dang_parser_log_errors(DParser* p);
 
 typedef DCRes (*ParsePrefixFn)(DParser*);
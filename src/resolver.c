@@ -0,0 +1,316 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: resolver.c
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Resolver (lexical addressing) source file
+// *               Binds identifiers, let statements and parameters to (depth, slot) pairs
+// ***************************************************************************************
+
+#include "resolver.h"
+
+// ***************************************************************************************
+// * TYPES
+// ***************************************************************************************
+
+/**
+ * Each function body is resolved in two passes
+ *
+ * First all the let statements are declared in the function scope (blocks don't
+ * create scopes), so nested functions can refer to the variables that are defined later
+ * Then identifiers are bound to the innermost scope that declares them
+ */
+typedef enum
+{
+    RESOLVE_DECLARE,
+    RESOLVE_BIND,
+} DResolvePass;
+
+/**
+ * Chain of the scopes being resolved, it lives on the C stack
+ * The last one in the chain is always the global scope
+ */
+typedef struct DResolverScope
+{
+    DScopePtr scope;
+    struct DResolverScope* enclosing;
+} DResolverScope;
+
+// ***************************************************************************************
+// * FORWARD DECLARATIONS
+// ***************************************************************************************
+
+static DCResVoid resolve_node(DEvaluator* de, DResolverScope* rs, DCDynValPtr dn, DResolvePass pass);
+static void mark_tail_statements(DCDynArrPtr statements);
+
+// ***************************************************************************************
+// * PRIVATE FUNCTIONS
+// ***************************************************************************************
+
+static DCResVoid resolve_children(DEvaluator* de, DResolverScope* rs, DCDynArrPtr children, DResolvePass pass)
+{
+    DC_RES_void();
+
+    if (!children) dc_ret();
+
+    dc_da_for(resolve_children_loop, *children, { dc_try_fail(resolve_node(de, rs, _it, pass)); });
+
+    dc_ret();
+}
+
+static DCResVoid bind_identifier(DEvaluator* de, DResolverScope* rs, DNodeIdentifier* ident)
+{
+    DC_RES_void();
+
+    // builtin functions are only used if no variable is defined under the same name
+    ident->builtin = dang_find_builtin(de, ident->value);
+
+    usize depth = 0;
+
+    for (DResolverScope* it = rs; it; it = it->enclosing, ++depth)
+    {
+        DCResUsize slot_res = dang_scope_find(it->scope, ident->value);
+        if (dc_is_ok2(slot_res))
+        {
+            ident->depth = depth;
+            ident->slot = dc_unwrap2(slot_res);
+
+            dc_ret();
+        }
+    }
+
+    // not declared anywhere, so it must be a global that is defined later or a builtin
+    // reserving a global slot for it, reading it while it's not defined uses the builtin if any
+    dc_try_or_fail_with3(DCResUsize, slot_res, dang_scope_declare(&de->globals, ident->value), {});
+
+    ident->depth = depth - 1;
+    ident->slot = dc_unwrap2(slot_res);
+
+    dc_ret();
+}
+
+/**
+ * Marks the calls whose value is directly the return value of the function
+ * (the node itself, the last statement of a block or of the branches of an if expression)
+ */
+static void mark_tail_position(DCDynValPtr dn)
+{
+    if (!dn) return;
+
+    switch (dn->type)
+    {
+        case dc_dvt(DCDynValPtr):
+            mark_tail_position(dc_dv_as(*dn, DCDynValPtr));
+            break;
+
+        case dc_dvt(DNodeCallExpression):
+            dc_dv_as(*dn, DNodeCallExpression).tail = true;
+            break;
+
+        case dc_dvt(DNodeReturnStatement):
+            mark_tail_position(dc_dv_as(*dn, DNodeReturnStatement).ret_val);
+            break;
+
+        case dc_dvt(DNodeBlockStatement):
+            mark_tail_statements(dc_dv_as(*dn, DNodeBlockStatement).statements);
+            break;
+
+        case dc_dvt(DNodeIfExpression):
+        {
+            DNodeIfExpression if_node = dc_dv_as(*dn, DNodeIfExpression);
+
+            mark_tail_statements(if_node.consequence);
+            mark_tail_statements(if_node.alternative);
+
+            break;
+        }
+
+        default:
+            break;
+    };
+}
+
+static void mark_tail_statements(DCDynArrPtr statements)
+{
+    if (!statements || statements->count == 0) return;
+
+    mark_tail_position(&dc_da_get2(*statements, statements->count - 1));
+}
+
+static DCResVoid resolve_function(DEvaluator* de, DResolverScope* rs, DNodeFunctionLiteral* fn)
+{
+    DC_RES_void();
+
+    DScopePtr scope = (DScopePtr)dc_alloc(sizeof(DScope));
+    if (scope == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    dc_try_or_fail_with3(DCResVoid, res, dang_scope_init(scope), dc_dealloc(scope, sizeof(DScope)));
+
+    dc_try_or_fail_with3(DCResVoid, res2, dc_da_push(&de->compiled, dc_dva(DScopePtr, scope)), {
+        dc_dbg_log("failed to push function scope to the compiled objects");
+        dc_try_fail_temp(DCResVoid, dang_scope_free(scope));
+        dc_dealloc(scope, sizeof(DScope));
+    });
+
+    fn->scope = scope;
+
+    // the enclosing functions can be captured by this one (directly or by its own nested functions)
+    for (DResolverScope* it = rs; it->enclosing; it = it->enclosing)
+        it->scope->escapes = true;
+
+    // parameters always take the first slots
+    dc_da_for(resolve_params_loop, *fn->parameters, {
+        DNodeIdentifier* param = &dc_dv_as(*_it, DNodeIdentifier);
+
+        dc_try_or_fail_with3(DCResUsize, slot_res, dang_scope_declare(scope, param->value), {});
+
+        param->depth = 0;
+        param->slot = dc_unwrap2(slot_res);
+    });
+
+    DResolverScope fn_rs = {.scope = scope, .enclosing = rs};
+
+    dc_try_fail(resolve_children(de, &fn_rs, fn->body, RESOLVE_DECLARE));
+    dc_try_fail(resolve_children(de, &fn_rs, fn->body, RESOLVE_BIND));
+
+    mark_tail_statements(fn->body);
+
+    dc_ret();
+}
+
+static DCResVoid resolve_node(DEvaluator* de, DResolverScope* rs, DCDynValPtr dn, DResolvePass pass)
+{
+    DC_RES_void();
+
+    if (!dn) dc_ret();
+
+    switch (dn->type)
+    {
+        case dc_dvt(DCDynValPtr):
+            return resolve_node(de, rs, dc_dv_as(*dn, DCDynValPtr), pass);
+
+        case dc_dvt(DNodeProgram):
+            return resolve_children(de, rs, dc_dv_as(*dn, DNodeProgram).statements, pass);
+
+        case dc_dvt(DNodeIdentifier):
+            if (pass == RESOLVE_BIND) return bind_identifier(de, rs, &dc_dv_as(*dn, DNodeIdentifier));
+            break;
+
+        case dc_dvt(DNodeLetStatement):
+        {
+            DNodeLetStatement* let_node = &dc_dv_as(*dn, DNodeLetStatement);
+
+            if (pass == RESOLVE_DECLARE)
+            {
+                dc_try_or_fail_with3(DCResUsize, slot_res, dang_scope_declare(rs->scope, let_node->name), {});
+
+                let_node->slot = dc_unwrap2(slot_res);
+            }
+
+            return resolve_node(de, rs, let_node->value, pass);
+        }
+
+        case dc_dvt(DNodeReturnStatement):
+            // returning from a function (not the global scope) is always a tail position
+            if (pass == RESOLVE_BIND && rs->enclosing) mark_tail_position(dn);
+
+            return resolve_node(de, rs, dc_dv_as(*dn, DNodeReturnStatement).ret_val, pass);
+
+        case dc_dvt(DNodeBlockStatement):
+            return resolve_children(de, rs, dc_dv_as(*dn, DNodeBlockStatement).statements, pass);
+
+        case dc_dvt(DNodePrefixExpression):
+            return resolve_node(de, rs, dc_dv_as(*dn, DNodePrefixExpression).operand, pass);
+
+        case dc_dvt(DNodeInfixExpression):
+        {
+            DNodeInfixExpression infix_node = dc_dv_as(*dn, DNodeInfixExpression);
+
+            dc_try_fail(resolve_node(de, rs, infix_node.left, pass));
+
+            return resolve_node(de, rs, infix_node.right, pass);
+        }
+
+        case dc_dvt(DNodeIfExpression):
+        {
+            DNodeIfExpression if_node = dc_dv_as(*dn, DNodeIfExpression);
+
+            dc_try_fail(resolve_node(de, rs, if_node.condition, pass));
+            dc_try_fail(resolve_children(de, rs, if_node.consequence, pass));
+
+            return resolve_children(de, rs, if_node.alternative, pass);
+        }
+
+        case dc_dvt(DNodeArrayLiteral):
+            return resolve_children(de, rs, dc_dv_as(*dn, DNodeArrayLiteral).array, pass);
+
+        case dc_dvt(DNodeHashTableLiteral):
+            return resolve_children(de, rs, dc_dv_as(*dn, DNodeHashTableLiteral).key_values, pass);
+
+        case dc_dvt(DNodeIndexExpression):
+        {
+            DNodeIndexExpression index_exp = dc_dv_as(*dn, DNodeIndexExpression);
+
+            dc_try_fail(resolve_node(de, rs, index_exp.operand, pass));
+
+            return resolve_node(de, rs, index_exp.index, pass);
+        }
+
+        case dc_dvt(DNodeCallExpression):
+        {
+            DNodeCallExpression call_exp = dc_dv_as(*dn, DNodeCallExpression);
+
+            dc_try_fail(resolve_node(de, rs, call_exp.function, pass));
+
+            return resolve_children(de, rs, call_exp.arguments, pass);
+        }
+
+        case dc_dvt(DNodeFunctionLiteral):
+            // function bodies get their own scope and are declared when they're being bound
+            if (pass == RESOLVE_BIND) return resolve_function(de, rs, &dc_dv_as(*dn, DNodeFunctionLiteral));
+            break;
+
+        default:
+            break;
+    };
+
+    dc_ret();
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Resolves the program against the global scope of the evaluator
+ *
+ * NOTE: The global scope persists between evaluations so later programs (e.g. REPL lines)
+ * keep the same slots for the same global names
+ */
+DCResVoid dang_resolve(DEvaluator* de, DNodeProgram* program)
+{
+    DC_RES_void();
+
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot resolve using NULL evaluator");
+    if (!program) dc_ret_e(dc_e_code(NV), "cannot resolve NULL program");
+
+    DResolverScope global_rs = {.scope = &de->globals, .enclosing = NULL};
+
+    dc_try_fail(resolve_children(de, &global_rs, program->statements, RESOLVE_DECLARE));
+    dc_try_fail(resolve_children(de, &global_rs, program->statements, RESOLVE_BIND));
+
+    dc_ret();
+}
@@ -0,0 +1,28 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: resolver.h
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Resolver (lexical addressing) header file
+// ***************************************************************************************
+
+#ifndef DANG_RESOLVER_H
+#define DANG_RESOLVER_H
+
+#include "evaluator.h"
+
+// ***************************************************************************************
+// * FUNCTION DECLARATIONS
+// ***************************************************************************************
+
+DCResVoid dang_resolve(DEvaluator* de, DNodeProgram* program);
+
+#endif // DANG_RESOLVER_H
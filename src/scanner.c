@@ -28,7 +28,7 @@
 
 static void read_char(DScanner* s)
 {
-    if (s->read_pos >= strlen(s->input))
+    if (s->read_pos >= s->input_len)
         s->c = 0;
     else
         s->c = s->input[s->read_pos];
@@ -39,7 +39,7 @@ static void read_char(DScanner* s)
 
 static char peek(DScanner* s)
 {
-    if (s->read_pos >= strlen(s->input)) return 0;
+    if (s->read_pos >= s->input_len) return 0;
 
     return s->input[s->read_pos];
 }
@@ -111,6 +111,7 @@ DCResVoid dang_scanner_init(DScanner* s, const string input)
     s->pos = 0;
     s->read_pos = 0;
     s->input = input;
+    s->input_len = strlen(input);
 
     read_char(s);
 
@@ -24,6 +24,7 @@
 typedef struct
 {
     string input;
+    usize input_len;
     usize pos;
     usize read_pos;
     char c;
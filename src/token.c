@@ -16,6 +16,8 @@
 
 #include "token.h"
 
+#include <string.h>
+
 string tostr_DTokType(DTokType dtt)
 {
     switch (dtt)
@@ -89,11 +91,15 @@ DTokType is_keyword(DCStringView* text)
         return TOK_IDENT;
 }
 
+/**
+ * NOTE: Only the text of the token is checked to not pass the end of the string,
+ * measuring the whole string for each token would make scanning quadratic
+ */
 ResTok token_create(DTokType type, string str, usize start, usize len)
 {
     DC_RES2(ResTok);
 
-    if (type != TOK_EOF && (!str || start + len > strlen(str)))
+    if (type != TOK_EOF && (!str || memchr(str + start, '\0', len) != NULL))
     {
         dc_dbg_log("Only TOK_EOF can be created with NULL string");
 
@@ -0,0 +1,269 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: value.c
+//    Date: 2024-10-17
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Compact runtime values source file
+// *               Packing the runtime values into single words for array storages and environment slots
+// ***************************************************************************************
+
+#include "value.h"
+#include "gc.h"
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+#define DANG_STORAGE_MIN_CAPACITY 8
+
+// ***************************************************************************************
+// * PRIVATE HELPER FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Whether the address can be tagged, the strings need the upper 16 bits for their length as well
+ */
+static b1 value_fits(voidptr address, b1 needs_upper_bits)
+{
+    uptr bits = (uptr)address;
+
+    if (bits == 0 || (bits & DANG_VALUE_TAG_MASK) != 0) return false;
+
+    return !needs_upper_bits || (bits & ~DANG_VALUE_ADDRESS_MASK) == 0;
+}
+
+static ResDValue value_box(DEvaluator* de, DCDynValPtr value)
+{
+    DC_RES2(ResDValue);
+
+    DBoxPtr box = (DBoxPtr)dc_alloc(sizeof(DBox));
+    if (box == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    box->value = *value;
+    box->value.allocated = false;
+    box->gc_flags = 0;
+
+    dc_try_or_fail_with3(DCResVoid, res, dang_gc_track(de, dc_dva(DBoxPtr, box)), {
+        dc_dbg_log("failed to track the box");
+        dc_dealloc(box, sizeof(DBox));
+    });
+
+    dc_ret_ok((DValue)(uptr)box);
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Compact value of the runtime value, the values that don't fit in a word get a box
+ * which is tracked by the garbage collector
+ *
+ * NOTE: The box is only reachable from the result, so it must be stored before the next safe point
+ */
+ResDValue dang_value_pack(DEvaluator* de, DCDynValPtr value)
+{
+    DC_RES2(ResDValue);
+
+    switch (value->type)
+    {
+        case DO_INTEGER:
+        {
+            i64 num = do_as_int(*value);
+
+            if (num >= DANG_VALUE_INT_MIN && num <= DANG_VALUE_INT_MAX) dc_ret_ok(((DValue)num << 1) | 1);
+
+            break;
+        }
+
+        case DO_BOOLEAN:
+            dc_ret_ok(dc_dv_as(*value, b1) ? DANG_VALUE_TRUE : DANG_VALUE_FALSE);
+
+        case dc_dvt(voidptr):
+            if (dc_dv_as(*value, voidptr) == NULL) dc_ret_ok(DANG_VALUE_NULL);
+
+            break;
+
+        case DO_ARRAY:
+            if (value_fits(do_as_array(*value), false)) dc_ret_ok((DValue)(uptr)do_as_array(*value) | DANG_VALUE_TAG_ARRAY);
+
+            break;
+
+        case DO_HASH_TABLE:
+        {
+            DCHashTablePtr ht = dc_dv_as(*value, DCHashTablePtr);
+
+            if (value_fits(ht, false)) dc_ret_ok((DValue)(uptr)ht | DANG_VALUE_TAG_HASH_TABLE);
+
+            break;
+        }
+
+        case DO_STRING:
+        {
+            DoString str = do_as_string(*value);
+
+            if (str.buf && str.str == str.buf->data && str.len <= DANG_VALUE_STRING_MAX_LEN && value_fits(str.buf, true))
+                dc_ret_ok((DValue)(uptr)str.buf | ((DValue)str.len << 48) | DANG_VALUE_TAG_STRING);
+
+            break;
+        }
+
+        default:
+            break;
+    };
+
+    return value_box(de, value);
+}
+
+DCDynVal dang_value_unpack(DValue value)
+{
+    if (dang_value_is_int(value)) return do_int(((i64)(value & ~(DValue)1)) / 2);
+
+    switch (value & DANG_VALUE_TAG_MASK)
+    {
+        case DANG_VALUE_TAG_ARRAY:
+            return dc_dv(DArrayPtr, (DArrayPtr)(uptr)(value & ~DANG_VALUE_TAG_MASK));
+
+        case DANG_VALUE_TAG_HASH_TABLE:
+            return dc_dv(DCHashTablePtr, (DCHashTablePtr)(uptr)(value & ~DANG_VALUE_TAG_MASK));
+
+        case DANG_VALUE_TAG_STRING:
+        {
+            DStringBufferPtr buf = (DStringBufferPtr)(uptr)(value & DANG_VALUE_ADDRESS_MASK);
+
+            return dc_dv(DoString, do_string_of(buf->data, (usize)(value >> 48), buf));
+        }
+
+        default:
+            break;
+    };
+
+    switch (value)
+    {
+        case DANG_VALUE_UNDEFINED:
+        case DANG_VALUE_NULL:
+            return dc_dv_nullptr();
+
+        case DANG_VALUE_FALSE:
+            return dc_dv_bool(false);
+
+        case DANG_VALUE_TRUE:
+            return dc_dv_bool(true);
+
+        default:
+            break;
+    };
+
+    return ((DBoxPtr)(uptr)value)->value;
+}
+
+/**
+ * Address of the runtime object (or the box) the value refers to, NULL for the integers and the immediates
+ */
+voidptr dang_value_object(DValue value)
+{
+    if (!dang_value_is_object(value)) return NULL;
+
+    if ((value & DANG_VALUE_TAG_MASK) == DANG_VALUE_TAG_STRING) return (voidptr)(uptr)(value & DANG_VALUE_ADDRESS_MASK);
+
+    return (voidptr)(uptr)(value & ~DANG_VALUE_TAG_MASK);
+}
+
+/**
+ * Makes a new storage with room for `capacity` elements, it's tracked by the garbage collector
+ */
+ResStorage dang_storage_new(DEvaluator* de, usize capacity)
+{
+    DC_RES2(ResStorage);
+
+    DArrayStoragePtr storage = (DArrayStoragePtr)dc_alloc(sizeof(DArrayStorage));
+    if (storage == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    *storage = (DArrayStorage){0};
+
+    if (capacity > 0)
+    {
+        storage->values = (DValue*)dc_alloc(capacity * sizeof(DValue));
+        if (storage->values == NULL)
+        {
+            dc_dbg_log("Memory allocation failed");
+
+            dc_dealloc(storage, sizeof(DArrayStorage));
+
+            dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+        }
+
+        storage->cap = capacity;
+    }
+
+    dc_try_or_fail_with3(DCResVoid, res, dang_gc_track(de, dc_dva(DArrayStoragePtr, storage)), {
+        dc_dbg_log("failed to track the array storage");
+        dang_storage_free(storage);
+        dc_dealloc(storage, sizeof(DArrayStorage));
+    });
+
+    dc_ret_ok(storage);
+}
+
+DCResVoid dang_storage_free(DArrayStoragePtr storage)
+{
+    DC_RES_void();
+
+    if (storage->values) dc_dealloc(storage->values, storage->cap * sizeof(DValue));
+
+    storage->values = NULL;
+    storage->count = 0;
+    storage->cap = 0;
+
+    dc_ret();
+}
+
+/**
+ * Appends the compact value of the runtime value to the storage, it grows by doubling
+ *
+ * NOTE: The storage can be old while the value is young, the caller applies the write barrier
+ */
+DCResVoid dang_storage_push(DEvaluator* de, DArrayStoragePtr storage, DCDynValPtr value)
+{
+    DC_RES_void();
+
+    if (storage->count == storage->cap)
+    {
+        usize cap = storage->cap * 2 > DANG_STORAGE_MIN_CAPACITY ? storage->cap * 2 : DANG_STORAGE_MIN_CAPACITY;
+
+        DValue* values = (DValue*)dc_resize(storage->values, storage->cap * sizeof(DValue), cap * sizeof(DValue));
+        if (values == NULL)
+        {
+            dc_dbg_log("Memory allocation failed");
+
+            dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+        }
+
+        storage->values = values;
+        storage->cap = cap;
+    }
+
+    dc_try_or_fail_with3(ResDValue, packed, dang_value_pack(de, value), {});
+
+    storage->values[storage->count++] = dc_unwrap2(packed);
+
+    dc_ret();
+}
@@ -0,0 +1,97 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: value.h
+//    Date: 2024-10-17
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Compact runtime values header file
+// ***************************************************************************************
+
+#ifndef DANG_VALUE_H
+#define DANG_VALUE_H
+
+#include "evaluator.h"
+
+// ***************************************************************************************
+// * TYPES
+// ***************************************************************************************
+
+/**
+ * Runtime value that doesn't fit in a compact value (e.g. functions), it never changes once it's made
+ * `gc_flags` is its collector state (see gc.h)
+ */
+struct DBox
+{
+    DCDynVal value;
+    u8 gc_flags;
+};
+
+DCResType(DValue, ResDValue);
+DCResType(DArrayStoragePtr, ResStorage);
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+/**
+ * A compact value is a single word, the lowest bit set means a 63 bit integer,
+ * otherwise the lowest 3 bits tell what the rest of the word is:
+ *
+ * 000 a box holding any other value or one of the immediates below
+ * 010 an array object
+ * 100 a hash table object
+ * 110 a string, its buffer in the lower 48 bits and its length in the upper 16 bits
+ *
+ * NOTE: The immediates are below 64 so they can't be confused with the address of a box,
+ * undefined (zero) is only found in the environment slots that are not defined yet
+ */
+#define DANG_VALUE_UNDEFINED ((DValue)0)
+#define DANG_VALUE_NULL ((DValue)8)
+#define DANG_VALUE_FALSE ((DValue)16)
+#define DANG_VALUE_TRUE ((DValue)24)
+
+#define DANG_VALUE_TAG_MASK ((DValue)0x7)
+#define DANG_VALUE_TAG_BOX ((DValue)0x0)
+#define DANG_VALUE_TAG_ARRAY ((DValue)0x2)
+#define DANG_VALUE_TAG_HASH_TABLE ((DValue)0x4)
+#define DANG_VALUE_TAG_STRING ((DValue)0x6)
+
+#define DANG_VALUE_INT_MAX (INT64_MAX / 2)
+#define DANG_VALUE_INT_MIN (INT64_MIN / 2)
+
+#define DANG_VALUE_STRING_MAX_LEN 0xffff
+#define DANG_VALUE_ADDRESS_MASK ((DValue)0x0000fffffffffff8ULL)
+
+#define dang_value_is_int(V) (((V) & 1) != 0)
+#define dang_value_is_defined(V) ((V) != DANG_VALUE_UNDEFINED)
+
+/**
+ * Whether the value refers to a runtime object (including the boxes)
+ */
+#define dang_value_is_object(V) (!dang_value_is_int(V) && (V) >= 64)
+
+/**
+ * Value of the element at the index of the array object
+ */
+#define dang_array_get(ARR, IDX) dang_value_unpack((ARR)->storage->values[(ARR)->offset + (IDX)])
+
+// ***************************************************************************************
+// * FUNCTION DECLARATIONS
+// ***************************************************************************************
+
+ResDValue dang_value_pack(DEvaluator* de, DCDynValPtr value);
+DCDynVal dang_value_unpack(DValue value);
+voidptr dang_value_object(DValue value);
+
+ResStorage dang_storage_new(DEvaluator* de, usize capacity);
+DCResVoid dang_storage_free(DArrayStoragePtr storage);
+DCResVoid dang_storage_push(DEvaluator* de, DArrayStoragePtr storage, DCDynValPtr value);
+
+#endif // DANG_VALUE_H
@@ -0,0 +1,562 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: vm.c
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Stack based virtual machine source file
+// ***************************************************************************************
+
+#include "vm.h"
+#include "gc.h"
+#include "value.h"
+
+// ***************************************************************************************
+// * MACROS
+// ***************************************************************************************
+
+#define vm_read_byte() (*ip++)
+#define vm_read_u32() (ip += 4, ((usize)ip[-4] << 24) | ((usize)ip[-3] << 16) | ((usize)ip[-2] << 8) | (usize)ip[-1])
+#define vm_read_constant() (dc_da_get2(frame->proto->chunk.constants, vm_read_u32()))
+
+#define vm_peek(DISTANCE) (vm->sp[-1 - (DISTANCE)])
+#define vm_pop() (*--vm->sp)
+
+/**
+ * Sets the main result variable (__dc_res) as error and jumps to the exit label
+ */
+#define vm_fail_with(...)                                                                                                      \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        dc_ea(-1, __VA_ARGS__);                                                                                                \
+        goto vm_exit;                                                                                                          \
+    } while (0)
+
+/**
+ * Copies error data from RES to the main result variable (__dc_res) and jumps to the exit label
+ */
+#define vm_fail_if_err2(RES)                                                                                                   \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if (dc_is_err2(RES))                                                                                                   \
+        {                                                                                                                      \
+            dc_err_cpy(RES);                                                                                                   \
+            goto vm_exit;                                                                                                      \
+        }                                                                                                                      \
+    } while (0)
+
+/**
+ * Every live value is on the stack between instructions, so collections can only happen here
+ */
+#define vm_safepoint()                                                                                                         \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if (dang_gc_should_collect(de))                                                                                        \
+        {                                                                                                                      \
+            DCResVoid gc_res = dang_gc_collect(de);                                                                            \
+            vm_fail_if_err2(gc_res);                                                                                           \
+        }                                                                                                                      \
+    } while (0)
+
+#define vm_push(VALUE)                                                                                                         \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if (vm->sp == vm->stack + DANG_VM_STACK_MAX) vm_fail_with("%s", "stack overflow");                                     \
+        *vm->sp++ = (VALUE);                                                                                                   \
+    } while (0)
+
+#define vm_save_frame() frame->ip = ip
+
+#define vm_load_frame()                                                                                                        \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        frame = &vm->frames[vm->frame_count - 1];                                                                              \
+        ip = frame->ip;                                                                                                        \
+    } while (0)
+
+/**
+ * Integer operands take the fast path (the integer expression) when GUARD holds for them (`lval` and `rval`),
+ * everything else (including the errors) goes through the infix evaluation of the tree walker
+ */
+#define vm_guarded_binary_op(OPERATOR, GUARD, ...)                                                                             \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        DCDynVal right = vm_pop();                                                                                             \
+        DCDynVal left = vm_pop();                                                                                              \
+                                                                                                                               \
+        if (do_is_int(left) && do_is_int(right))                                                                               \
+        {                                                                                                                      \
+            i64 lval = do_as_int(left);                                                                                        \
+            i64 rval = do_as_int(right);                                                                                       \
+            if (GUARD)                                                                                                         \
+            {                                                                                                                  \
+                vm_push((__VA_ARGS__));                                                                                        \
+                break;                                                                                                         \
+            }                                                                                                                  \
+        }                                                                                                                      \
+                                                                                                                               \
+        DCRes res = dang_eval_infix(de, OPERATOR, &left, &right);                                                              \
+        vm_fail_if_err2(res);                                                                                                  \
+        vm_push(dc_unwrap2(res));                                                                                              \
+    } while (0)
+
+#define vm_binary_op(OPERATOR, ...) vm_guarded_binary_op(OPERATOR, true, __VA_ARGS__)
+
+#ifdef DANG_VM_COMPUTED_GOTO
+
+#define vm_case(OP) vm_label_##OP
+#define vm_dispatch() goto* dispatch_table[vm_read_byte()]
+#define vm_loop_begin() vm_dispatch();
+#define vm_loop_end()
+
+#else
+
+#define vm_case(OP) case OP
+#define vm_dispatch() continue
+#define vm_loop_begin()                                                                                                        \
+    for (;;)                                                                                                                   \
+    {                                                                                                                          \
+        switch (vm_read_byte())                                                                                                \
+        {
+#define vm_loop_end()                                                                                                          \
+    default:                                                                                                                   \
+        vm_fail_with("unknown opcode '%s'", tostr_DOpCode(ip[-1]));                                                            \
+        }                                                                                                                      \
+        }
+
+#endif
+
+// ***************************************************************************************
+// * PRIVATE FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Calls in tail position replace the frame of the caller instead of pushing a new one
+ */
+static DCRes call_value(DEvaluator* de, DVM* vm, usize argc, b1 tail)
+{
+    DC_RES();
+
+    DCDynValPtr callee = &vm_peek(argc);
+
+    if (callee->type == DO_BUILTIN_FUNCTION)
+    {
+        // builtin functions get a view over the arguments on the stack
+        DCDynArr args = {.elements = callee + 1, .cap = argc, .count = argc, .multiplier = 1, .element_free_fn = NULL};
+        DCDynVal call_obj = dc_dv(DCDynArrPtr, &args);
+
+        dc_try_fail(dang_call_builtin(de, dc_dv_as(*callee, DBuiltinFunction), &call_obj));
+
+        vm->sp = callee;
+        *vm->sp++ = dc_unwrap();
+
+        dc_ret();
+    }
+
+    if (callee->type != DO_COMPILED_FUNCTION) dc_ret_ea(-1, "not a function got: '%s'", dv_type_tostr(callee));
+
+    DoClosure closure = dc_dv_as(*callee, DoClosure);
+    DFnProtoPtr proto = closure.proto;
+
+    if (proto->parameters->count != argc)
+        dc_ret_ea(-1, "function needs " dc_fmt(usize) " arguments, got=" dc_fmt(usize), proto->parameters->count, argc);
+
+    DVMFrame* caller = &vm->frames[vm->frame_count - 1];
+
+    if (!tail && vm->frame_count == DANG_VM_FRAMES_MAX) dc_ret_e(-1, "call stack overflow");
+
+    dc_try_or_fail_with3(ResEnv, fn_env_res, dang_env_new_tail(de, tail ? caller->env : NULL, proto->scope, closure.env), {});
+
+    DEnv* fn_env = dc_unwrap2(fn_env_res);
+
+    // extending the environment by defining arguments
+    // with given evaluated objects assigning to them
+    dc_da_for(extend_env_loop, *proto->parameters, {
+        DNodeIdentifier param = dc_dv_as(*_it, DNodeIdentifier);
+
+        dc_try_fail(dang_env_define(de, fn_env, param.slot, param.value, callee + 1 + _idx));
+    });
+
+    if (tail)
+    {
+        vm->sp = caller->base;
+
+        *caller = (DVMFrame){.proto = proto, .ip = proto->chunk.code, .base = caller->base, .env = fn_env};
+
+        dc_ret_ok_dv_nullptr();
+    }
+
+    vm->sp = callee;
+
+    vm->frames[vm->frame_count++] = (DVMFrame){.proto = proto, .ip = proto->chunk.code, .base = callee, .env = fn_env};
+
+    dc_ret_ok_dv_nullptr();
+}
+
+// ***************************************************************************************
+// * PUBLIC FUNCTIONS
+// ***************************************************************************************
+
+/**
+ * Runs the compiled prototype in the given environment and returns the
+ * value it returns
+ *
+ * NOTE: Runtime objects are tracked by the garbage collector exactly like the tree walker does,
+ * the stack and the frames of the vm are roots while it's running
+ */
+DCRes dang_vm_run(DEvaluator* de, DFnProtoPtr proto, DEnv* env)
+{
+    DC_RES();
+
+    if (!de) dc_ret_e(dc_e_code(NV), "cannot run vm using NULL evaluator");
+    if (!proto) dc_ret_e(dc_e_code(NV), "cannot run NULL function prototype");
+
+    DVM* vm = (DVM*)dc_alloc(sizeof(DVM));
+    if (vm == NULL)
+    {
+        dc_dbg_log("Memory allocation failed");
+
+        dc_ret_e(dc_e_code(MEM), "Memory allocation failed");
+    }
+
+    vm->sp = vm->stack;
+    vm->frame_count = 1;
+    vm->frames[0] = (DVMFrame){.proto = proto, .ip = proto->chunk.code, .base = vm->stack, .env = env};
+
+    DVM* enclosing_vm = de->gc.vm;
+    de->gc.vm = vm;
+
+    DVMFrame* frame;
+    u8* ip;
+    vm_load_frame();
+
+#ifdef DANG_VM_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+    static void* dispatch_table[OP__MAX] = {
+        [OP_CONSTANT] = &&vm_case(OP_CONSTANT),
+        [OP_NULL] = &&vm_case(OP_NULL),
+        [OP_TRUE] = &&vm_case(OP_TRUE),
+        [OP_FALSE] = &&vm_case(OP_FALSE),
+        [OP_POP] = &&vm_case(OP_POP),
+        [OP_GET] = &&vm_case(OP_GET),
+        [OP_DEFINE] = &&vm_case(OP_DEFINE),
+        [OP_ADD] = &&vm_case(OP_ADD),
+        [OP_SUB] = &&vm_case(OP_SUB),
+        [OP_MUL] = &&vm_case(OP_MUL),
+        [OP_DIV] = &&vm_case(OP_DIV),
+        [OP_EQ] = &&vm_case(OP_EQ),
+        [OP_NEQ] = &&vm_case(OP_NEQ),
+        [OP_LT] = &&vm_case(OP_LT),
+        [OP_GT] = &&vm_case(OP_GT),
+        [OP_NEG] = &&vm_case(OP_NEG),
+        [OP_NOT] = &&vm_case(OP_NOT),
+        [OP_JUMP] = &&vm_case(OP_JUMP),
+        [OP_JUMP_IF_FALSE] = &&vm_case(OP_JUMP_IF_FALSE),
+        [OP_ARRAY] = &&vm_case(OP_ARRAY),
+        [OP_HASH] = &&vm_case(OP_HASH),
+        [OP_INDEX] = &&vm_case(OP_INDEX),
+        [OP_CLOSURE] = &&vm_case(OP_CLOSURE),
+        [OP_CALL] = &&vm_case(OP_CALL),
+        [OP_TAIL_CALL] = &&vm_case(OP_TAIL_CALL),
+        [OP_RETURN] = &&vm_case(OP_RETURN),
+    };
+#endif
+
+    vm_loop_begin();
+
+    vm_case(OP_CONSTANT) :
+    {
+        vm_push(vm_read_constant());
+        vm_dispatch();
+    }
+
+    vm_case(OP_NULL) :
+    {
+        vm_push(dc_dv_nullptr());
+        vm_dispatch();
+    }
+
+    vm_case(OP_TRUE) :
+    {
+        vm_push(dc_dv_bool(true));
+        vm_dispatch();
+    }
+
+    vm_case(OP_FALSE) :
+    {
+        vm_push(dc_dv_bool(false));
+        vm_dispatch();
+    }
+
+    vm_case(OP_POP) :
+    {
+        --vm->sp;
+
+        vm_safepoint();
+        vm_dispatch();
+    }
+
+    vm_case(OP_GET) :
+    {
+        DCRes res = dang_env_get_resolved(frame->env, &dc_dv_as(vm_read_constant(), DNodeIdentifier));
+        vm_fail_if_err2(res);
+
+        vm_push(dc_unwrap2(res));
+        vm_dispatch();
+    }
+
+    vm_case(OP_DEFINE) :
+    {
+        DNodeIdentifier* target = &dc_dv_as(vm_read_constant(), DNodeIdentifier);
+
+        DCRes res = dang_env_define(de, frame->env, target->slot, target->value, &vm_peek(0));
+        vm_fail_if_err2(res);
+
+        vm_peek(0) = dc_dv_nullptr();
+        vm_dispatch();
+    }
+
+    vm_case(OP_ADD) :
+    {
+        vm_binary_op(DOP_ADD, do_int(lval + rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_SUB) :
+    {
+        vm_binary_op(DOP_SUB, do_int(lval - rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_MUL) :
+    {
+        vm_binary_op(DOP_MUL, do_int(lval * rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_DIV) :
+    {
+        // dividing by zero and overflowing are reported by the slow path
+        vm_guarded_binary_op(DOP_DIV, rval != 0 && rval != -1, do_int(lval / rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_EQ) :
+    {
+        vm_binary_op(DOP_EQ, dc_dv_bool(lval == rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_NEQ) :
+    {
+        vm_binary_op(DOP_NEQ, dc_dv_bool(lval != rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_LT) :
+    {
+        vm_binary_op(DOP_LT, dc_dv_bool(lval < rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_GT) :
+    {
+        vm_binary_op(DOP_GT, dc_dv_bool(lval > rval));
+        vm_dispatch();
+    }
+
+    vm_case(OP_NEG) :
+    {
+        DCRes res = dang_eval_prefix(DOP_NEG, &vm_peek(0));
+        vm_fail_if_err2(res);
+
+        vm_peek(0) = dc_unwrap2(res);
+        vm_dispatch();
+    }
+
+    vm_case(OP_NOT) :
+    {
+        DCRes res = dang_eval_prefix(DOP_NOT, &vm_peek(0));
+        vm_fail_if_err2(res);
+
+        vm_peek(0) = dc_unwrap2(res);
+        vm_dispatch();
+    }
+
+    vm_case(OP_JUMP) :
+    {
+        usize offset = vm_read_u32();
+
+        ip += offset;
+        vm_dispatch();
+    }
+
+    vm_case(OP_JUMP_IF_FALSE) :
+    {
+        usize offset = vm_read_u32();
+
+        DCDynVal condition = vm_pop();
+
+        DCResBool res = do_to_bool(&condition);
+        vm_fail_if_err2(res);
+
+        if (!dc_unwrap2(res)) ip += offset;
+        vm_dispatch();
+    }
+
+    vm_case(OP_ARRAY) :
+    {
+        usize count = vm_read_u32();
+
+        ResStorage storage_res = dang_storage_new(de, count);
+        vm_fail_if_err2(storage_res);
+
+        DArrayStoragePtr storage = dc_unwrap2(storage_res);
+
+        for (DCDynValPtr it = vm->sp - count; it < vm->sp; ++it)
+        {
+            DCResVoid res = dang_storage_push(de, storage, it);
+            vm_fail_if_err2(res);
+        }
+
+        DCRes array_res = dang_array_new(de, storage, 0, storage->count);
+        vm_fail_if_err2(array_res);
+
+        vm->sp -= count;
+        vm_push(dc_unwrap2(array_res));
+        vm_dispatch();
+    }
+
+    vm_case(OP_HASH) :
+    {
+        usize count = vm_read_u32();
+
+        DCResHt ht_res = dang_hash_table_new(de, count / 2);
+        vm_fail_if_err2(ht_res);
+
+        DCHashTablePtr ht = dc_unwrap2(ht_res);
+
+        for (DCDynValPtr it = vm->sp - count; it < vm->sp; it += 2)
+        {
+            DCPairPtr entry = NULL;
+
+            DCResBool res = dc_ht_entry(ht, *it, &entry);
+            if (dc_is_err2(res))
+            {
+                dc_ht_free(ht);
+                dc_dealloc(ht, sizeof(DCHashTable));
+
+                vm_fail_if_err2(res);
+            }
+
+            entry->second = *(it + 1);
+        }
+
+        DCResVoid res = dang_gc_track(de, dc_dva(DCHashTablePtr, ht));
+        if (dc_is_err2(res))
+        {
+            dc_dbg_log("failed to track the result hash table");
+            dc_ht_free(ht);
+            dc_dealloc(ht, sizeof(DCHashTable));
+
+            vm_fail_if_err2(res);
+        }
+
+        vm->sp -= count;
+        vm_push(dc_dv(DCHashTablePtr, ht));
+        vm_dispatch();
+    }
+
+    vm_case(OP_INDEX) :
+    {
+        DCDynVal index = vm_pop();
+
+        DCRes res = dang_eval_index(&vm_peek(0), &index);
+        vm_fail_if_err2(res);
+
+        vm_peek(0) = dc_unwrap2(res);
+        vm_dispatch();
+    }
+
+    vm_case(OP_CLOSURE) :
+    {
+        DFnProtoPtr proto = dc_dv_as(vm_read_constant(), DFnProtoPtr);
+        frame->env->captured = true;
+
+        vm_push(dc_dv(DoClosure, do_closure(proto, frame->env)));
+        vm_dispatch();
+    }
+
+    vm_case(OP_CALL) :
+    {
+        usize argc = vm_read_u32();
+
+        vm_save_frame();
+
+        DCRes res = call_value(de, vm, argc, false);
+        vm_fail_if_err2(res);
+
+        vm_load_frame();
+
+        vm_safepoint();
+        vm_dispatch();
+    }
+
+    vm_case(OP_TAIL_CALL) :
+    {
+        usize argc = vm_read_u32();
+
+        vm_save_frame();
+
+        DCRes res = call_value(de, vm, argc, true);
+        vm_fail_if_err2(res);
+
+        vm_load_frame();
+
+        vm_safepoint();
+        vm_dispatch();
+    }
+
+    vm_case(OP_RETURN) :
+    {
+        DCDynVal result = vm_pop();
+
+        vm->sp = frame->base;
+        --vm->frame_count;
+
+        if (vm->frame_count == 0)
+        {
+            dc_ok(result);
+            goto vm_exit;
+        }
+
+        DCResVoid pop_res = dang_env_pop(de, frame->env);
+        vm_fail_if_err2(pop_res);
+
+        vm_push(result);
+
+        vm_load_frame();
+        vm_dispatch();
+    }
+
+    vm_loop_end();
+
+#ifdef DANG_VM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+vm_exit:
+    de->gc.vm = enclosing_vm;
+
+    dc_dealloc(vm, sizeof(DVM));
+
+    dc_ret();
+}
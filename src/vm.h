@@ -0,0 +1,69 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: vm.h
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Stack based virtual machine header file
+// ***************************************************************************************
+
+#ifndef DANG_VM_H
+#define DANG_VM_H
+
+#include "compiler.h"
+
+// ***************************************************************************************
+// * CONFIGS
+// ***************************************************************************************
+
+#ifndef DANG_VM_STACK_MAX
+#define DANG_VM_STACK_MAX 8192
+#endif
+
+#ifndef DANG_VM_FRAMES_MAX
+#define DANG_VM_FRAMES_MAX 1024
+#endif
+
+/**
+ * Computed goto (labels as values) is used for dispatching when the compiler supports it
+ * Define `DANG_VM_NO_COMPUTED_GOTO` to fall back to the portable switch based loop
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(DANG_VM_NO_COMPUTED_GOTO)
+#define DANG_VM_COMPUTED_GOTO
+#endif
+
+// ***************************************************************************************
+// * TYPES
+// ***************************************************************************************
+
+typedef struct
+{
+    DFnProtoPtr proto;
+    u8* ip;
+    DCDynValPtr base;
+    DEnv* env;
+} DVMFrame;
+
+struct DVM
+{
+    DCDynVal stack[DANG_VM_STACK_MAX];
+    DCDynValPtr sp;
+
+    DVMFrame frames[DANG_VM_FRAMES_MAX];
+    usize frame_count;
+};
+
+// ***************************************************************************************
+// * FUNCTION DECLARATIONS
+// ***************************************************************************************
+
+DCRes dang_vm_run(DEvaluator* de, DFnProtoPtr proto, DEnv* env);
+
+#endif // DANG_VM_H
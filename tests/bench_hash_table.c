@@ -0,0 +1,196 @@
+// ***************************************************************************************
+//    Project: Dang Compiler -> https://github.com/dezashibi-c/dang
+//    File: bench_hash_table.c
+//    Date: 2024-10-16
+//    Author: Navid Dezashibi
+//    Contact: navid@dezashibi.com
+//    Website: https://dezashibi.com | https://github.com/dezashibi
+//    License:
+//     Please refer to the LICENSE file, repository or website for more
+//     information about the licensing of this work. If you have any questions
+//     or concerns, please feel free to contact me at the email address provided
+//     above.
+// ***************************************************************************************
+// *  Description: Hash table microbenchmark (not part of the tests)
+// *               Compares the open addressing DCHashTable with separate chaining
+// *               Build it with `cmake --build <dir> --target benchmarks`
+// ***************************************************************************************
+
+#include <time.h>
+
+#include "common.h"
+
+// ***************************************************************************************
+// * CONFIGS
+// ***************************************************************************************
+
+#ifndef BENCH_KEY_COUNT
+#define BENCH_KEY_COUNT 20000
+#endif
+
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS 20
+#endif
+
+/**
+ * The benchmark has no way to recover, failures are logged and end the process
+ */
+#define bench_must(RES_TYPE, CALL)                                                                                             \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        RES_TYPE __bench_res = CALL;                                                                                           \
+        if (dc_is_err2(__bench_res))                                                                                           \
+        {                                                                                                                      \
+            dc_err_log2(__bench_res, "benchmark failed");                                                                      \
+            exit(1);                                                                                                           \
+        }                                                                                                                      \
+    } while (0)
+
+/**
+ * Number of rows of the chained table, the same as the capacity dang used to create the tables with
+ */
+#define BENCH_CHAINED_ROWS 17
+
+// ***************************************************************************************
+// * SEPARATE CHAINING (BASELINE)
+// ***************************************************************************************
+
+/**
+ * Fixed number of rows, each row is a dynamic array of individually allocated pairs
+ */
+typedef struct
+{
+    DCDynArr rows[BENCH_CHAINED_ROWS];
+} ChainedTable;
+
+static u32 bench_hash(i64 key)
+{
+    u64 x = (u64)key;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+
+    return (u32)x;
+}
+
+static void chained_init(ChainedTable* ct)
+{
+    for (usize i = 0; i < BENCH_CHAINED_ROWS; ++i)
+        bench_must(DCResVoid, dc_da_init(&ct->rows[i], NULL));
+}
+
+static DCPair* chained_find(ChainedTable* ct, i64 key)
+{
+    DCDynArr* row = &ct->rows[bench_hash(key) % BENCH_CHAINED_ROWS];
+
+    for (usize i = 0; i < row->count; ++i)
+    {
+        DCPair* pair = dc_dv_as(row->elements[i], DCPairPtr);
+        if (dc_dv_as(pair->first, i64) == key) return pair;
+    }
+
+    return NULL;
+}
+
+static void chained_set(ChainedTable* ct, i64 key, i64 value)
+{
+    DCPair* existed = chained_find(ct, key);
+    if (existed)
+    {
+        existed->second = dc_dv(i64, value);
+        return;
+    }
+
+    DCPair* pair = (DCPair*)dc_alloc(sizeof(DCPair));
+    pair->first = dc_dv(i64, key);
+    pair->second = dc_dv(i64, value);
+
+    bench_must(DCResVoid, dc_da_push(&ct->rows[bench_hash(key) % BENCH_CHAINED_ROWS], dc_dv(DCPairPtr, pair)));
+}
+
+static void chained_free(ChainedTable* ct)
+{
+    for (usize i = 0; i < BENCH_CHAINED_ROWS; ++i)
+    {
+        for (usize j = 0; j < ct->rows[i].count; ++j)
+            dc_dealloc(dc_dv_as(ct->rows[i].elements[j], DCPairPtr), sizeof(DCPair));
+
+        bench_must(DCResVoid, dc_da_free(&ct->rows[i]));
+    }
+}
+
+// ***************************************************************************************
+// * OPEN ADDRESSING
+// ***************************************************************************************
+
+static DC_HT_HASH_FN_DECL(open_hash_fn)
+{
+    DC_RES_u32();
+
+    dc_ret_ok(bench_hash(dc_dv_as(*_key, i64)));
+}
+
+static DC_HT_KEY_CMP_FN_DECL(open_key_cmp_fn)
+{
+    DC_RES_bool();
+
+    dc_ret_ok(dc_dv_as(*_key1, i64) == dc_dv_as(*_key2, i64));
+}
+
+// ***************************************************************************************
+// * RUNNER
+// ***************************************************************************************
+
+static double elapsed_ms(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    i64 found = 0;
+
+    clock_t start = clock();
+    for (usize round = 0; round < BENCH_ROUNDS; ++round)
+    {
+        ChainedTable ct;
+        chained_init(&ct);
+
+        for (i64 i = 0; i < BENCH_KEY_COUNT; ++i)
+            chained_set(&ct, i, i);
+
+        for (i64 i = 0; i < 2 * BENCH_KEY_COUNT; ++i)
+            found += chained_find(&ct, i) != NULL;
+
+        chained_free(&ct);
+    }
+    double chained_time = elapsed_ms(start);
+
+    start = clock();
+    for (usize round = 0; round < BENCH_ROUNDS; ++round)
+    {
+        DCHashTable ht;
+        bench_must(DCResVoid, dc_ht_init(&ht, BENCH_CHAINED_ROWS, open_hash_fn, open_key_cmp_fn, NULL));
+
+        for (i64 i = 0; i < BENCH_KEY_COUNT; ++i)
+            bench_must(DCResVoid, dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, i), DC_HT_SET_CREATE_OR_UPDATE));
+
+        for (i64 i = 0; i < 2 * BENCH_KEY_COUNT; ++i)
+        {
+            DCDynValPtr value = NULL;
+            bench_must(DCResUsize, dc_ht_find_by_key(&ht, dc_dv(i64, i), &value));
+
+            found += value != NULL;
+        }
+
+        bench_must(DCResVoid, dc_ht_free(&ht));
+    }
+    double open_time = elapsed_ms(start);
+
+    printf("%d keys, %d hits and %d misses per round, %d rounds (%lld found)\n", BENCH_KEY_COUNT, BENCH_KEY_COUNT,
+           BENCH_KEY_COUNT, BENCH_ROUNDS, (long long)found);
+    printf("separate chaining: %10.2f ms\n", chained_time);
+    printf("open addressing:   %10.2f ms\n", open_time);
+
+    return 0;
+}
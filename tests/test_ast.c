@@ -13,7 +13,6 @@ CLOVE_TEST(node_string)
 
     DCDynVal my_var = dc_dv(string, "my_var");
     DCDynVal another_var = dc_dv(string, "another_var");
-    DCDynVal minus = dc_dv(string, "-");
     DCDynVal one = dc_dv(i64, 1);
 
 
@@ -21,7 +20,7 @@ CLOVE_TEST(node_string)
 
     DCDynVal statement1 = dc_dv(DNodeLetStatement, (dn_let(dc_dv_as(my_var, string), &ident2)));
 
-    DCDynVal expression = dc_dv(DNodePrefixExpression, (dn_prefix(dc_dv_as(minus, string), &one)));
+    DCDynVal expression = dc_dv(DNodePrefixExpression, (dn_prefix(DOP_NEG, &one)));
 
     dc_da_push(stmts, dc_dv(DCDynValPtr, &statement1));
     dc_da_push(stmts, dc_dv(DCDynValPtr, &expression));
@@ -2,9 +2,12 @@
 
 #include "clove-unit/clove-unit.h"
 
+#include "allocator.h"
 #include "evaluator.h"
+#include "gc.h"
 #include "parser.h"
 #include "scanner.h"
+#include "value.h"
 
 typedef struct
 {
@@ -23,7 +26,7 @@ static b1 test_evaluated_literal(DCDynValPtr obj, DCDynValPtr expected)
         return false;
     }
 
-    DCResBool res = dc_dv_eq(obj, expected);
+    DCResBool res = do_eq(obj, expected);
     if (dc_is_err2(res))
     {
         dc_err_log2(res, "cannot compare dynamic values");
@@ -35,22 +38,25 @@ static b1 test_evaluated_literal(DCDynValPtr obj, DCDynValPtr expected)
     {
         DCResString obj_str, expected_str;
 
-        obj_str = dc_tostr_dv(obj);
-        expected_str = dc_tostr_dv(expected);
+        obj_str = do_tostr(obj);
+        expected_str = do_tostr(expected);
 
         dc_log("expected '%s' but got '%s'", dc_unwrap2(expected_str), dc_unwrap2(obj_str));
 
-        if (dc_unwrap2(obj_str)) free(dc_unwrap2(obj_str));
-        if (dc_unwrap2(expected_str)) free(dc_unwrap2(expected_str));
+        dc_sfree(dc_unwrap2(obj_str));
+        dc_sfree(dc_unwrap2(expected_str));
     }
 
     return dc_unwrap2(res);
 }
 
-static b1 test_evaluated_array_literal(DCDynArrPtr obj, DCDynArrPtr expected)
+static b1 test_evaluated_array_literal(DArrayPtr obj, DCDynArrPtr expected)
 {
+    if (obj->count != expected->count) return false;
+
     dc_da_for(array_tesT_loop, *expected, {
-        if (!test_evaluated_literal(&dc_da_get2(*obj, _idx), _it)) return false;
+        DCDynVal element = dang_array_get(obj, _idx);
+        if (!test_evaluated_literal(&element, _it)) return false;
     });
 
     return true;
@@ -83,7 +89,8 @@ static b1 perform_evaluation_tests(TestCase tests[])
         DCDynVal result = dc_unwrap2(res).result;
 
         if (_it->expected.type == dc_dvt(DCDynArrPtr))
-            dc_action_on(!test_evaluated_array_literal(dc_dv_as(result, DCDynArrPtr), dc_dv_as(_it->expected, DCDynArrPtr)),
+            dc_action_on(result.type != DO_ARRAY ||
+                             !test_evaluated_array_literal(do_as_array(result), dc_dv_as(_it->expected, DCDynArrPtr)),
                          dang_evaluator_free(&de);
                          return false, "array test '" dc_fmt(usize) "' failed: wrong evaluation result", _idx);
 
@@ -98,6 +105,47 @@ static b1 perform_evaluation_tests(TestCase tests[])
     return true;
 }
 
+/**
+ * Evaluates the input and checks the result against the expected literal
+ *
+ * NOTE: Errors of the evaluation are logged and released here
+ */
+static b1 evaluate_and_test(DEvaluator* de, string input, DCDynVal expected)
+{
+    ResEvaluated res = dang_eval(de, input, false);
+    if (dc_is_err2(res))
+    {
+        dc_log("failed on input '%s'", input);
+        dc_err_log2(res, "evaluation failed");
+        dc_result_free(&res);
+
+        return false;
+    }
+
+    if (!test_evaluated_literal(&dc_unwrap2(res).result, &expected))
+    {
+        dc_log("failed on input '%s'", input);
+
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Frees the evaluator and fails the running test when the input doesn't evaluate to the expected literal
+ */
+#define eval_test_or_fail(DE, INPUT, EXPECTED)                                                                                 \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if (!evaluate_and_test(DE, INPUT, EXPECTED))                                                                           \
+        {                                                                                                                      \
+            dang_evaluator_free(DE);                                                                                           \
+            CLOVE_FAIL();                                                                                                      \
+            return;                                                                                                            \
+        }                                                                                                                      \
+    } while (0)
+
 CLOVE_TEST(integer_expressions)
 {
     TestCase tests[] = {
@@ -301,6 +349,36 @@ CLOVE_TEST(array_index_expressions)
     }
 }
 
+CLOVE_TEST(array_slices)
+{
+    TestCase tests[] = {
+        {.input = "let a [1 2 3 4 5]; let s ${slice a, 1, 4}; s[0] + s[2]", .expected = do_int(6)},
+
+        {.input = "let a [1 2 3 4 5]; let s ${slice a, 1, 4}; s[3]", .expected = dc_dv_nullptr()},
+
+        {.input = "let a [1 2 3 4 5]; let s ${slice a, 1, 4}; ${first s} * ${last s}", .expected = do_int(8)},
+
+        {.input = "let a [1 2 3 4 5]; len ${slice a, -3, 99}", .expected = do_int(5)},
+
+        {.input = "let a [1 2 3 4 5]; len ${slice a, 4, 2}", .expected = do_int(0)},
+
+        {.input = "let a [1 2 3 4 5]; '' + ${slice ${rest a}, 1, 3}", .expected = do_string("[3, 4]")},
+
+        {.input = "let a [1 2 3 4]; let s ${slice a, 1, 3}; push s 9; '' + a + s",
+         .expected = do_string("[1, 2, 3, 4][2, 3, 9]")},
+
+        {.input = "", .expected = dc_dv_nullptr()},
+    };
+
+    if (perform_evaluation_tests(tests))
+        CLOVE_PASS();
+    else
+    {
+        dc_log("test has failed");
+        CLOVE_FAIL();
+    }
+}
+
 CLOVE_TEST(hash_index_expression)
 {
 #define FIXED_INPUT                                                                                                            \
@@ -483,6 +561,50 @@ CLOVE_TEST(functions)
     }
 }
 
+CLOVE_TEST(hash_builtins)
+{
+#define FIXED_INPUT "let h {'a': 1, 2: 'b', true: 3};"
+
+    TestCase tests[] = {
+        {.input = FIXED_INPUT "'' + ${keys h} + ${values h}", .expected = do_string("[a, 2, true][1, b, 3]")},
+
+        {.input = FIXED_INPUT "'' + ${entries h}", .expected = do_string("[[a, 1], [2, b], [true, 3]]")},
+
+        {.input = FIXED_INPUT "has h 2", .expected = dc_dv_true()},
+
+        {.input = FIXED_INPUT "has h 'z'", .expected = dc_dv_false()},
+
+        {.input = FIXED_INPUT "delete h 'a'; '' + ${keys h}", .expected = do_string("[2, true]")},
+
+        {.input = FIXED_INPUT "delete h 'a'; delete h 'a'", .expected = dc_dv_false()},
+
+        {.input = FIXED_INPUT "'' + ${merge h, {true: 30, 'c': 4}}",
+         .expected = do_string("{(a, 1), (2, b), (true, 30), (c, 4)}")},
+
+        {.input = FIXED_INPUT "let m ${merge h, {}}; delete m 2; len ${keys h}", .expected = do_int(3)},
+
+        {.input = FIXED_INPUT "let e ${entries h}; push e[0] 9; '' + e",
+         .expected = do_string("[[a, 1, 9], [2, b], [true, 3]]")},
+
+        {.input = "'' + ${keys {}} + ${entries {}}", .expected = do_string("[][]")},
+
+        {.input = FIXED_INPUT "let k ${keys h}; let e ${entries h}; delete h 'a'; '' + k + e[0] + ${keys h}",
+         .expected = do_string("[a, 2, true][a, 1][2, true]")},
+
+        {.input = "", .expected = dc_dv_nullptr()},
+    };
+
+#undef FIXED_INPUT
+
+    if (perform_evaluation_tests(tests))
+        CLOVE_PASS();
+    else
+    {
+        dc_log("test has failed");
+        CLOVE_FAIL();
+    }
+}
+
 CLOVE_TEST(builtin_functions)
 {
     TestCase tests[] = {
@@ -506,6 +628,96 @@ CLOVE_TEST(builtin_functions)
     }
 }
 
+static DECL_DBUILTIN_FUNCTION(twice)
+{
+    (void)de;
+
+    BUILTIN_FN_GET_ARGS_VALIDATE("twice", 1);
+
+    BUILTIN_FN_GET_ARG_NO(0, DO_INTEGER, "first argument must be an integer");
+
+    return do_int(do_as_int(arg0) * 2);
+}
+
+CLOVE_TEST(registered_builtin_functions)
+{
+    TestCase tests[] = {
+        {.input = "twice 21", .expected = do_int(42)},
+
+        {.input = "let f fn(x) { twice x }; f 4", .expected = do_int(8)},
+
+        {.input = "let twice 3; twice", .expected = do_int(3)},
+
+        {.input = "let len fn(x) { 7 }; len 'four'", .expected = do_int(7)},
+
+        {.input = "", .expected = dc_dv_nullptr()},
+    };
+
+    dc_foreach(registered_builtins_loop, tests, TestCase, {
+        DEvaluator de;
+        DCResVoid init_res = dang_evaluator_init(&de);
+        if (dc_is_ok2(init_res)) init_res = dang_register_builtin(&de, "twice", twice);
+
+        if (dc_is_err2(init_res))
+        {
+            dc_err_log2(init_res, "Evaluator initialization error on input");
+            CLOVE_FAIL();
+            return;
+        }
+
+        eval_test_or_fail(&de, _it->input, _it->expected);
+
+        dang_evaluator_free(&de);
+    });
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(host_names)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    // names of the host are plain C strings that are neither interned nor kept alive
+    char name[] = "answer";
+
+    DCRes set_res = dang_env_set(&de, &de.main_env, name, &do_int(42), false);
+    DCResVoid reg_res = dang_register_builtin(&de, "twice", twice);
+
+    strcpy(name, "twice");
+
+    if (dc_is_err2(set_res) || dc_is_err2(reg_res) || dang_find_builtin(&de, name) != twice)
+    {
+        dc_log("failed to register the names of the host");
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    strcpy(name, "answer");
+
+    DCRes get_res = dang_env_get(&de.main_env, name);
+    if (dc_is_err2(get_res) || !test_evaluated_literal(&dc_unwrap2(get_res), &do_int(42)))
+    {
+        dc_log("failed to look up '%s'", name);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    eval_test_or_fail(&de, "twice answer", do_int(84));
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
 CLOVE_TEST(closures)
 {
     TestCase tests[] = {
@@ -529,6 +741,938 @@ CLOVE_TEST(closures)
     }
 }
 
+CLOVE_TEST(tail_calls)
+{
+    TestCase tests[] = {
+        // deeper than both the C stack of the tree walker and the frames of the vm allow
+        {.input = "let count fn(n, acc) { if n == 0 { return acc }\n count n - 1 acc + 1 }\n count 100000 0",
+         .expected = do_int(100000)},
+
+        {.input = "let is_even fn(n) { if n == 0 { true } else { is_odd n - 1 } }\n"
+                  "let is_odd fn(n) { if n == 0 { false } else { is_even n - 1 } }\n"
+                  "is_even 10001",
+         .expected = dc_dv_bool(false)},
+
+        // environments captured by closures must not be reused
+        {.input = "let c fn(n, f) { if n == 0 { return f }\n c n - 1 fn(x) { n + x } }\n let g ${c 2 0}\n g 10",
+         .expected = do_int(11)},
+
+        {.input = "", .expected = dc_dv_nullptr()},
+    };
+
+    if (perform_evaluation_tests(tests))
+        CLOVE_PASS();
+    else
+    {
+        dc_log("test has failed");
+        CLOVE_FAIL();
+    }
+}
+
+CLOVE_TEST(compact_values)
+{
+    // hash table pairs are dynamic values, array elements and environment slots are single words
+    if (sizeof(DCDynVal) > 32 || sizeof(DValue) != 8)
+    {
+        dc_log("got dynamic value=" dc_fmt(usize) ", compact value=" dc_fmt(usize), sizeof(DCDynVal), sizeof(DValue));
+        CLOVE_FAIL();
+        return;
+    }
+
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    // the last ones don't fit in a word and get a box
+    DCDynVal values[] = {
+        do_int(0),
+        do_int(-42),
+        do_int(DANG_VALUE_INT_MAX),
+        do_int(DANG_VALUE_INT_MIN),
+        dc_dv_bool(true),
+        dc_dv_bool(false),
+        dc_dv_nullptr(),
+        do_string("not owned by a buffer"),
+        do_int(INT64_MAX),
+        do_int(INT64_MIN),
+    };
+
+    usize boxed = 0;
+
+    // null is the stopper of `dc_foreach` so it's a plain loop
+    for (usize i = 0; i < (usize)dc_count(values); ++i)
+    {
+        ResDValue packed = dang_value_pack(&de, &values[i]);
+
+        DCDynVal unpacked = dc_is_ok2(packed) ? dang_value_unpack(dc_unwrap2(packed)) : dc_dv_nullptr();
+
+        if (dc_is_err2(packed) || !test_evaluated_literal(&unpacked, &values[i]))
+        {
+            dc_log("test #" dc_fmt(usize) " failed", i);
+            dang_evaluator_free(&de);
+            CLOVE_FAIL();
+            return;
+        }
+
+        if (dang_value_is_object(dc_unwrap2(packed))) boxed++;
+    }
+
+    if (boxed != 3)
+    {
+        dc_log("expected 3 boxes, got=" dc_fmt(usize), boxed);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // an array of integers only costs a word per element
+    string input = "let a []\n let fill fn(n) { if n > 0 { push a n\n fill n - 1 } }\n fill 1000\n len a";
+
+    eval_test_or_fail(&de, input, do_int(1000));
+
+    usize storage_bytes = 0;
+    dc_da_for(storage_bytes_loop, de.gc.nursery, {
+        if (_it->type == dc_dvt(DArrayStoragePtr)) storage_bytes += dc_dv_as(*_it, DArrayStoragePtr)->cap * sizeof(DValue);
+    });
+    dc_da_for(storage_bytes_old_loop, de.gc.objects, {
+        if (_it->type == dc_dvt(DArrayStoragePtr)) storage_bytes += dc_dv_as(*_it, DArrayStoragePtr)->cap * sizeof(DValue);
+    });
+
+    dang_evaluator_free(&de);
+
+    if (storage_bytes > 1024 * 8 * 2)
+    {
+        dc_log("expected about 8 bytes per element, got=" dc_fmt(usize) " bytes", storage_bytes);
+        CLOVE_FAIL();
+        return;
+    }
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(constant_folding)
+{
+    TestCase tests[] = {
+        {.input = "1 + 2 * 3 - -4", .expected = do_int(11)},
+
+        {.input = "!(1 < 2) == false", .expected = dc_dv_bool(true)},
+
+        {.input = "'prefix' + '-' + 3", .expected = do_string("prefix-3")},
+
+        {.input = "if 1 < 2 { 10 } else { 20 }", .expected = do_int(10)},
+
+        {.input = "if 'a' == 'b' { 10 }", .expected = dc_dv_nullptr()},
+
+        // folding must leave the failing operations to the runtime
+        {.input = "if false { 1 / 0 } else { 5 / 2 }", .expected = do_int(2)},
+
+        {.input = "let f fn(x) { if true { x * (2 + 3) } else { x } }\n f 4", .expected = do_int(20)},
+
+        {.input = "", .expected = dc_dv_nullptr()},
+    };
+
+    if (!perform_evaluation_tests(tests))
+    {
+        dc_log("test has failed");
+        CLOVE_FAIL();
+        return;
+    }
+
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    string input = "let a 2 * 3 + 1\n if a > 0 { 'x' + 'y' } else { 'z' }";
+
+    ResEvaluated res = dang_eval(&de, input, true);
+    if (dc_is_err2(res) || !test_evaluated_literal(&dc_unwrap2(res).result, &do_string("xy")))
+    {
+        dc_log("failed on input '%s'", input);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // the folded expressions are part of the program
+    string expected_inspect = "let a 7\nif (a > 0) { \"xy\"; } else { \"z\"; }\n";
+    if (!dc_unwrap2(res).inspect || strcmp(dc_unwrap2(res).inspect, expected_inspect) != 0)
+    {
+        dc_log("expected folded program '%s', got '%s'", expected_inspect, dc_unwrap2(res).inspect);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(garbage_collection)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    // collecting at every safe point
+    dang_gc_set_threshold(&de, 0);
+
+    string input = "let build fn(n, s) { if n == 0 { return s }\n build n - 1 s + 'x' }\n len ${build 30 ''}";
+
+    eval_test_or_fail(&de, input, do_int(30));
+
+    // each call allocates a string and an environment, none of them is reachable by the next evaluation
+    dang_gc_set_threshold(&de, 0);
+
+    ResEvaluated res = dang_eval(&de, "build 0 ''", false);
+    usize object_count = de.gc.nursery.count + de.gc.objects.count;
+    if (dc_is_err2(res) || de.gc.major_collections == 0 || object_count >= 5)
+    {
+        dc_log("expected garbage to be collected, collections=" dc_fmt(usize) ", objects=" dc_fmt(usize),
+               de.gc.major_collections, object_count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(garbage_collection_nursery)
+{
+    DEvaluator de;
+
+    // minor collections at every safe point and no major collection
+    DCResVoid init_res = dang_evaluator_init2(&de, (DCAllocator){.fn = dc_default_alloc, .ctx = NULL}, 0);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_gc_set_threshold(&de, 1024 * 1024);
+
+    // 'a' gets promoted before a young string is pushed to it
+    string input = "let a [1]\n let b 'x'\n push a b + 'y'\n let c 'z' + b\n a[1] + c";
+
+    eval_test_or_fail(&de, input, do_string("xyzx"));
+
+    if (de.gc.minor_collections == 0 || de.gc.major_collections != 0)
+    {
+        dc_log("expected only minor collections, minor=" dc_fmt(usize) ", major=" dc_fmt(usize), de.gc.minor_collections,
+               de.gc.major_collections);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // an old object is remembered once, immediates and writes to young objects are not remembered
+    dang_gc_set_nursery_size(&de, 1024 * 1024 * 1024);
+
+    input = "push a b + '1'\n push a b + '2'\n push a 3\n let d [0]\n push d b + '4'\n push d 5\n len a";
+
+    ResEvaluated res = dang_eval(&de, input, false);
+    if (dc_is_err2(res) || !test_evaluated_literal(&dc_unwrap2(res).result, &do_int(5)) || de.gc.remembered.count != 1)
+    {
+        dc_log("expected a single remembered object, remembered=" dc_fmt(usize), de.gc.remembered.count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(string_builder)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    // no collection so every buffer that is ever made is still in the heap
+    dang_gc_set_nursery_size(&de, 1024 * 1024 * 1024);
+    dang_gc_set_threshold(&de, 1024 * 1024 * 1024);
+
+    string input = "let build fn(n, s) { if n == 0 { return s }\n build n - 1, s + 'ab' }\n len ${build 10000, ''}";
+
+    eval_test_or_fail(&de, input, do_int(20000));
+
+    // appending to the end of a buffer doesn't allocate, only growing it does
+    usize buffer_count = 0;
+    dc_da_for(count_buffers_loop, de.gc.nursery, {
+        if (_it->type == dc_dvt(DStringBufferPtr)) buffer_count++;
+    });
+
+    if (buffer_count > 20)
+    {
+        dc_log("expected the string to grow in place, buffers=" dc_fmt(usize), buffer_count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // strings sharing a buffer keep their own bytes
+    input = "let a 'x' + 'y'\n let b a + '1'\n let c a + '2'\n let d b + '3'\n [a, b, c, d, b == 'xy1', c + b]";
+
+    ResEvaluated res = dang_eval(&de, input, false);
+    if (dc_is_err2(res))
+    {
+        dc_log("failed on input '%s'", input);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    DCResString str_res = do_tostr(&dc_unwrap2(res).result);
+    if (dc_is_err2(str_res) || strcmp(dc_unwrap2(str_res), "[xy, xy1, xy2, xy13, true, xy2xy1]") != 0)
+    {
+        dc_log("got '%s'", dc_unwrap2(str_res));
+        if (dc_is_ok2(str_res)) dc_sfree(dc_unwrap2(str_res));
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dc_sfree(dc_unwrap2(str_res));
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(shared_array_storage)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    // no collection so every storage that is ever made is still in the heap
+    dang_gc_set_nursery_size(&de, 1024 * 1024 * 1024);
+    dang_gc_set_threshold(&de, 1024 * 1024 * 1024);
+
+    string input = "let build fn(n, a) { if n == 0 { return a }\n push a n\n build n - 1, a }\n"
+                   "let sum fn(a, s) { if ${len a} == 0 { return s }\n sum ${rest a}, s + ${first a} }\n"
+                   "sum ${build 10000, []}, 0";
+
+    eval_test_or_fail(&de, input, do_int(50005000));
+
+    // pushing to the end of the storage doesn't copy and rest never does
+    usize storage_count = 0;
+    dc_da_for(count_storages_loop, de.gc.nursery, {
+        if (_it->type == dc_dvt(DArrayStoragePtr)) storage_count++;
+    });
+
+    if (storage_count > 20)
+    {
+        dc_log("expected the arrays to share their storage, storages=" dc_fmt(usize), storage_count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // arrays sharing a storage keep their own elements
+    input = "let a [1, 2, 3]\n let b ${rest a}\n push b 4\n push a 5\n let c ${rest a}\n push c 6\n"
+            "[a, b, c, ${len b}, ${last a}]";
+
+    ResEvaluated res = dang_eval(&de, input, false);
+    if (dc_is_err2(res))
+    {
+        dc_log("failed on input '%s'", input);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    DCResString str_res = do_tostr(&dc_unwrap2(res).result);
+    if (dc_is_err2(str_res) || strcmp(dc_unwrap2(str_res), "[[1, 2, 3, 5], [2, 3, 4], [2, 3, 5, 6], 3, 5]") != 0)
+    {
+        dc_log("got '%s'", dc_unwrap2(str_res));
+        if (dc_is_ok2(str_res)) dc_sfree(dc_unwrap2(str_res));
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dc_sfree(dc_unwrap2(str_res));
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(string_hash_cache)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    // literals are interned with their hash
+    ResEvaluated res = dang_eval(&de, "'some key'", false);
+    CLOVE_IS_TRUE(dc_is_ok2(res) && dc_unwrap2(res).result.type == DO_STRING);
+
+    DoString literal = do_as_string(dc_unwrap2(res).result);
+    CLOVE_IS_TRUE(literal.buf && literal.buf->hash_len == literal.len);
+    CLOVE_UINT_EQ(dang_str_hash("some key", 8, 0), literal.buf->hash);
+
+    // runtime strings get their hash cached by the first lookup
+    string input = "let some 'some'\n let key some + ' key'\n let h {key: 1, 'other': 2}\n h['some key'] + h[key] + h['other']";
+
+    eval_test_or_fail(&de, input, do_int(4));
+
+    res = dang_eval(&de, "key", false);
+    CLOVE_IS_TRUE(dc_is_ok2(res) && dc_unwrap2(res).result.type == DO_STRING);
+
+    DoString key = do_as_string(dc_unwrap2(res).result);
+    CLOVE_IS_TRUE(key.buf && key.buf != literal.buf && key.buf->hash_len == key.len);
+    CLOVE_UINT_EQ(literal.buf->hash, key.buf->hash);
+
+    DCResBool eq_res = do_eq(&dc_unwrap2(res).result, &do_string("some key"));
+    CLOVE_IS_TRUE(dc_is_ok2(eq_res) && dc_unwrap2(eq_res));
+
+    eq_res = do_eq(&dc_unwrap2(res).result, &do_string("some kez"));
+    CLOVE_IS_TRUE(dc_is_ok2(eq_res) && !dc_unwrap2(eq_res));
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(hash_functions)
+{
+    // negative and positive integers don't collide and consecutive integers are spread over the low bits
+    usize rows[64] = {0};
+
+    for (i64 i = 1; i <= 4096; ++i)
+    {
+        CLOVE_IS_TRUE(dang_int_hash((u64)i, 0) != dang_int_hash((u64)-i, 0));
+
+        ++rows[dang_int_hash((u64)i, 0) & 63];
+    }
+
+    for (usize i = 0; i < 64; ++i)
+        CLOVE_IS_TRUE(rows[i] > 32 && rows[i] < 96);
+
+    // every length (including the word at a time paths) depends on every byte
+    char text[128];
+    memset(text, 'a', sizeof(text));
+
+    for (usize len = 1; len < sizeof(text); ++len)
+    {
+        u32 hash = dang_str_hash(text, len, 0);
+
+        CLOVE_IS_TRUE(hash != dang_str_hash(text, len - 1, 0));
+
+        for (usize i = 0; i < len; ++i)
+        {
+            text[i] = 'b';
+            CLOVE_IS_TRUE(hash != dang_str_hash(text, len, 0));
+            text[i] = 'a';
+        }
+    }
+
+    // the same text at an unaligned address has the same hash
+    memcpy(text + 3, "a longer key than 16 bytes", 26);
+    CLOVE_UINT_EQ(dang_str_hash("a longer key than 16 bytes", 26, 0), dang_str_hash(text + 3, 26, 0));
+
+    // the seed goes into the hashes, the keys that share a row with one seed are spread with another
+    usize shared = 0, still_shared = 0;
+    u64 seed = 0x9e3779b97f4a7c15ULL;
+
+    for (i64 i = 2; i <= 4096; ++i)
+    {
+        if ((dang_int_hash((u64)i, 0) & 255) != (dang_int_hash(1, 0) & 255)) continue;
+
+        ++shared;
+        if ((dang_int_hash((u64)i, seed) & 255) == (dang_int_hash(1, seed) & 255)) ++still_shared;
+    }
+
+    CLOVE_IS_TRUE(shared > 4 && still_shared < shared / 2);
+    CLOVE_IS_TRUE(dang_str_hash("some key", 8, seed) != dang_str_hash("some key", 8, 0));
+    CLOVE_IS_TRUE(dang_str_hash(text, 100, seed) != dang_str_hash(text, 100, 0));
+
+    // seeded hash tables find the same keys
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_evaluator_set_hash_seed(&de, 0x1234567890abcdefULL);
+
+    string input = "let h {'one': 1, 2: 2, 1: 3, true: 4, false: 5}\n"
+                   "h['one'] + h[2] * 10 + h[1] * 100 + h[true] * 1000 + h[false] * 10000";
+
+    eval_test_or_fail(&de, input, do_int(54321));
+
+    ResEvaluated res = dang_eval(&de, "h", false);
+    CLOVE_IS_TRUE(dc_is_ok2(res) && dc_unwrap2(res).result.type == DO_HASH_TABLE);
+
+    DCHashTablePtr ht = dc_dv_as(dc_unwrap2(res).result, DCHashTablePtr);
+    CLOVE_IS_TRUE(ht->seed == 0x1234567890abcdefULL);
+
+    // reseeding moves the pairs
+    DCResVoid reseed_res = dc_ht_reseed(ht, 42);
+    CLOVE_IS_TRUE(dc_is_ok2(reseed_res));
+
+    eval_test_or_fail(&de, "h['one'] + h[2] * 10 + h[1] * 100 + h[true] * 1000 + h[false] * 10000", do_int(54321));
+
+    // interned strings keep the hash they're interned with after the seeded lookups
+    res = dang_eval(&de, "'one'", false);
+    CLOVE_IS_TRUE(dc_is_ok2(res) && dc_unwrap2(res).result.type == DO_STRING);
+
+    DoString literal = do_as_string(dc_unwrap2(res).result);
+    CLOVE_IS_TRUE(literal.buf && literal.buf->hash_seed == 0);
+    CLOVE_UINT_EQ(dang_str_hash("one", 3, 0), literal.buf->hash);
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(memory_limit)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_memory_set_limit(&de, 4 * 1024 * 1024);
+
+    // a runaway script fails cleanly once it needs more than the limit
+    string input = "let build fn(n, a) { push a 'x' + n\n build n + 1, a }\n build 0, []";
+
+    ResEvaluated res = dang_eval(&de, input, false);
+    if (dc_is_ok2(res) || dc_err_code2(res) != dc_e_code(MEM) || dang_memory_peak(&de) > 4 * 1024 * 1024)
+    {
+        dc_log("expected out of memory, peak=" dc_fmt(usize), dang_memory_peak(&de));
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dc_result_free(&res);
+
+    // and the evaluator is still usable afterwards
+    input = "let a [1 2 3]\n len a";
+
+    eval_test_or_fail(&de, input, do_int(3));
+
+    if (dang_memory_current(&de) == 0 || dang_memory_peak(&de) < dang_memory_current(&de) ||
+        dang_memory_total(&de) < dang_memory_peak(&de))
+    {
+        dc_log("wrong counters, current=" dc_fmt(usize) " peak=" dc_fmt(usize) " total=" dc_fmt(usize),
+               dang_memory_current(&de), dang_memory_peak(&de), dang_memory_total(&de));
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // everything is released by the same allocator it's allocated with
+    dang_evaluator_free(&de);
+
+    if (dang_memory_current(&de) != 0)
+    {
+        dc_log("expected every byte to be released, current=" dc_fmt(usize), dang_memory_current(&de));
+        CLOVE_FAIL();
+        return;
+    }
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(memory_strings)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    usize current = dang_memory_current(&de);
+
+    // formatted strings and the keys of the hash tables are allocated by the allocator of the evaluator as well
+    DCAllocator previous = dang_memory_enter(&de);
+
+    string str = NULL;
+    dc_sprintf(&str, "%s", "formatted");
+    dc_sappend(&str, " " dc_fmt(usize), current);
+
+    DCDynVal* keys = NULL;
+    DCResUsize keys_res = dc_ht_keys(&de.builtins, &keys);
+
+    usize keys_size = dc_is_ok2(keys_res) ? (dc_unwrap2(keys_res) + 1) * sizeof(DCDynVal) : 0;
+    usize expected = strlen(str) + 1 + keys_size;
+    usize used = dang_memory_current(&de) - current;
+
+    dc_sfree(str);
+    if (keys) dc_dealloc(keys, keys_size);
+
+    dang_memory_leave(previous);
+
+    CLOVE_IS_TRUE(dc_is_ok2(keys_res));
+    CLOVE_UINT_EQ(expected, used);
+    CLOVE_UINT_EQ(current, dang_memory_current(&de));
+
+    dang_evaluator_free(&de);
+}
+
+CLOVE_TEST(frame_stack)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_gc_set_nursery_size(&de, 0);
+
+    // the frame stack is allocated by the calls that reach it
+    if (de.frames.chunks[0] != NULL || de.frames.slot_chunks[0] != NULL)
+    {
+        dc_log("expected the frame stack to be allocated lazily");
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // calls of functions without nested functions don't allocate anything, the function itself is boxed in its slot
+    ResEvaluated res = dang_eval(&de, "let fib fn(n) { if n < 2 { return n }\n return ${fib n - 1} + ${fib n - 2} }", false);
+    usize defined_count = de.gc.nursery.count + de.gc.objects.count;
+    dc_result_free(&res);
+
+    string input = "fib 15";
+
+    res = dang_eval(&de, input, false);
+    if (dc_is_err2(res) || !test_evaluated_literal(&dc_unwrap2(res).result, &do_int(610)) ||
+        de.gc.nursery.count + de.gc.objects.count != defined_count || de.frames.count != 0)
+    {
+        dc_log("failed on input '%s', objects=" dc_fmt(usize), input, de.gc.nursery.count + de.gc.objects.count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    if (de.frames.chunks[0] == NULL || de.frames.chunks[1] != NULL)
+    {
+        dc_log("expected a single chunk of frames for '%s'", input);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // deeper calls grow the frame stack in chunks, the frames below keep their place
+    res = dang_eval(&de, "let down fn(n) { if n == 0 { return 0 }\n return 1 + ${down n - 1} }", false);
+    defined_count = de.gc.nursery.count + de.gc.objects.count;
+    dc_result_free(&res);
+
+    input = "down 300";
+
+    res = dang_eval(&de, input, false);
+    if (dc_is_err2(res) || !test_evaluated_literal(&dc_unwrap2(res).result, &do_int(300)) ||
+        de.gc.nursery.count + de.gc.objects.count != defined_count || de.frames.count != 0 ||
+        de.frames.chunks[300 / DANG_FRAME_CHUNK_SIZE] == NULL)
+    {
+        dc_log("failed on input '%s', objects=" dc_fmt(usize), input, de.gc.nursery.count + de.gc.objects.count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_evaluator_free(&de);
+
+    init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_gc_set_nursery_size(&de, 0);
+
+    // the environment of 'mk' is promoted before 'a' is defined and captured by 'f'
+    input = "let o [0]\n let mk fn(n) { let f fn(x) { a[0] + x }\n push o f\n let a [n] }\n mk 5\n let t 1\n let k o[1]\n k 1";
+
+    eval_test_or_fail(&de, input, do_int(6));
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(temporaries_released)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_gc_set_nursery_size(&de, 0);
+
+    // builtin and tail calls don't allocate their arguments on the heap, the function itself is boxed in its slot
+    ResEvaluated res =
+        dang_eval(&de, "let count fn(n, acc) { if n == 0 { return acc }\n count n - 1, ${len 'ab'} + acc }", true);
+    usize defined_count = de.gc.nursery.count + de.gc.objects.count;
+    dc_result_free(&res);
+
+    string input = "count 100, 0";
+
+    res = dang_eval(&de, input, true);
+    if (dc_is_err2(res) || !test_evaluated_literal(&dc_unwrap2(res).result, &do_int(200)) ||
+        de.gc.nursery.count + de.gc.objects.count != defined_count || de.temp.scratch.count != 0)
+    {
+        dc_log("failed on input '%s', objects=" dc_fmt(usize), input, de.gc.nursery.count + de.gc.objects.count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // errors of an evaluation (parser errors and the arguments left behind) don't stick to the next ones
+    dc_result_free(&res);
+    res = dang_eval(&de, "let x [1 2 3]", false);
+    dc_result_free(&res);
+
+    string inputs[] = {"len x", "let y fn(", "${first x} + ${len 'abc', ${missing 1}}", "${last x} + 1", NULL};
+    b1 fails[] = {false, true, true, false};
+
+    for (usize i = 0; i < 1000; ++i)
+    {
+        usize idx = i % 4;
+
+        res = dang_eval(&de, inputs[idx], true);
+        if (dc_is_err2(res) != fails[idx])
+        {
+            dc_log("unexpected result on input '%s'", inputs[idx]);
+            if (dc_is_err2(res)) dc_err_log2(res, "error");
+            dang_evaluator_free(&de);
+            CLOVE_FAIL();
+            return;
+        }
+
+        dc_result_free(&res);
+    }
+
+    res = dang_eval(&de, "last x", false);
+    if (dc_is_err2(res) || !test_evaluated_literal(&dc_unwrap2(res).result, &do_int(3)) || de.temp.chunk_count != 1 ||
+        de.temp.scratch.count != 0 || de.errors.count != 0)
+    {
+        dc_log("temporaries are not released, chunks=" dc_fmt(usize), de.temp.chunk_count);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(program_released)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    dang_gc_set_nursery_size(&de, 0);
+
+    ResEvaluated res = dang_eval(&de, "let a [1 2 3]\n let twice fn(x) { x * 2 }", false);
+    dc_result_free(&res);
+
+    // the lines without function literals don't leave their program behind, so memory stays flat
+    string inputs[] = {"len a + ${first a}", "let b ${twice a[2]}", "if b > 1 { 'big' } else { 'small' }", "let c fn(", NULL};
+
+    usize warm_memory = 0;
+    usize warm_arena = 0;
+
+    for (usize i = 0; i < 1000; ++i)
+    {
+        res = dang_eval(&de, inputs[i % 4], false);
+        dc_result_free(&res);
+
+        if (i == 7)
+        {
+            warm_memory = dang_memory_current(&de);
+            warm_arena = de.arena.bytes_used;
+        }
+    }
+
+    if (dang_memory_current(&de) != warm_memory || de.arena.bytes_used != warm_arena)
+    {
+        dc_log("memory is not flat, current=" dc_fmt(usize) " (" dc_fmt(usize) ") arena=" dc_fmt(usize) " (" dc_fmt(usize) ")",
+               dang_memory_current(&de), warm_memory, de.arena.bytes_used, warm_arena);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    // the functions keep their program and the strings the interned literals they're made of
+    res = dang_eval(&de, "let d fn(x) { x + 1 }\n d b", false);
+    dc_result_free(&res);
+
+    res = dang_eval(&de, "let s 'big'", false);
+    dc_result_free(&res);
+
+    string input = "[${d 1} ${twice 4} b s]";
+
+    res = dang_eval(&de, input, false);
+    if (dc_is_err2(res))
+    {
+        dc_log("failed on input '%s'", input);
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    DCResString str_res = do_tostr(&dc_unwrap2(res).result);
+    if (dc_is_err2(str_res))
+    {
+        dang_evaluator_free(&de);
+        CLOVE_FAIL();
+        return;
+    }
+
+    CLOVE_STRING_EQ("[2, 8, 6, big]", dc_unwrap2(str_res));
+
+    dc_sfree(dc_unwrap2(str_res));
+    dang_evaluator_free(&de);
+}
+
+CLOVE_TEST(error_slot)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    // the error of a deeply nested call makes it to the result
+    string input = "let f fn(n) { if n == 0 { return 1 + true }\n return 1 + ${f n - 1} }\n f 200";
+
+    ResEvaluated res = dang_eval(&de, input, false);
+    CLOVE_IS_TRUE(dc_is_err2(res) && dc_err_code2(res) != 0 && dc_err_msg2(res) != NULL);
+    dc_result_free(&res);
+
+    CLOVE_IS_FALSE(de.failed);
+
+    // and the slot is clean for the next evaluations, including the builtins that report into it
+    input = "let s fn(n) { if n == 0 { return 0 }\n return n + ${s n - 1} }\n s 200";
+
+    eval_test_or_fail(&de, input, do_int(20100));
+
+    res = dang_eval(&de, "len 1", false);
+    CLOVE_IS_TRUE(dc_is_err2(res));
+    dc_result_free(&res);
+
+    eval_test_or_fail(&de, "len 'ab'", do_int(2));
+
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(division_errors)
+{
+    struct
+    {
+        string input;
+        string message;
+    } tests[] = {
+        {"5 / 0", "division by zero"},
+        {"let z 0\n 10 / z", "division by zero"},
+        {"let d fn(x) { 10 / x }\n d 0", "division by zero"},
+        {"let m -9223372036854775807 - 1\n let n 0 - 1\n m / n", "integer overflow in division"},
+    };
+
+    for (usize i = 0; i < dc_count(tests); ++i)
+    {
+        DEvaluator de;
+        DCResVoid init_res = dang_evaluator_init(&de);
+        if (dc_is_err2(init_res))
+        {
+            dc_err_log2(init_res, "Evaluator initialization error on input");
+            CLOVE_FAIL();
+            return;
+        }
+
+        ResEvaluated res = dang_eval(&de, tests[i].input, false);
+        if (dc_is_ok2(res) || strcmp(dc_err_msg2(res), tests[i].message) != 0)
+        {
+            dc_log("expected '%s' on input '%s'", tests[i].message, tests[i].input);
+            if (dc_is_err2(res)) dc_result_free(&res);
+            dang_evaluator_free(&de);
+            CLOVE_FAIL();
+            return;
+        }
+
+        dc_result_free(&res);
+
+        // the evaluator is still usable after the error
+        eval_test_or_fail(&de, "10 / 3", do_int(3));
+
+        dang_evaluator_free(&de);
+    }
+
+    CLOVE_PASS();
+}
+
 CLOVE_TEST(error_handling)
 {
     string error_tests[] = {
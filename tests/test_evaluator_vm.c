@@ -0,0 +1,193 @@
+// This target is compiled with DANG_DEFAULT_BACKEND_VM so the whole evaluator suite
+// runs against the bytecode compiler + vm instead of the tree walker
+#include "test_evaluator.c"
+
+static b1 evaluate_with_backend(DangBackend backend, string input, string* output)
+{
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        return false;
+    }
+
+    de.backend = backend;
+
+    ResEvaluated res = dang_eval(&de, input, false);
+    if (dc_is_err2(res))
+    {
+        dc_err_log2(res, "evaluation failed");
+        dang_parser_log_errors(&de.parser);
+        dang_evaluator_free(&de);
+        return false;
+    }
+
+    DCResString str_res = do_tostr(&dc_unwrap2(res).result);
+    *output = dc_is_ok2(str_res) ? dc_unwrap2(str_res) : NULL;
+
+    dang_evaluator_free(&de);
+
+    return *output != NULL;
+}
+
+/**
+ * Evaluates the input with both backends, the output of the vm is returned if they agree
+ */
+static b1 evaluate_with_both_backends(string input, string* output)
+{
+    string walker_output = NULL;
+    string vm_output = NULL;
+
+    if (!evaluate_with_backend(DANG_BACKEND_TREE_WALKER, input, &walker_output) ||
+        !evaluate_with_backend(DANG_BACKEND_VM, input, &vm_output))
+    {
+        dc_log("failed to evaluate '%s'", input);
+        dc_sfree(walker_output);
+        return false;
+    }
+
+    b1 agreed = strcmp(walker_output, vm_output) == 0;
+    if (!agreed) dc_log("backends disagree on '%s': tree walker='%s', vm='%s'", input, walker_output, vm_output);
+
+    dc_sfree(walker_output);
+
+    if (output && agreed)
+        *output = vm_output;
+    else
+        dc_sfree(vm_output);
+
+    return agreed;
+}
+
+CLOVE_TEST(backends_agree)
+{
+    string tests[] = {
+        "let a [1 2 3]; push a 4; a",
+
+        "let f fn(x) {\n if x > 1 { return x * 2 }\n x\n}\n[${f 1} ${f 2} ${f 3}]",
+
+        "let h {'a': 1, 2: 'two', true: [1 2]}; [h['a'] h[2] h[true][1] h['none']]",
+
+        "let c fn(x) { fn(y) { fn(z) { x + y + z } } }; let d ${c 1}; let e ${d 2}; e 3",
+
+        "'value: ' + ${len 'four'} + ' ' + (0 - 3)",
+
+        "rest, [1 2 3]",
+
+        NULL,
+    };
+
+    dc_foreach(backends_agree_loop, tests, string, {
+        if (!evaluate_with_both_backends(*_it, NULL))
+        {
+            dc_log("test #" dc_fmt(usize) " failed", _idx);
+            CLOVE_FAIL();
+            return;
+        }
+    });
+
+    // the jump over the branches and the constants of a program this long don't fit in 16 bits
+    usize program_cap = 32 * 20000;
+    string program = malloc(program_cap);
+    usize program_len = 0;
+
+    for (usize i = 0; i < 20000; ++i)
+        program_len += snprintf(program + program_len, program_cap - program_len, "let v" dc_fmt(usize) " " dc_fmt(usize) "\n",
+                                i, i);
+
+    snprintf(program + program_len, program_cap - program_len, "%s", "if v1 == 1 { 7 } else { 8 }");
+
+    string output = NULL;
+    b1 agreed = evaluate_with_both_backends(program, &output);
+
+    free(program);
+
+    if (!agreed)
+    {
+        CLOVE_FAIL();
+        return;
+    }
+
+    CLOVE_STRING_EQ("7", output);
+
+    dc_sfree(output);
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(fib_differential)
+{
+    string tests[] = {
+        "let fib fn(n) { if n < 2 { return n }\n return ${fib n - 1} + ${fib n - 2} }\n fib 20",
+
+        "6765",
+
+        "let fib fn(n) {\n let go fn(i, a, b) { if i == n { a } else { go (i + 1), b, (a + b) } }\n go 0, 0, 1\n}\n fib 50",
+
+        "12586269025",
+
+        "let seq [0 1]\n let grow fn(i) { if i < 30 { push seq (seq[i] + seq[i + 1])\n grow (i + 1) } }\n grow 0\n seq[30]",
+
+        "832040",
+
+        NULL,
+    };
+
+    for (usize i = 0; tests[i] != NULL; i += 2)
+    {
+        string output = NULL;
+
+        if (!evaluate_with_both_backends(tests[i], &output))
+        {
+            CLOVE_FAIL();
+            return;
+        }
+
+        if (strcmp(output, tests[i + 1]) != 0)
+        {
+            dc_log("expected '%s' got '%s' on '%s'", tests[i + 1], output, tests[i]);
+            dc_sfree(output);
+            CLOVE_FAIL();
+            return;
+        }
+
+        dc_sfree(output);
+    }
+
+    // a long program makes lots of nodes, they must keep their addresses while the program grows
+    string program = NULL;
+    dc_sappend(&program, "%s", "let fib fn(n) { if n < 2 { return n }\n return ${fib n - 1} + ${fib n - 2} }\nlet acc [0]\n");
+
+    i64 expected = 0;
+    i64 fibs[15] = {0, 1};
+    for (usize i = 2; i < 15; ++i)
+        fibs[i] = fibs[i - 1] + fibs[i - 2];
+
+    for (usize i = 0; i < 2000; ++i)
+    {
+        dc_sappend(&program, "push acc (acc[" dc_fmt(usize) "] + ${fib " dc_fmt(usize) "})\n", i, i % 15);
+        expected += fibs[i % 15];
+    }
+
+    dc_sappend(&program, "%s", "acc[2000]");
+
+    string output = NULL;
+    b1 agreed = evaluate_with_both_backends(program, &output);
+
+    dc_sfree(program);
+
+    if (!agreed)
+    {
+        CLOVE_FAIL();
+        return;
+    }
+
+    string expected_str = NULL;
+    dc_sappend(&expected_str, dc_fmt(i64), expected);
+
+    CLOVE_STRING_EQ(output, expected_str);
+
+    dc_sfree(expected_str);
+    dc_sfree(output);
+}
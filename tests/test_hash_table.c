@@ -0,0 +1,342 @@
+#define CLOVE_SUITE_NAME dang_hash_table_tests
+
+#include "clove-unit/clove-unit.h"
+
+#include "evaluator.h"
+
+static usize counted_allocations = 0;
+
+static voidptr counting_alloc(voidptr ctx, voidptr ptr, usize old_size, usize new_size)
+{
+    if (new_size > old_size) ++counted_allocations;
+
+    return dc_default_alloc(ctx, ptr, old_size, new_size);
+}
+
+static DC_HT_HASH_FN_DECL(test_int_hash)
+{
+    DC_RES_u32();
+
+    dc_ret_ok((u32)(dc_dv_as(*_key, i64) ^ (i64)_seed));
+}
+
+static DC_HT_KEY_CMP_FN_DECL(test_int_key_cmp)
+{
+    DC_RES_bool();
+
+    dc_ret_ok(dc_dv_as(*_key1, i64) == dc_dv_as(*_key2, i64));
+}
+
+CLOVE_TEST(hash_table_pairs)
+{
+    DCAllocator previous = dc_allocator_set((DCAllocator){.fn = counting_alloc, .ctx = NULL});
+
+    DCHashTable ht;
+    DCResVoid res = dc_ht_init(&ht, 17, test_int_hash, test_int_key_cmp, NULL);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    // pairs are stored in the entries, so the allocations are only for the growth of the entries and the index
+    for (i64 i = 0; i < 20000; ++i)
+    {
+        res = dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, i * 2), DC_HT_SET_CREATE_OR_UPDATE);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+    }
+
+    CLOVE_UINT_EQ(20000, ht.key_count);
+    CLOVE_IS_TRUE(counted_allocations < 500);
+
+    // updating and replacing deleted keys reuse the existing pairs
+    usize allocations = counted_allocations;
+
+    for (i64 i = 0; i < 1000; ++i)
+    {
+        res = dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, -i), DC_HT_SET_CREATE_OR_UPDATE);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+
+        DCResBool delete_res = dc_ht_delete(&ht, dc_dv(i64, 10000 + i));
+        CLOVE_IS_TRUE(dc_is_ok2(delete_res) && dc_unwrap2(delete_res));
+
+        res = dc_ht_set(&ht, dc_dv(i64, 20000 + i), dc_dv(i64, i), DC_HT_SET_CREATE_OR_FAIL);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+    }
+
+    CLOVE_UINT_EQ(allocations, counted_allocations);
+    CLOVE_UINT_EQ(20000, ht.key_count);
+
+    DCDynVal* found = NULL;
+
+    dc_ht_find_by_key(&ht, dc_dv(i64, 7), &found);
+    CLOVE_IS_TRUE(found && dc_dv_as(*found, i64) == -7);
+
+    dc_ht_find_by_key(&ht, dc_dv(i64, 10007), &found);
+    CLOVE_NULL(found);
+
+    dc_ht_find_by_key(&ht, dc_dv(i64, 20007), &found);
+    CLOVE_IS_TRUE(found && dc_dv_as(*found, i64) == 7);
+
+    dc_ht_find_by_key(&ht, dc_dv(i64, 19999), &found);
+    CLOVE_IS_TRUE(found && dc_dv_as(*found, i64) == 39998);
+
+    res = dc_ht_free(&ht);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    dc_allocator_set(previous);
+
+    // deleting from a NULL hash table fails like the other operations do
+    DCResBool delete_res = dc_ht_delete(NULL, dc_dv(i64, 7));
+    CLOVE_IS_TRUE(dc_is_err2(delete_res));
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(hash_table_growth)
+{
+    DCHashTable ht;
+    DCResVoid res = dc_ht_init(&ht, 17, test_int_hash, test_int_key_cmp, NULL);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    for (i64 i = 0; i < 100000; ++i)
+    {
+        res = dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, i), DC_HT_SET_CREATE_OR_FAIL);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+    }
+
+    // it grows by keeping 1/8 of the slots empty
+    CLOVE_UINT_EQ(100000, ht.key_count);
+    CLOVE_IS_TRUE(ht.cap >= 100000 + 100000 / 7 && ht.cap <= 4 * 100000);
+
+    DCDynVal* found = NULL;
+
+    for (i64 i = 0; i < 100000; ++i)
+    {
+        dc_ht_find_by_key(&ht, dc_dv(i64, i), &found);
+        CLOVE_IS_TRUE(found && dc_dv_as(*found, i64) == i);
+    }
+
+    // deleting and inserting new keys over and over reuses the tombstones and doesn't grow the hash table
+    usize cap = ht.cap;
+
+    for (i64 round = 0; round < 10; ++round)
+    {
+        for (i64 i = 0; i < 50000; ++i)
+        {
+            DCResBool delete_res = dc_ht_delete(&ht, dc_dv(i64, round * 50000 + i));
+            CLOVE_IS_TRUE(dc_is_ok2(delete_res) && dc_unwrap2(delete_res));
+
+            res = dc_ht_set(&ht, dc_dv(i64, 100000 + round * 50000 + i), dc_dv(i64, i), DC_HT_SET_CREATE_OR_FAIL);
+            CLOVE_IS_TRUE(dc_is_ok2(res));
+        }
+    }
+
+    CLOVE_UINT_EQ(100000, ht.key_count);
+    CLOVE_UINT_EQ(cap, ht.cap);
+
+    dc_ht_find_by_key(&ht, dc_dv(i64, 499999), &found);
+    CLOVE_NULL(found);
+
+    dc_ht_find_by_key(&ht, dc_dv(i64, 500000), &found);
+    CLOVE_IS_TRUE(found && dc_dv_as(*found, i64) == 0);
+
+    // iteration visits each pair once
+    usize count = 0;
+    i64 sum = 0;
+
+    dc_ht_for(count_loop, ht, {
+        ++count;
+        sum += dc_dv_as(_it->first, i64);
+    });
+
+    CLOVE_UINT_EQ(100000, count);
+    CLOVE_IS_TRUE(sum == (i64)(500000 + 599999) * 50000);
+
+    res = dc_ht_free(&ht);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    CLOVE_PASS();
+}
+
+static usize counted_hashes = 0;
+
+static DC_HT_HASH_FN_DECL(counting_int_hash)
+{
+    ++counted_hashes;
+
+    return test_int_hash(_key, _seed);
+}
+
+CLOVE_TEST(hash_table_entry)
+{
+    DCHashTable ht;
+    DCResVoid res = dc_ht_init(&ht, 0, counting_int_hash, test_int_key_cmp, NULL);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    counted_hashes = 0;
+
+    // inserting a new key hashes it once, the entries keep their hashes so growing doesn't hash them again
+    for (i64 i = 0; i < 1000; ++i)
+    {
+        DCPairPtr entry = NULL;
+
+        DCResBool entry_res = dc_ht_entry(&ht, dc_dv(i64, i), &entry);
+        CLOVE_IS_TRUE(dc_is_ok2(entry_res) && dc_unwrap2(entry_res));
+        CLOVE_IS_TRUE(dc_dv_is_null(entry->second));
+
+        entry->second = dc_dv(i64, i * 2);
+    }
+
+    CLOVE_UINT_EQ(1000, counted_hashes);
+    counted_hashes = 0;
+
+    // existing pairs are given back without inserting
+    for (i64 i = 0; i < 1000; ++i)
+    {
+        DCPairPtr entry = NULL;
+
+        DCResBool entry_res = dc_ht_entry(&ht, dc_dv(i64, i), &entry);
+        CLOVE_IS_TRUE(dc_is_ok2(entry_res) && !dc_unwrap2(entry_res));
+        CLOVE_IS_TRUE(dc_dv_as(entry->first, i64) == i && dc_dv_as(entry->second, i64) == i * 2);
+
+        res = dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, i * 3), DC_HT_SET_CREATE_OR_UPDATE);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+    }
+
+    CLOVE_UINT_EQ(2000, counted_hashes);
+    CLOVE_UINT_EQ(1000, ht.key_count);
+
+    DCDynVal* found = NULL;
+    dc_ht_find_by_key(&ht, dc_dv(i64, 999), &found);
+    CLOVE_IS_TRUE(found && dc_dv_as(*found, i64) == 2997);
+
+    res = dc_ht_free(&ht);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    CLOVE_PASS();
+}
+
+static DC_HT_HASH_FN_DECL(picky_int_hash)
+{
+    DC_RES_u32();
+
+    if (_seed == 13 && dc_dv_as(*_key, i64) == 500) dc_ret_e(-1, "cannot hash the key with this seed");
+
+    return counting_int_hash(_key, _seed);
+}
+
+CLOVE_TEST(hash_table_reseed)
+{
+    DCHashTable ht;
+    DCResVoid res = dc_ht_init(&ht, 0, picky_int_hash, test_int_key_cmp, NULL);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    for (i64 i = 0; i < 1000; ++i)
+    {
+        res = dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, i * 3), DC_HT_SET_CREATE_OR_FAIL);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+    }
+
+    // the keys are hashed again with the new seed
+    counted_hashes = 0;
+
+    res = dc_ht_reseed(&ht, 42);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+    CLOVE_UINT_EQ(1000, counted_hashes);
+    CLOVE_IS_TRUE(ht.entries[7].hash == (u32)(7 ^ 42));
+
+    // a key that can't be hashed with the new seed leaves the hash table as it was
+    res = dc_ht_reseed(&ht, 13);
+    CLOVE_IS_TRUE(dc_is_err2(res));
+    CLOVE_IS_TRUE(ht.seed == 42 && ht.entries[7].hash == (u32)(7 ^ 42));
+
+    DCDynVal* found = NULL;
+
+    for (i64 i = 0; i < 1000; ++i)
+    {
+        dc_ht_find_by_key(&ht, dc_dv(i64, i), &found);
+        CLOVE_IS_TRUE(found && dc_dv_as(*found, i64) == i * 3);
+    }
+
+    res = dc_ht_free(&ht);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    CLOVE_PASS();
+}
+
+CLOVE_TEST(hash_table_order)
+{
+    DCHashTable ht;
+    DCResVoid res = dc_ht_init(&ht, 0, test_int_hash, test_int_key_cmp, NULL);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    // keys in descending order, then every third one is deleted
+    for (i64 i = 3000; i > 0; --i)
+    {
+        res = dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, i), DC_HT_SET_CREATE_OR_FAIL);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+    }
+
+    for (i64 i = 3; i <= 3000; i += 3)
+    {
+        DCResBool delete_res = dc_ht_delete(&ht, dc_dv(i64, i));
+        CLOVE_IS_TRUE(dc_is_ok2(delete_res) && dc_unwrap2(delete_res));
+    }
+
+    // updated pairs keep their place
+    res = dc_ht_set(&ht, dc_dv(i64, 2999), dc_dv(i64, 0), DC_HT_SET_CREATE_OR_UPDATE);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    // deleted keys that are inserted again go to the end, even after the index is rebuilt
+    for (i64 i = 3; i <= 3000; i += 3)
+    {
+        res = dc_ht_set(&ht, dc_dv(i64, i), dc_dv(i64, i), DC_HT_SET_CREATE_OR_FAIL);
+        CLOVE_IS_TRUE(dc_is_ok2(res));
+    }
+
+    CLOVE_UINT_EQ(3000, ht.key_count);
+
+    i64 expected[3000];
+    usize count = 0;
+
+    for (i64 i = 3000; i > 0; --i)
+        if (i % 3 != 0) expected[count++] = i;
+
+    for (i64 i = 3; i <= 3000; i += 3)
+        expected[count++] = i;
+
+    count = 0;
+    b1 in_order = true;
+
+    dc_ht_for(order_loop, ht, {
+        if (dc_dv_as(_it->first, i64) != expected[count]) in_order = false;
+        ++count;
+    });
+
+    CLOVE_UINT_EQ(3000, count);
+    CLOVE_IS_TRUE(in_order);
+
+    CLOVE_IS_TRUE(dc_dv_as(ht.entries[0].pair.first, i64) == 2999 && dc_dv_as(ht.entries[0].pair.second, i64) == 0);
+
+    res = dc_ht_free(&ht);
+    CLOVE_IS_TRUE(dc_is_ok2(res));
+
+    // hash table objects are printed in the order of the pairs in the literal
+    DEvaluator de;
+    DCResVoid init_res = dang_evaluator_init(&de);
+    if (dc_is_err2(init_res))
+    {
+        dc_err_log2(init_res, "Evaluator initialization error on input");
+        CLOVE_FAIL();
+        return;
+    }
+
+    ResEvaluated eval_res = dang_eval(&de, "{'b': 1, 'a': 2, 3: 3, true: 4, 'b': 5}", false);
+    CLOVE_IS_TRUE(dc_is_ok2(eval_res));
+
+    DCResString str_res = do_tostr(&dc_unwrap2(eval_res).result);
+    CLOVE_IS_TRUE(dc_is_ok2(str_res));
+    CLOVE_STRING_EQ("{(b, 5), (a, 2), (3, 3), (true, 4)}", dc_unwrap2(str_res));
+
+    dc_sfree(dc_unwrap2(str_res));
+    dang_evaluator_free(&de);
+
+    CLOVE_PASS();
+}
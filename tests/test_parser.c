@@ -6,19 +6,19 @@
 #include "parser.h"
 #include "scanner.h"
 
-static DCDynArr pool;
+static DArena arena;
 static DCDynArr errors;
 
 static DParser parser;
 
 CLOVE_SUITE_SETUP()
 {
-    pool = (DCDynArr){0};
+    arena = (DArena){0};
     errors = (DCDynArr){0};
 
     parser = (DParser){0};
 
-    DCResVoid res = dang_parser_init(&parser, &pool, &errors);
+    DCResVoid res = dang_parser_init(&parser, &arena, &errors);
     if (dc_is_err2(res))
     {
         dc_log("parser initialization error on input");
@@ -31,7 +31,7 @@ CLOVE_SUITE_SETUP()
 
 CLOVE_SUITE_TEARDOWN()
 {
-    dc_da_free(&pool);
+    dang_arena_free(&arena);
     dc_da_free(&errors);
 }
 
@@ -337,3 +337,53 @@ CLOVE_TEST(expressions)
 
     CLOVE_PASS();
 }
+
+CLOVE_TEST(interning)
+{
+    char text[] = "count + total";
+
+    DCResString first = dang_arena_intern(&arena, dc_sv(text, 0, 5));
+    DCResString second = dang_arena_intern(&arena, dc_sv("count", 0, 5));
+    DCResString other = dang_arena_intern(&arena, dc_sv(text, 8, 5));
+
+    CLOVE_IS_TRUE(dc_is_ok2(first) && dc_is_ok2(second) && dc_is_ok2(other));
+    CLOVE_PTR_EQ(dc_unwrap2(first), dc_unwrap2(second));
+    CLOVE_PTR_NE(dc_unwrap2(first), dc_unwrap2(other));
+    CLOVE_STRING_EQ("total", dc_unwrap2(other));
+    CLOVE_UINT_EQ(dang_symbol_hash("count"), dang_symbol_of(dc_unwrap2(first))->hash);
+
+    // the set grows while the strings keep their addresses
+    string names[1000] = {0};
+    char name[16];
+
+    for (usize i = 0; i < dc_count(names); ++i)
+    {
+        usize len = (usize)snprintf(name, sizeof(name), "name_" dc_fmt(usize), i);
+        names[i] = dc_unwrap2(dang_arena_intern(&arena, dc_sv(name, 0, len)));
+    }
+
+    for (usize i = 0; i < dc_count(names); ++i)
+    {
+        usize len = (usize)snprintf(name, sizeof(name), "name_" dc_fmt(usize), i);
+        if (names[i] != dc_unwrap2(dang_arena_intern(&arena, dc_sv(name, 0, len))))
+        {
+            dc_log("'%s' is interned twice", name);
+            CLOVE_FAIL();
+
+            return;
+        }
+    }
+
+    // reusing the same names and strings doesn't add new symbols
+    usize symbol_count = arena.symbol_count;
+
+    string source = NULL;
+    for (usize i = 0; i < 500; ++i)
+        dc_sappend(&source, "%s", "count + total * ${len 'count'}\n");
+
+    ResDNodeProgram program_res = dang_parse(&parser, source);
+    dc_sfree(source);
+
+    CLOVE_IS_TRUE(dc_is_ok2(program_res) && dang_parser_has_no_error(&parser));
+    CLOVE_UINT_EQ(symbol_count + 1, arena.symbol_count);
+}